@@ -0,0 +1,111 @@
+#
+# Search index over the names of the VTK classes and of their properties.
+#
+# Names are kept sorted case-insensitively, so that prefix lookups are two
+# bisections, and every sequence of three characters maps to the names holding
+# it, so that substring lookups only check the names sharing the rarest
+# trigram of the query. Property names map to the classes having them. The
+# index is built once with the class tree and saved next to it, keyed by the
+# VTK version it was built from.
+#
+
+import bisect
+import json
+
+indexVersion = 1
+
+
+def _trigrams(text):
+    return set(text[i:i + 3] for i in range(len(text) - 2))
+
+
+class ClassIndex():
+    def __init__(self, classProperties, vtkVersion=""):
+        # classProperties maps every class name to its property names.
+        self.vtkVersion = vtkVersion
+        self.classProperties = classProperties
+
+        self.names = sorted(classProperties, key=str.lower)
+        self.lowerNames = [name.lower() for name in self.names]
+
+        self.trigrams = {}
+        self.classesByProperty = {}
+        for i, name in enumerate(self.names):
+            for trigram in _trigrams(self.lowerNames[i]):
+                self.trigrams.setdefault(trigram, []).append(i)
+            for propertyName in classProperties[name]:
+                self.classesByProperty.setdefault(propertyName.lower(), []).append(i)
+
+    @staticmethod
+    def fromTree(nameToTreeObject, vtkVersion):
+        classProperties = {}
+        for className, treeObject in nameToTreeObject.items():
+            classProperties[className] = treeObject.getPropertyNames()
+
+        return ClassIndex(classProperties, vtkVersion)
+
+    @staticmethod
+    def load(filename, vtkVersion):
+        # Returns the saved index, or None if there is none for this version
+        # of VTK.
+        try:
+            with open(filename, "r") as fp:
+                saved = json.load(fp)
+        except (IOError, ValueError, TypeError):
+            return None
+
+        if (not isinstance(saved, dict) or saved.get("version") != indexVersion
+                or saved.get("vtkVersion") != vtkVersion):
+            return None
+
+        return ClassIndex(saved["classes"], vtkVersion)
+
+    def save(self, filename):
+        try:
+            with open(filename, "w") as fp:
+                json.dump({"version": indexVersion, "vtkVersion": self.vtkVersion,
+                    "classes": self.classProperties}, fp, indent=0, sort_keys=True)
+        except IOError:
+            print("Can not write class index", filename)
+
+    def __len__(self):
+        return len(self.names)
+
+    def prefix(self, text, limit=0):
+        # Classes whose name starts with text, ignoring case.
+        text = text.lower()
+        first = bisect.bisect_left(self.lowerNames, text)
+        last = first
+        while last < len(self.lowerNames) and self.lowerNames[last].startswith(text):
+            last += 1
+            if limit and last - first >= limit:
+                break
+
+        return self.names[first:last]
+
+    def substring(self, text, limit=0):
+        # Classes whose name contains text, ignoring case, in name order.
+        text = text.lower()
+        if len(text) < 3:
+            candidates = range(len(self.names))
+        else:
+            postings = [self.trigrams.get(trigram, []) for trigram in _trigrams(text)]
+            candidates = min(postings, key=len)
+
+        return self._select((i for i in candidates if text in self.lowerNames[i]), limit)
+
+    def havingProperty(self, propertyName, limit=0):
+        # Classes having a property of that name, ignoring case.
+        return self._select(self.classesByProperty.get(propertyName.lower(), []), limit)
+
+    def getProperties(self, className):
+        return self.classProperties.get(className, [])
+
+    def _select(self, indices, limit):
+        result = []
+        for i in indices:
+            result.append(self.names[i])
+            if limit and len(result) >= limit:
+                break
+
+        return result
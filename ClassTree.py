@@ -4,15 +4,17 @@
 # Date: 08-06-2016
 #
 
-from vtk import *
+import vtkLoader
 from PipelineObject import *
 from TreeObject import *
+from ClassIndex import ClassIndex
 from copy import deepcopy
 import json
 
 # A class that creates a classtree of VTK.
 class ClassTree():
-    def __init__(self, eo, categoriesFilename=None, categoriesMappingFilename=None):
+    def __init__(self, eo, categoriesFilename=None, categoriesMappingFilename=None,
+            indexFilename=None):
         if eo == None:
             raise TypeError("error observer cannot be None")
             return
@@ -20,12 +22,23 @@ class ClassTree():
         self.pipeline = None
         self.categoriesFilename = categoriesFilename
         self.categoriesMappingFilename = categoriesMappingFilename
+        self.indexFilename = indexFilename
         self.eo = eo
 
-        self.root = TreeObject(vtkAlgorithm, eo)
-
         self.categories = self._loadCategories()
         self.categoriesMapping = self._loadCategoriesMapping()
+
+        # With lazy imports the tree is not built, as that would need all of
+        # VTK: classes are added one by one as they are asked for, and the
+        # categories are left empty.
+        if vtkLoader.lazy:
+            self.root = None
+            self.selection = self._loadSelection(deepcopy(self.categories))
+            self.nameToTreeObject = {}
+            self.index = self._loadIndex()
+            return
+
+        self.root = TreeObject(vtkLoader.getClass("vtkAlgorithm"), eo)
         
         self.categories = self.root.setCategories(self.categories,
             self.categoriesMapping)
@@ -33,6 +46,7 @@ class ClassTree():
         self.selection = self._loadSelection(deepcopy(self.categories))
         
         self.nameToTreeObject = self.root.createHashTable({})
+        self.index = self._loadIndex()
 
     def setPipeline(self, pipeline):
         if pipeline == None:
@@ -52,8 +66,53 @@ class ClassTree():
         try:
             return self.nameToTreeObject[className]
         except KeyError:
+            if not vtkLoader.lazy:
+                return None
+
+        # Lazy imports: load the class and add it on its own.
+        classType = vtkLoader.getClass(className)
+        if classType == None:
             return None
 
+        treeObject = TreeObject(classType, self.eo, withSubclasses=False)
+        self.nameToTreeObject[className] = treeObject
+        return treeObject
+
+    def _loadIndex(self):
+        # Load the class index saved for this version of VTK, or build it from
+        # the tree and save it. Without the tree, an index of the class names
+        # alone is made from the class map of the lazy imports.
+        vtkVersion = vtkLoader.getClass("vtkVersion").GetVTKVersion()
+        index = None
+        if self.indexFilename != None:
+            index = ClassIndex.load(self.indexFilename, vtkVersion)
+
+        if self.root == None:
+            if index == None:
+                index = ClassIndex(dict((className, []) for className in
+                    vtkLoader.classModules), vtkVersion)
+            return index
+
+        if index == None or len(index) != len(self.nameToTreeObject):
+            index = ClassIndex.fromTree(self.nameToTreeObject, vtkVersion)
+            if self.indexFilename != None:
+                index.save(self.indexFilename)
+
+        return index
+
+    def findClassNames(self, query, mode="prefix", limit=0):
+        # Class names starting with ("prefix") or containing ("substring") the
+        # query, or of the classes having a property of that name
+        # ("property"). A limit of 0 returns all of them.
+        if mode == "prefix":
+            return self.index.prefix(query, limit)
+        elif mode == "substring":
+            return self.index.substring(query, limit)
+        elif mode == "property":
+            return self.index.havingProperty(query, limit)
+
+        raise ValueError("unknown search mode " + str(mode))
+
     def _loadCategories(self):
         # Load the categories to use.
 
@@ -254,19 +313,20 @@ class ClassTree():
 
         # Filter accepting classes
         if prevNode != None:
-            # Reset error handler/observer
-            self.eo.ErrorOccurred()
-
-            # Use 'real' previous node (not a dummy) to ensure first part of
-            # pipeline is 'valid'. Otherwise missing input connections could
-            # cause unwanted vtk errors.
-            outputPort = prevNode.vtkInstanceCall("GetOutputPort")
-            prevNodeTypeName = type(prevNode.vtkInstance).__name__
-
-            # If there is a previous node, but is has no output port, nothing
-            # else can be added.
-            if self.eo.ErrorOccurred():
-                return []
+            with self.eo.watching():
+                # Reset error handler/observer
+                self.eo.ErrorOccurred()
+
+                # Use 'real' previous node (not a dummy) to ensure first part of
+                # pipeline is 'valid'. Otherwise missing input connections could
+                # cause unwanted vtk errors.
+                outputPort = prevNode.vtkInstanceCall("GetOutputPort")
+                prevNodeTypeName = type(prevNode.vtkInstance).__name__
+
+                # If there is a previous node, but is has no output port, nothing
+                # else can be added.
+                if self.eo.ErrorOccurred():
+                    return []
 
         else:
             outputPort = None
@@ -1,4 +1,4 @@
-from vtk import *
+import contextlib
 
 class ErrorObserver:
     # Catches VTK errors and saves them until a new error occures.
@@ -9,12 +9,40 @@ class ErrorObserver:
     def __init__(self):
         self.__ErrorOccurred = False
         self.__ErrorMessage = None
+        self.__OutputWindow = None
+        self.__Tags = []
         self.CallDataType = 'string0'
 
     def __call__(self, obj, event, message):
         self.__ErrorOccurred = True
         self.__ErrorMessage = message
 
+    # Observes the errors and warnings of an output window. When 'always' is
+    # False the observer is only attached inside 'watching', so events of the
+    # rest of the run go to the output window alone.
+    def observe(self, outputWindow, always=True):
+        self.__OutputWindow = outputWindow
+        if always:
+            self.__attach()
+
+    def __attach(self):
+        ow = self.__OutputWindow
+        self.__Tags = [ow.AddObserver('ErrorEvent', self),
+            ow.AddObserver('WarningEvent', self)]
+
+    @contextlib.contextmanager
+    def watching(self):
+        attach = self.__OutputWindow != None and not self.__Tags
+        if attach:
+            self.__attach()
+        try:
+            yield self
+        finally:
+            if attach:
+                for tag in self.__Tags:
+                    self.__OutputWindow.RemoveObserver(tag)
+                self.__Tags = []
+
     # These two functions are for manual checking if an error has occured.
     def ErrorOccurred(self):
         occ = self.__ErrorOccurred
@@ -22,4 +50,4 @@ class ErrorObserver:
         return occ
 
     def ErrorMessage(self):
-        return self.__ErrorMessage
\ No newline at end of file
+        return self.__ErrorMessage
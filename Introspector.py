@@ -1,5 +1,5 @@
 from ErrorObserver import *
-from vtk import *
+from vtkLoader import vtkOutputWindow, vtkFileOutputWindow
 from Pipeline import *
 import ctypes
 import collections
@@ -9,25 +9,36 @@ import time
 
 class Introspector:
 
-	def setupGlobalWarningHandling(self):
-		# Redirect output to a file.
-		ow = vtkFileOutputWindow()
-		ow.SetFileName("log/vtk_errors.txt")
-		vtkOutputWindow.SetInstance(ow)
+	def setupGlobalWarningHandling(self, logToFile=True):
+		if logToFile:
+			# Redirect output to a file.
+			ow = vtkFileOutputWindow()
+			ow.SetFileName("log/vtk_errors.txt")
+			vtkOutputWindow.SetInstance(ow)
+		else:
+			# The embedding application has installed its own output window,
+			# which records errors without writing them out synchronously.
+			ow = vtkOutputWindow.GetInstance()
 
-		# And catch errors in the errorObserver.
+		# And catch errors in the errorObserver. The embedding output window
+		# keeps its own ring of errors, so the observer is only attached while
+		# the class tree checks for them.
 		self.eo = ErrorObserver()
-		ow.AddObserver('ErrorEvent', self.eo)
-		ow.AddObserver('WarningEvent', self.eo)
+		self.eo.observe(ow, always=logToFile)
+
+
+	def __init__(self, logToFile=True):
+		self.setupGlobalWarningHandling(logToFile)
+		self.classTree = ClassTree(self.eo, "categories.txt", "categoriesMapping.txt",
+			"classIndex.json")
 
 
-	def __init__(self):
-		self.setupGlobalWarningHandling()
-		self.classTree = ClassTree(self.eo, "categories.txt", "categoriesMapping.txt")
+	def findVtkClasses(self, query, mode, limit):
+		return self.classTree.findClassNames(query, mode, limit)
 
 
-	def getVtkObjectOutputPort(self, node):
-		return node.vtkInstanceCall('GetOutputPort')
+	def getVtkObjectOutputPort(self, node, port=0):
+		return node.vtkInstanceCall('GetOutputPort', port)
 
 
 	def updateVtkObject(self, node):
@@ -43,6 +54,15 @@ class Introspector:
 		return self.classTree.getTreeObjectByName(objectName).createNode()
 
 
+	def cloneVtkObject(self, node):
+		# Creates an unregistered node of the same class carrying the same
+		# attribute values. Used by the C++ layer for per-worker pipeline copies.
+		className = type(node.vtkInstance).__name__
+		clone = self.classTree.getTreeObjectByName(className).createNode()
+		clone.copyAttributesFrom(node)
+		return clone
+
+
 	# TODO LOW: move to the TreeObject class
 	def getVtkObjectDescriptor(self, node):
 		cls = node.vtkInstance.__class__
@@ -74,31 +94,162 @@ class Introspector:
 		return str(node.vtkInstanceCall("Get" + attribute))
 
 
-	def setVtkObjectAttribute(self, node, attribute, newValue):
+	def setVtkObjectAttribute(self, node, attribute, format, newValue):
+		self.setVtkObjectValue(node, attribute, decodeValue(format, newValue))
+
+
+	def setVtkObjectValue(self, node, attribute, value):
+		# Sets an attribute to a value already decoded, as the typed calls of
+		# the C++ layer pass it.
 		methodName = "Set" + attribute
-		valueType, value = newValue.split("::", 1)
-		if valueType == "int":
-			node.callSetValueIntMethod(methodName, int(value))
-			print(node.vtkInstanceCall("Get" + attribute))
-		elif valueType == "dbl":
-			node.callSetValueFloatMethod(methodName, float(value))
-		elif valueType == "str":
+		if isinstance(value, bool):
+			node.vtkInstanceCall(methodName, value)
+		elif isinstance(value, int):
+			node.callSetValueIntMethod(methodName, value)
+		elif isinstance(value, float):
+			node.callSetValueFloatMethod(methodName, value)
+		elif isinstance(value, str):
 			node.callSetValueStringMethod(methodName, value)
-		elif valueType == "bool":
-			node.vtkInstanceCall(methodName, bool(value))
-		elif valueType == "dbl3":
-			v1, v2, v3 = value.split(",", 2)
-			node.vtkInstanceCall(methodName, (float(v1), float(v2), float(v3)))
 		else:
-			print("not recognised type", valueType, "with value", value)
+			node.vtkInstanceCall(methodName, value)
+
 
+	def setVtkObjectAttributes(self, writes):
+		# Applies a batch of (node, attribute, format, value) writes coalesced by
+		# the C++ layer. Every write is attempted; the first failure is raised
+		# once the batch is done.
+		error = None
+		for write in writes:
+			if write is None:
+				continue
+			try:
+				self.setVtkObjectAttribute(*write)
+			except Exception as e:
+				if error is None:
+					error = e
+		if error is not None:
+			raise error
+
+
+	def getVtkObjectSnapshot(self, nodes, attributes):
+		# Returns an (index, attribute, value) triple per attribute of each
+		# node, index being the position of the node. Without attributes, all
+		# of those the node lists are read. Values that cannot be read are None.
+		values = []
+		for index, node in enumerate(nodes):
+			if attributes:
+				for attribute in attributes:
+					values.append((index, attribute, self._readAttribute(node, attribute)))
+				continue
+
+			for setValueMethod in node.setValueMethods:
+				values.append((index, setValueMethod[3:], self._readAttribute(node, setValueMethod[3:])))
+
+			for attributeName in node.onOffMethods:
+				value = self._readAttribute(node, attributeName)
+				values.append((index, attributeName, bool(value) if value != None else None))
+
+			for attributeName in node.setToMethods:
+				values.append((index, attributeName, self._readAttribute(node, attributeName)))
+
+		return values
+
+
+	def _readAttribute(self, node, attribute):
+		try:
+			if "Set" + attribute in node.setValueMethods:
+				return node.getCurrentValue("Set" + attribute)[1]
+			return node.vtkInstanceCall("Get" + attribute)
+		except Exception:
+			return None
+
+
+	def getVtkObjectState(self, node):
+		# Returns the (method, format, value) calls that take a new node of the
+		# same class to the state of this one. Calls without a format take no
+		# value. Only the attributes that differ from the defaults are included.
+		className = type(node.vtkInstance).__name__
+		default = self.classTree.getTreeObjectByName(className).getDefaultNode()
+
+		calls = []
+		for setValueMethod in node.setValueMethods:
+			_, value = node.getCurrentValue(setValueMethod)
+			if value != default.getCurrentValue(setValueMethod)[1] and type(value) in valueFormats:
+				calls.append((setValueMethod, valueFormats[type(value)], str(value)))
+
+		for attributeName, (getMethod, _) in node.onOffMethods.items():
+			value = node.vtkInstanceCall(getMethod)
+			if value != default.vtkInstanceCall(getMethod):
+				calls.append((attributeName + ("On" if value else "Off"), "", ""))
+
+		# Set*To* attributes share a plain setter taking the current value.
+		for attributeName, info in node.setToMethods.items():
+			value = node.vtkInstanceCall(info["getMethod"])
+			if value != default.vtkInstanceCall(info["getMethod"]) and type(value) in valueFormats:
+				calls.append(("Set" + attributeName, valueFormats[type(value)], str(value)))
+
+		# Tuple attributes go through their setter with the whole tuple, integer
+		# ones keeping their type.
+		for setMethod, getMethod in node.tupleMethods.items():
+			value = tuple(node.vtkInstanceCall(getMethod))
+			if value != tuple(default.vtkInstanceCall(getMethod)):
+				format = "f" if any(type(v) == float for v in value) else "d"
+				calls.append((setMethod, "%s%d" % (format, len(value)), str(value)))
+
+		return calls
+
+
+	def getVtkObjectStates(self, nodes):
+		return [(type(node.vtkInstance).__name__, self.getVtkObjectState(node)) for node in nodes]
+
+
+	def restoreVtkObjects(self, states):
+		# Creates a node for each (className, calls) state saved by the C++ layer
+		# and applies its calls. Every call is attempted; the failures are
+		# returned next to the nodes as (index, method, message), a node that
+		# could not be created being None.
+		nodes = []
+		errors = []
+		for index, (className, calls) in enumerate(states):
+			try:
+				node = self.createVtkObject(className)
+			except Exception as e:
+				nodes.append(None)
+				errors.append((index, "createVtkObject", str(e)))
+				continue
+			for method, format, value in calls:
+				try:
+					if format:
+						self.setVtkObjectAttribute(node, method[3:], format, value)
+					else:
+						node.vtkInstanceCall(method)
+				except Exception as e:
+					errors.append((index, method, str(e)))
+			nodes.append(node)
+		return nodes, errors
 
-	def vtkInstanceCall(self, node, methodName, *args, **kwargs):
-		return node.vtkInstanceCall(methodName, *args, **kwargs)
 
+	def vtkInstanceCall(self, node, methodName, args=()):
+		return node.vtkInstanceCall(methodName, *args)
 
-	def deleteVtkObject(self, node):
-		del node
+
+	def genericCall(self, obj, methodName, args=()):
+		# Used for the links of piped calls after the first, which are called on
+		# plain VTK objects rather than on nodes.
+		return getattr(obj, methodName)(*args)
+
+
+	def deleteVtkObject(self, node, connected=False):
+		# The node goes back to the pool of its class if it has room, unless
+		# other nodes are still connected to its outputs.
+		if connected:
+			return
+		className = type(node.vtkInstance).__name__
+		self.classTree.getTreeObjectByName(className).releaseNode(node)
+
+
+	def setPoolSize(self, className, size):
+		self.classTree.getTreeObjectByName(className).setPoolSize(size)
 
 
 def type2name(t):
@@ -114,6 +265,21 @@ def type2name(t):
 		return None
 
 
+# Formats the values of a saved session are encoded with, as decoded below.
+valueFormats = {int: "d", float: "f", str: "s"}
+
+
+def decodeValue(format, value):
+	# Decodes a value sent by the C++ layer. The format uses the same characters
+	# as the argument formats there (s, d, f, b), optionally followed by the size
+	# of the tuple, whose items are separated by commas.
+	cast = {"s": str, "d": int, "f": float, "b": lambda v: bool(int(v))}[format[0].lower()]
+	size = int(format[1:]) if len(format) > 1 else 0
+	if size == 0:
+		return cast(value)
+	return tuple(cast(v.strip()) for v in value.strip("()[] ").split(",", size - 1))
+
+
 def is_abstract(cls):
 	try:
 		_ = cls()
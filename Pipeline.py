@@ -4,7 +4,7 @@
 # Date: 08-06-2016
 #
 
-from vtk import *
+import vtkLoader
 from PipelineObject import *
 from ClassTree import *
 from TreeObject import *
@@ -41,7 +41,7 @@ class Pipeline():
 
         # If the added node is a vtkMapper, add an actor for it.
         if newNode.vtkInstanceCall("IsA", "vtkMapper"):
-            actor = vtkActor()
+            actor = vtkLoader.getClass("vtkActor")()
             actor.SetMapper(newNode.vtkInstance)
             self.actors.append(actor)
 
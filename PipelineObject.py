@@ -4,7 +4,7 @@
 # Date: 08-06-2016
 #
 
-from vtk import *
+from copy import deepcopy
 import utils
 import re
 
@@ -12,7 +12,7 @@ import re
 # Function calls to the wrapped vtkInstance(s) should be done via:
 #      vtkInstanceCall(<method>, <arguments to method>)
 class PipelineObject():
-    def __init__(self, vtkInstance, methods):
+    def __init__(self, vtkInstance, methods, shared=False, tupleMethods=None):
         if vtkInstance == None:
             raise TypeError("Cannot wrap 'None' vtk instance")
 
@@ -24,6 +24,19 @@ class PipelineObject():
         self.vtkInstance = vtkInstance
         self.setToMethods, self.onOffMethods, self.setValueMethods = methods
 
+        # Shared method dictionaries are copied on the first change to them.
+        self.ownsMethods = not shared
+
+        # Set/Get pairs of tuple attributes, never changed, so always shared.
+        self.tupleMethods = tupleMethods if tupleMethods != None else {}
+
+    def _ownMethods(self):
+        if not self.ownsMethods:
+            self.setToMethods = deepcopy(self.setToMethods)
+            self.onOffMethods = deepcopy(self.onOffMethods)
+            self.setValueMethods = deepcopy(self.setValueMethods)
+            self.ownsMethods = True
+
     def _assertInstanceSet(self):
         if self.vtkInstance == None:
             raise Error("PipelineObject has no vtkInstance set")
@@ -72,10 +85,68 @@ class PipelineObject():
 
         return returnType, self.vtkInstanceCall(getMethod)
 
+    def copyAttributesFrom(self, other, copyMethods=True):
+        # Copy the current values of all known attributes of another
+        # pipelineObject of the same class, and with copyMethods its method
+        # dictionaries too.
+
+        for setValueMethod in self.setValueMethods:
+            _, value = other.getCurrentValue(setValueMethod)
+            try:
+                self.callSetValueFloatMethod(setValueMethod, value)
+            except TypeError:
+                # Unset values, e.g. a FileName of None, are left alone.
+                pass
+
+        for attributeName, (getMethod, _) in self.onOffMethods.items():
+            if other.vtkInstanceCall(getMethod):
+                self.vtkInstanceCall(attributeName + "On")
+            else:
+                self.vtkInstanceCall(attributeName + "Off")
+
+        # Set*To* attributes share a plain setter taking the current value.
+        for attributeName, info in self.setToMethods.items():
+            value = other.vtkInstanceCall(info["getMethod"])
+            try:
+                self.vtkInstanceCall("Set" + attributeName, value)
+            except (TypeError, AttributeError):
+                pass
+
+        for setMethod, getMethod in self.tupleMethods.items():
+            self.vtkInstanceCall(setMethod, other.vtkInstanceCall(getMethod))
+
+        if copyMethods:
+            self.setToMethods = deepcopy(other.setToMethods)
+            self.onOffMethods = deepcopy(other.onOffMethods)
+
+    def reset(self, default, methods):
+        # Take this pipelineObject back to the state of a new one, given an
+        # unused one of the same class and the shared method dictionaries:
+        # inputs are disconnected, outputs released and attributes set to
+        # their defaults. State set other than through attributes is kept.
+        # Nodes still connected to the outputs are not released to a pool.
+
+        for port in range(self.vtkInstance.GetNumberOfInputPorts()):
+            self.vtkInstance.RemoveAllInputConnections(port)
+
+        for port in range(self.vtkInstance.GetNumberOfOutputPorts()):
+            output = self.vtkInstance.GetOutputDataObject(port)
+            if output != None:
+                output.Initialize()
+
+        # The shared method dictionaries replace this node's right after.
+        self.copyAttributesFrom(default, copyMethods=False)
+        self.setToMethods, self.onOffMethods, self.setValueMethods = methods
+        self.ownsMethods = False
+
+        # Outputs computed before the reset must not count as current.
+        self.vtkInstance.Modified()
+
     def callSetToMethod(self, attributeInfo):
         # A value for a setTo method was chosen, set the new value.
 
         attributeName, setMethodName = attributeInfo
+        self._ownMethods()
 
         # Unselect previous selection.
         setToMethods = self.setToMethods[attributeName]["setToMethods"]
@@ -98,6 +169,7 @@ class PipelineObject():
 
     def toggleOnOffMethod(self, attributeName):
         # An onOff method was activated, toggle its value.
+        self._ownMethods()
 
         getMethodName = "Get" + attributeName
         if self.vtkInstanceCall(getMethodName) == 1:
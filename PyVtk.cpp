@@ -0,0 +1,8095 @@
+#include "PyVtk.h"
+#include "PyVtkFastPath.h"
+
+#include <vtkPythonUtil.h>
+#include <vtkTrivialProducer.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkAppendPolyData.h>
+#include <vtkStructuredGrid.h>
+#include <vtkImageData.h>
+#include <vtkExtractGrid.h>
+#include <vtkExtractVOI.h>
+#include <vtkMaskPoints.h>
+#include <vtkCellArray.h>
+#include <vtkDataSet.h>
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+#include <vtkCellData.h>
+#include <vtkOutputWindow.h>
+#include <vtkCallbackCommand.h>
+#include <vtkCommand.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+#include <vtkInformation.h>
+#include <vtkGenericDataObjectWriter.h>
+#include <vtkGenericDataObjectReader.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+#include <vtkSMPTools.h>
+#include <vtkVersionMacros.h>
+
+#include <unordered_map>
+#include <deque>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cmath>
+
+
+/*
+ * Mapping from VTK object to its node in the ClassTree, and to the Introspector
+ * that created the node, so one session can be saved or closed on its own.
+ */
+static std::unordered_map<vtkObjectBase *, PyObject *> nodes;
+static std::unordered_map<vtkObjectBase *, PyObject *> nodeSessions;
+
+/* Thread budgets of sessions and sinks, see PyVtk_SetThreadBudget. A sink's
+   budget goes away with its node. */
+static std::unordered_map<const void *, size_t> threadBudgets;
+
+static void PyVtk_RegisterNode(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	PyObject *pNode)
+{
+	if (nodes.insert(std::make_pair(pVtkObject, pNode)).second)
+	{
+		nodeSessions[pVtkObject] = pIntrospector;
+	}
+}
+
+static bool PyVtk_InSession(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject)
+{
+	auto iSession = nodeSessions.find(pVtkObject);
+	return nodeSessions.end() != iSession && iSession->second == pIntrospector;
+}
+
+
+/*
+ * Per-thread bump allocator for marshalling scratch space and for the strings
+ * returned by the PyVtk_* functions. Memory is handed out linearly from a list
+ * of chunks and is only reclaimed as a whole by PyVtk_ResetScratch, which
+ * rewinds the chunks without freeing them. Once the arena has grown to the
+ * working set of the caller, the get/set paths no longer reach malloc.
+ */
+class PyVtk_ScratchArena
+{
+public:
+	PyVtk_ScratchArena()
+		: pHead(NULL), pCurrent(NULL), chunkAllocations(0)
+	{
+	}
+
+	~PyVtk_ScratchArena()
+	{
+		while (pHead != NULL)
+		{
+			Chunk *pNext = pHead->pNext;
+			free(pHead);
+			pHead = pNext;
+		}
+	}
+
+	void *Allocate(size_t size)
+	{
+		/* Keeping every block pointer-aligned. */
+		size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+
+		/* Moving forward through the chunks retained by previous resets before
+		   growing the arena. */
+		while (pCurrent != NULL && pCurrent->used + size > pCurrent->capacity && pCurrent->pNext != NULL)
+		{
+			pCurrent = pCurrent->pNext;
+			pCurrent->used = 0;
+		}
+
+		if (pCurrent == NULL || pCurrent->used + size > pCurrent->capacity)
+		{
+			size_t capacity = size > DefaultChunkSize ? size : DefaultChunkSize;
+			Chunk *pChunk = (Chunk *) malloc(sizeof(Chunk) + capacity);
+			if (pChunk == NULL)
+			{
+				return NULL;
+			}
+			++chunkAllocations;
+
+			pChunk->pNext = NULL;
+			pChunk->capacity = capacity;
+			pChunk->used = 0;
+
+			/* Appending at the end of the list, so that chunks are reused in order. */
+			if (pHead == NULL)
+			{
+				pHead = pChunk;
+			}
+			else
+			{
+				Chunk *pLast = pCurrent;
+				while (pLast->pNext != NULL)
+				{
+					pLast = pLast->pNext;
+				}
+				pLast->pNext = pChunk;
+			}
+			pCurrent = pChunk;
+		}
+
+		void *pBlock = pCurrent->Data() + pCurrent->used;
+		pCurrent->used += size;
+		return pBlock;
+	}
+
+	char *CopyString(LPCSTR str, size_t len)
+	{
+		char *pCopy = (char *) Allocate(len + 1);
+		if (pCopy != NULL)
+		{
+			memcpy(pCopy, str, len);
+			pCopy[len] = '\0';
+		}
+		return pCopy;
+	}
+
+	char *CopyString(LPCSTR str)
+	{
+		return CopyString(str, strlen(str));
+	}
+
+	void Reset()
+	{
+		pCurrent = pHead;
+		if (pCurrent != NULL)
+		{
+			pCurrent->used = 0;
+		}
+	}
+
+	PyVtk_ScratchStats Stats() const
+	{
+		PyVtk_ScratchStats stats = { 0, 0, chunkAllocations };
+		bool active = pCurrent != NULL;
+		for (Chunk *pChunk = pHead; pChunk != NULL; pChunk = pChunk->pNext)
+		{
+			/* Chunks past the current one are stale leftovers from before a reset. */
+			if (active)
+			{
+				stats.bytesUsed += pChunk->used;
+			}
+			if (pChunk == pCurrent)
+			{
+				active = false;
+			}
+			stats.bytesReserved += pChunk->capacity;
+		}
+		return stats;
+	}
+
+private:
+	static const size_t DefaultChunkSize = 16 * 1024;
+
+	struct Chunk
+	{
+		Chunk *pNext;
+		size_t capacity;
+		size_t used;
+
+		char *Data()
+		{
+			return (char *) (this + 1);
+		}
+	};
+
+	Chunk *pHead;
+	Chunk *pCurrent;
+	size_t chunkAllocations;
+};
+
+static thread_local PyVtk_ScratchArena scratch;
+
+
+/*
+ * Invalidates every string returned on the calling thread so far and makes
+ * their space available again. Results that must outlive this call have to be
+ * copied with PyVtk_RetainResult first.
+ */
+void PyVtk_ResetScratch()
+{
+	scratch.Reset();
+}
+
+
+PyVtk_ScratchStats PyVtk_GetScratchStats()
+{
+	return scratch.Stats();
+}
+
+
+/*
+ * Copies a result out of the scratch arena into its own heap block, which stays
+ * valid across PyVtk_ResetScratch until it is given to PyVtk_ReleaseResult.
+ */
+LPCSTR PyVtk_RetainResult(
+	LPCSTR result)
+{
+	if (result == NULL)
+	{
+		return NULL;
+	}
+
+	size_t len = strlen(result);
+	char *pCopy = (char *) malloc(len + 1);
+	if (pCopy != NULL)
+	{
+		memcpy(pCopy, result, len + 1);
+	}
+	return pCopy;
+}
+
+
+void PyVtk_ReleaseResult(
+	LPCSTR result)
+{
+	free((void *) result);
+}
+
+
+/*
+ * Structured error channel. Failures of the PyVtk_* functions and the errors and
+ * warnings VTK reports through its output window are recorded in a lock-free
+ * ring instead of being printed where they happen. Records can be consumed with
+ * PyVtk_PopError or written out by the background logger. When the ring is full,
+ * new records are dropped and counted rather than blocking the caller.
+ */
+class PyVtk_ErrorRing
+{
+public:
+	PyVtk_ErrorRing()
+		: enqueuePos(0), dequeuePos(0), dropped(0)
+	{
+		for (size_t i = 0; i < Capacity; ++i)
+		{
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	bool Push(const PyVtk_ErrorRecord &record)
+	{
+		size_t pos = enqueuePos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Cell &cell = cells[pos & (Capacity - 1)];
+			size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t) sequence - (intptr_t) pos;
+			if (diff == 0)
+			{
+				if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					cell.record = record;
+					cell.sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			else
+			{
+				pos = enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	bool Pop(PyVtk_ErrorRecord *pRecord)
+	{
+		size_t pos = dequeuePos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Cell &cell = cells[pos & (Capacity - 1)];
+			size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t) sequence - (intptr_t) (pos + 1);
+			if (diff == 0)
+			{
+				if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					*pRecord = cell.record;
+					cell.sequence.store(pos + Capacity, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				pos = dequeuePos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	size_t Dropped() const
+	{
+		return dropped.load(std::memory_order_relaxed);
+	}
+
+private:
+	static const size_t Capacity = 1024;
+
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		PyVtk_ErrorRecord record;
+	};
+
+	Cell cells[Capacity];
+	std::atomic<size_t> enqueuePos;
+	std::atomic<size_t> dequeuePos;
+	std::atomic<size_t> dropped;
+};
+
+static PyVtk_ErrorRing errors;
+static thread_local int lastError = PYVTK_OK;
+
+
+/*
+ * Records an error without touching Python, so it is safe from any thread. The
+ * last error of the thread is left alone, as VTK warnings land here too.
+ */
+static void PyVtk_RecordError(
+	int code,
+	vtkObjectBase *pObject,
+	LPCSTR method,
+	LPCSTR message)
+{
+	PyVtk_ErrorRecord record;
+	record.code = code;
+	record.pObject = pObject;
+	snprintf(record.method, sizeof(record.method), "%s", method != NULL ? method : "");
+	snprintf(record.message, sizeof(record.message), "%s", message != NULL ? message : "");
+	record.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+
+	errors.Push(record);
+}
+
+
+/*
+ * Records the failure of the current call.
+ */
+static void PyVtk_PushError(
+	int code,
+	vtkObjectBase *pObject,
+	LPCSTR method,
+	LPCSTR message)
+{
+	lastError = code;
+	PyVtk_RecordError(code, pObject, method, message);
+}
+
+
+/*
+ * Records a failure of the embedding layer. If Python has an exception set, it is
+ * appended to the message and cleared. Needs the GIL.
+ */
+static void PyVtk_Error(
+	int code,
+	vtkObjectBase *pObject,
+	LPCSTR method,
+	LPCSTR format,
+	...)
+{
+	char message[256];
+
+	va_list args;
+	va_start(args, format);
+	int len = vsnprintf(message, sizeof(message), format, args);
+	va_end(args);
+
+	if (PyErr_Occurred())
+	{
+		PyObject *pType, *pValue, *pTraceback;
+		PyErr_Fetch(&pType, &pValue, &pTraceback);
+		PyErr_NormalizeException(&pType, &pValue, &pTraceback);
+
+		PyObject *pValueStr = pValue != NULL ? PyObject_Str(pValue) : NULL;
+		LPCSTR valueStr = pValueStr != NULL ? PyString_AsString(pValueStr) : NULL;
+		if (len >= 0 && (size_t) len < sizeof(message))
+		{
+			snprintf(message + len, sizeof(message) - len, " (%s: %s)",
+				((PyTypeObject *) pType)->tp_name, valueStr != NULL ? valueStr : "");
+		}
+
+		Py_XDECREF(pValueStr);
+		Py_XDECREF(pType);
+		Py_XDECREF(pValue);
+		Py_XDECREF(pTraceback);
+		PyErr_Clear();
+	}
+
+	PyVtk_PushError(code, pObject, method, message);
+}
+
+
+/*
+ * Code of the last failure on the calling thread.
+ */
+int PyVtk_GetLastError()
+{
+	return lastError;
+}
+
+
+bool PyVtk_PopError(
+	PyVtk_ErrorRecord *pRecord)
+{
+	return errors.Pop(pRecord);
+}
+
+
+size_t PyVtk_GetDroppedErrors()
+{
+	return errors.Dropped();
+}
+
+
+/*
+ * Background thread draining the error ring into a log file.
+ */
+static std::thread errorLogger;
+static std::atomic<bool> errorLoggerRunning(false);
+
+
+bool PyVtk_StartErrorLog(
+	LPCSTR path)
+{
+	if (errorLoggerRunning)
+	{
+		return false;
+	}
+
+	FILE *pLog = fopen(path, "a");
+	if (pLog == NULL)
+	{
+		PyVtk_PushError(PYVTK_E_ARGUMENT, NULL, "PyVtk_StartErrorLog", path);
+		return false;
+	}
+
+	errorLoggerRunning = true;
+	errorLogger = std::thread([pLog]()
+	{
+		PyVtk_ErrorRecord record;
+		for (;;)
+		{
+			bool running = errorLoggerRunning;
+			if (errors.Pop(&record))
+			{
+				fprintf(pLog, "%lld\t%d\t%p\t%s\t%s\n", record.timestamp, record.code, (void *) record.pObject, record.method, record.message);
+				continue;
+			}
+
+			/* Draining what is left before stopping. */
+			if (!running)
+			{
+				break;
+			}
+
+			fflush(pLog);
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+
+		fclose(pLog);
+	});
+
+	return true;
+}
+
+
+void PyVtk_StopErrorLog()
+{
+	if (errorLoggerRunning)
+	{
+		errorLoggerRunning = false;
+		errorLogger.join();
+	}
+}
+
+
+/*
+ * Instrumentation of the entry points. Every PyVtk_* call records its latency in
+ * histograms of the calling thread, split into the time spent in the Python
+ * layer, inside VTK execution, waiting for the GIL, and the rest, which is the
+ * marshalling done here. Only the outermost entry point of a thread records, so
+ * nested calls are attributed to the call that made them. The counters are only
+ * written by their own thread and read with relaxed loads by snapshots, which
+ * keeps the cost of a call to a few clock reads.
+ */
+enum PyVtk_Entry
+{
+	PYVTK_ENTRY_INIT,
+	PYVTK_ENTRY_CREATE,
+	PYVTK_ENTRY_GET_PROPERTY,
+	PYVTK_ENTRY_SET_PROPERTY,
+	PYVTK_ENTRY_GET_DESCRIPTOR,
+	PYVTK_ENTRY_DELETE,
+	PYVTK_ENTRY_GET_OUTPUT_PORT,
+	PYVTK_ENTRY_CONNECT,
+	PYVTK_ENTRY_FINALIZE,
+	PYVTK_ENTRY_OBJECT_METHOD,
+	PYVTK_ENTRY_OBJECT_METHOD_AS_VTK_OBJECT,
+	PYVTK_ENTRY_PIPED_METHOD,
+	PYVTK_ENTRY_PIPED_METHOD_AS_STRING,
+	PYVTK_ENTRY_FLUSH_PROPERTIES,
+	PYVTK_ENTRY_SET_COALESCING,
+	PYVTK_ENTRY_PREPARE_CHAIN,
+	PYVTK_ENTRY_EXECUTE_CHAIN,
+	PYVTK_ENTRY_SWEEP,
+	PYVTK_ENTRY_SWEEP_POINT,
+	PYVTK_ENTRY_SAVE_SESSION,
+	PYVTK_ENTRY_RESTORE_SESSION,
+	PYVTK_ENTRY_SET_POOL_SIZE,
+	PYVTK_ENTRY_CLOSE_SESSION,
+	PYVTK_ENTRY_CONNECT_PORTS,
+	PYVTK_ENTRY_UPDATE_PIPELINE,
+	PYVTK_ENTRY_UPDATE_PIPELINE_NODE,
+	PYVTK_ENTRY_CONFIGURE_SMP,
+	PYVTK_ENTRY_SET_THREAD_BUDGET,
+	PYVTK_ENTRY_SNAPSHOT_PROPERTIES,
+	PYVTK_ENTRY_SUBSCRIBE,
+	PYVTK_ENTRY_POLL_CHANGES,
+	PYVTK_ENTRY_PROGRESSIVE_UPDATE,
+	PYVTK_ENTRY_PROGRESSIVE_CHUNK,
+	PYVTK_ENTRY_SET_PREVIEW,
+	PYVTK_ENTRY_PREVIEW_FINAL,
+	PYVTK_ENTRY_POLL_PREVIEWS,
+	PYVTK_ENTRY_EXPORT_COLUMNS,
+	PYVTK_ENTRY_FIND_CLASSES,
+	PYVTK_ENTRY_SET_PROPERTY_VALUE,
+	PYVTK_ENTRY_OBJECT_METHOD_INTO,
+	PYVTK_ENTRY_PIPED_METHOD_INTO,
+	PYVTK_ENTRY_COUNT
+};
+
+static LPCSTR const entryNames[PYVTK_ENTRY_COUNT] = {
+	"PyVtk_InitIntrospector",
+	"PyVtk_CreateVtkObject",
+	"PyVtk_GetVtkObjectProperty",
+	"PyVtk_SetVtkObjectProperty",
+	"PyVtk_GetVtkObjectDescriptor",
+	"PyVtk_DeleteVtkObject",
+	"PyVtk_GetOutputPort",
+	"PyVtk_ConnectVtkObject",
+	"PyVtk_FinalizeIntrospector",
+	"PyVtk_ObjectMethod",
+	"PyVtk_ObjectMethodAsVtkObject",
+	"PyVtk_PipedObjectMethod",
+	"PyVtk_PipedObjectMethodAsString",
+	"PyVtk_FlushProperties",
+	"PyVtk_SetCoalescing",
+	"PyVtk_PrepareChain",
+	"PyVtk_ExecuteChain",
+	"PyVtk_SweepVtkObjectProperty",
+	"PyVtk_SweepVtkObjectProperty/point",
+	"PyVtk_SaveSession",
+	"PyVtk_RestoreSession",
+	"PyVtk_SetPoolSize",
+	"PyVtk_CloseSession",
+	"PyVtk_ConnectVtkObjectPorts",
+	"PyVtk_UpdatePipeline",
+	"PyVtk_UpdatePipeline/node",
+	"PyVtk_ConfigureSmp",
+	"PyVtk_SetThreadBudget",
+	"PyVtk_SnapshotProperties",
+	"PyVtk_Subscribe",
+	"PyVtk_PollChanges",
+	"PyVtk_ProgressiveUpdate",
+	"PyVtk_ProgressiveUpdate/chunk",
+	"PyVtk_SetPreview",
+	"PyVtk_SetPreview/final",
+	"PyVtk_PollPreviews",
+	"PyVtk_ExportColumns",
+	"PyVtk_FindVtkClasses",
+	"PyVtk_SetVtkObjectPropertyValue",
+	"PyVtk_ObjectMethodInto",
+	"PyVtk_PipedObjectMethodInto"
+};
+
+
+/*
+ * Log-linear histogram of nanoseconds: values are bucketed by their highest set
+ * bit and the three bits below it, which bounds the error of a percentile to
+ * 12.5% whatever its magnitude. Values past about a minute share the last bucket.
+ */
+class PyVtk_Histogram
+{
+public:
+	static const size_t SubBits = 3;
+	static const size_t Buckets = (36 - SubBits + 1) << SubBits;
+
+	PyVtk_Histogram()
+	{
+		Reset();
+	}
+
+	void Add(unsigned long long value)
+	{
+		std::atomic<unsigned long long> &bucket = counts[Bucket(value)];
+		bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		sum.store(sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		if (value > max.load(std::memory_order_relaxed))
+		{
+			max.store(value, std::memory_order_relaxed);
+		}
+	}
+
+	void Reset()
+	{
+		for (size_t i = 0; i < Buckets; ++i)
+		{
+			counts[i].store(0, std::memory_order_relaxed);
+		}
+		sum.store(0, std::memory_order_relaxed);
+		max.store(0, std::memory_order_relaxed);
+	}
+
+	/* Adds the counts of this histogram to plain ones, for merging threads. */
+	void MergeInto(unsigned long long *pCounts, unsigned long long *pSum, unsigned long long *pMax) const
+	{
+		for (size_t i = 0; i < Buckets; ++i)
+		{
+			pCounts[i] += counts[i].load(std::memory_order_relaxed);
+		}
+		*pSum += sum.load(std::memory_order_relaxed);
+		*pMax = std::max(*pMax, max.load(std::memory_order_relaxed));
+	}
+
+	static size_t Bucket(unsigned long long value)
+	{
+		if (value < (1ull << SubBits))
+		{
+			return (size_t) value;
+		}
+
+		size_t high = 63;
+		while ((value >> high) == 0)
+		{
+			--high;
+		}
+		size_t bucket = ((high - SubBits + 1) << SubBits) + (size_t) ((value >> (high - SubBits)) & ((1ull << SubBits) - 1));
+		return std::min(bucket, Buckets - 1);
+	}
+
+	/* Largest value falling in a bucket. */
+	static unsigned long long Upper(size_t bucket)
+	{
+		if (bucket < (1u << SubBits))
+		{
+			return bucket;
+		}
+
+		size_t high = (bucket >> SubBits) + SubBits - 1;
+		unsigned long long sub = bucket & ((1u << SubBits) - 1);
+		return (((1ull << SubBits) + sub + 1) << (high - SubBits)) - 1;
+	}
+
+private:
+	std::atomic<unsigned long long> counts[Buckets];
+	std::atomic<unsigned long long> sum;
+	std::atomic<unsigned long long> max;
+};
+
+
+struct PyVtk_EntryCounters
+{
+	std::atomic<unsigned long long> calls;
+	std::atomic<unsigned long long> gilWait;
+	std::atomic<unsigned long long> pythonAllocations;
+	std::atomic<unsigned long long> vtkCpu;
+	PyVtk_Histogram total;
+	PyVtk_Histogram marshal;
+	PyVtk_Histogram python;
+	PyVtk_Histogram vtk;
+};
+
+struct PyVtk_ThreadCounters
+{
+	PyVtk_EntryCounters entries[PYVTK_ENTRY_COUNT];
+};
+
+
+/*
+ * Counters of all the threads that ever called in. The counters of a thread that
+ * exits are kept, as they are part of the totals, and are handed to the next
+ * new thread, so short-lived workers do not grow the registry.
+ */
+static std::mutex countersMutex;
+static std::vector<PyVtk_ThreadCounters *> threadCounters;
+static std::vector<PyVtk_ThreadCounters *> freeCounters;
+
+class PyVtk_ThreadCountersOwner
+{
+public:
+	PyVtk_ThreadCountersOwner()
+		: pCounters(NULL)
+	{
+	}
+
+	~PyVtk_ThreadCountersOwner()
+	{
+		if (pCounters != NULL)
+		{
+			std::lock_guard<std::mutex> lock(countersMutex);
+			freeCounters.push_back(pCounters);
+		}
+	}
+
+	PyVtk_ThreadCounters *Get()
+	{
+		if (pCounters == NULL)
+		{
+			std::lock_guard<std::mutex> lock(countersMutex);
+			if (freeCounters.empty())
+			{
+				pCounters = new PyVtk_ThreadCounters();
+				threadCounters.push_back(pCounters);
+			}
+			else
+			{
+				pCounters = freeCounters.back();
+				freeCounters.pop_back();
+			}
+		}
+		return pCounters;
+	}
+
+private:
+	PyVtk_ThreadCounters *pCounters;
+};
+
+static thread_local PyVtk_ThreadCountersOwner countersOwner;
+
+
+static inline unsigned long long PyVtk_Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*
+ * CPU time of all the threads of the process, in nanoseconds.
+ */
+static unsigned long long PyVtk_CpuNow()
+{
+	FILETIME creation, exit, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+	{
+		return 0;
+	}
+
+	unsigned long long kernelTicks = ((unsigned long long) kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+	unsigned long long userTicks = ((unsigned long long) user.dwHighDateTime << 32) | user.dwLowDateTime;
+	return (kernelTicks + userTicks) * 100;
+}
+
+
+/*
+ * Timeline tracing. While enabled, the entry points, the Introspector methods
+ * they call and the execution of the algorithms are recorded as Chrome trace
+ * events in a ring that keeps the most recent ones. PyVtk_FlushTrace writes the
+ * ring as trace-event JSON, which chrome://tracing and Perfetto open. Events
+ * are claimed with a single atomic increment and published with a sequence
+ * number, so a flush skips the slots still being written.
+ */
+struct PyVtk_TraceEvent
+{
+	std::atomic<size_t> sequence;
+	char phase;
+	LPCSTR category;
+	char name[48];
+	char className[48];
+	const void *pHandle;
+	double progress;
+	unsigned long long timestamp;
+	unsigned int thread;
+};
+
+static std::atomic<bool> tracing(false);
+static PyVtk_TraceEvent *pTraceEvents = NULL;
+static size_t traceCapacity = 0;
+static std::atomic<size_t> traceHead(0);
+static size_t traceTail = 0;
+static std::atomic<unsigned int> traceThreads(0);
+static thread_local unsigned int traceThread = 0;
+
+static void PyVtk_Trace(
+	char phase,
+	LPCSTR category,
+	LPCSTR name,
+	const vtkObjectBase *pObject,
+	double progress = 0.0)
+{
+	if (traceThread == 0)
+	{
+		traceThread = ++traceThreads;
+	}
+
+	size_t pos = traceHead.fetch_add(1, std::memory_order_relaxed);
+	PyVtk_TraceEvent &event = pTraceEvents[pos & (traceCapacity - 1)];
+	event.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	event.phase = phase;
+	event.category = category;
+	snprintf(event.name, sizeof(event.name), "%s", name != NULL ? name : "");
+	snprintf(event.className, sizeof(event.className), "%s", pObject != NULL ? pObject->GetClassName() : "");
+	event.pHandle = pObject;
+	event.progress = progress;
+	event.timestamp = PyVtk_Now();
+	event.thread = traceThread;
+
+	event.sequence.store(pos + 1, std::memory_order_release);
+}
+
+
+/*
+ * Starts recording into a ring of the given number of events, rounded up to a
+ * power of two. Not to be called while other threads are inside PyVtk_* calls.
+ */
+bool PyVtk_StartTrace(
+	size_t capacity)
+{
+	if (tracing)
+	{
+		return false;
+	}
+
+	size_t rounded = 1;
+	while (rounded < capacity)
+	{
+		rounded <<= 1;
+	}
+
+	if (rounded != traceCapacity)
+	{
+		delete[] pTraceEvents;
+		pTraceEvents = new PyVtk_TraceEvent[rounded];
+		traceCapacity = rounded;
+	}
+	for (size_t i = 0; i < traceCapacity; ++i)
+	{
+		pTraceEvents[i].sequence.store(0, std::memory_order_relaxed);
+	}
+	traceHead.store(0, std::memory_order_relaxed);
+	traceTail = 0;
+
+	tracing = true;
+	return true;
+}
+
+
+/*
+ * Stops recording. What was recorded can still be flushed.
+ */
+void PyVtk_StopTrace()
+{
+	tracing = false;
+}
+
+
+/*
+ * Writes str as a JSON string. Names come from Python methods and VTK classes,
+ * which are not guaranteed to be plain identifiers.
+ */
+static void PyVtk_WriteJsonString(
+	FILE *pFile,
+	LPCSTR str)
+{
+	fputc('"', pFile);
+	for (const unsigned char *pChar = (const unsigned char *) str; *pChar != '\0'; ++pChar)
+	{
+		if (*pChar == '"' || *pChar == '\\')
+		{
+			fputc('\\', pFile);
+			fputc(*pChar, pFile);
+		}
+		else if (*pChar < 0x20)
+		{
+			fprintf(pFile, "\\u%04x", *pChar);
+		}
+		else
+		{
+			fputc(*pChar, pFile);
+		}
+	}
+	fputc('"', pFile);
+}
+
+
+/*
+ * Writes the events recorded since the last flush, oldest first, and drops them
+ * from the ring. Timestamps are in microseconds of the steady clock.
+ */
+bool PyVtk_FlushTrace(
+	LPCSTR path)
+{
+	FILE *pFile = fopen(path, "w");
+	if (pFile == NULL)
+	{
+		PyVtk_PushError(PYVTK_E_ARGUMENT, NULL, "PyVtk_FlushTrace", path);
+		return false;
+	}
+
+	fprintf(pFile, "{ \"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+
+	size_t head = traceHead.load(std::memory_order_acquire);
+	size_t pos = head - traceTail > traceCapacity ? head - traceCapacity : traceTail;
+	bool first = true;
+	for (; pos < head; ++pos)
+	{
+		const PyVtk_TraceEvent &slot = pTraceEvents[pos & (traceCapacity - 1)];
+		if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+		{
+			continue;
+		}
+
+		char phase = slot.phase;
+		LPCSTR category = slot.category;
+		char name[sizeof(slot.name)];
+		char className[sizeof(slot.className)];
+		memcpy(name, slot.name, sizeof(name));
+		memcpy(className, slot.className, sizeof(className));
+		const void *pHandle = slot.pHandle;
+		double progress = slot.progress;
+		unsigned long long timestamp = slot.timestamp;
+		unsigned int thread = slot.thread;
+
+		/* Overwritten while copying. */
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) != pos + 1)
+		{
+			continue;
+		}
+
+		fprintf(pFile, "%s\n{ \"name\": ", first ? "" : ",");
+		PyVtk_WriteJsonString(pFile, name);
+		fprintf(pFile, ", \"cat\": \"%s\", \"ph\": \"%c\", \"ts\": %.3f, \"pid\": 1, \"tid\": %u",
+			category, phase, timestamp / 1000.0, thread);
+		if (phase == 'i')
+		{
+			fprintf(pFile, ", \"s\": \"t\"");
+		}
+		fprintf(pFile, ", \"args\": { \"object\": \"%p\", \"class\": ", pHandle);
+		PyVtk_WriteJsonString(pFile, className);
+		if (phase == 'i')
+		{
+			fprintf(pFile, ", \"progress\": %.3f", progress);
+		}
+		fprintf(pFile, " } }");
+		first = false;
+	}
+	traceTail = head;
+
+	fprintf(pFile, "\n] }\n");
+	fclose(pFile);
+	return true;
+}
+
+
+/*
+ * Outermost entry point running on the calling thread, and what its time was
+ * spent on so far. With instrumentation disabled no call becomes current, so
+ * none of the clocks below is read.
+ */
+class PyVtk_CallScope;
+static std::atomic<bool> instrumenting(true);
+static thread_local PyVtk_CallScope *pCurrentCall = NULL;
+static thread_local int pythonDepth = 0;
+static thread_local int vtkDepth = 0;
+static thread_local unsigned long long vtkStart = 0;
+static thread_local unsigned long long vtkCpuStart = 0;
+static thread_local unsigned long long pythonAllocations = 0;
+
+class PyVtk_CallScope
+{
+public:
+	explicit PyVtk_CallScope(PyVtk_Entry entry, const vtkObjectBase *pObject = NULL)
+		: entry(entry), active(pCurrentCall == NULL && instrumenting.load(std::memory_order_relaxed)), traced(tracing), pObject(pObject), python(0), vtk(0), vtkInPython(0), vtkCpu(0), gilWait(0)
+	{
+		if (traced)
+		{
+			PyVtk_Trace('B', "api", entryNames[entry], pObject);
+		}
+		if (active)
+		{
+			pCurrentCall = this;
+			allocations = pythonAllocations;
+			start = PyVtk_Now();
+		}
+	}
+
+	~PyVtk_CallScope()
+	{
+		if (traced)
+		{
+			PyVtk_Trace('E', "api", entryNames[entry], pObject);
+		}
+		if (!active)
+		{
+			return;
+		}
+
+		unsigned long long total = PyVtk_Now() - start;
+		pCurrentCall = NULL;
+
+		/* VTK time spent inside a Python call is VTK time, not Python time. */
+		unsigned long long pythonOnly = python > vtkInPython ? python - vtkInPython : 0;
+		unsigned long long accounted = python + (vtk - vtkInPython) + gilWait;
+		unsigned long long marshal = total > accounted ? total - accounted : 0;
+
+		PyVtk_EntryCounters &counters = countersOwner.Get()->entries[entry];
+		counters.calls.store(counters.calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		counters.gilWait.store(counters.gilWait.load(std::memory_order_relaxed) + gilWait, std::memory_order_relaxed);
+		counters.vtkCpu.store(counters.vtkCpu.load(std::memory_order_relaxed) + vtkCpu, std::memory_order_relaxed);
+		counters.pythonAllocations.store(counters.pythonAllocations.load(std::memory_order_relaxed)
+			+ (pythonAllocations - allocations), std::memory_order_relaxed);
+		counters.total.Add(total);
+		counters.marshal.Add(marshal);
+		counters.python.Add(pythonOnly);
+		counters.vtk.Add(vtk);
+	}
+
+	PyVtk_Entry entry;
+	bool active;
+	bool traced;
+	const vtkObjectBase *pObject;
+	unsigned long long start;
+	unsigned long long allocations;
+	unsigned long long python;
+	unsigned long long vtk;
+	unsigned long long vtkInPython;
+	unsigned long long vtkCpu;
+	unsigned long long gilWait;
+};
+
+
+/*
+ * Times a call into Python as Python time of the current entry point. The trace
+ * span carries the VTK object the call is made for, if any.
+ */
+class PyVtk_PythonScope
+{
+public:
+	explicit PyVtk_PythonScope(LPCSTR method = NULL, const vtkObjectBase *pObject = NULL)
+		: method(tracing && method != NULL ? method : NULL), pObject(pObject), start(pCurrentCall != NULL ? PyVtk_Now() : 0)
+	{
+		if (this->method != NULL)
+		{
+			PyVtk_Trace('B', "python", this->method, pObject);
+		}
+		++pythonDepth;
+	}
+
+	~PyVtk_PythonScope()
+	{
+		--pythonDepth;
+		if (pCurrentCall != NULL && pythonDepth == 0)
+		{
+			pCurrentCall->python += PyVtk_Now() - start;
+		}
+		if (method != NULL)
+		{
+			PyVtk_Trace('E', "python", method, pObject);
+		}
+	}
+
+private:
+	LPCSTR method;
+	const vtkObjectBase *pObject;
+	unsigned long long start;
+};
+
+
+/*
+ * PyObject_CallMethod timed as Python time of the current entry point.
+ */
+template<typename... A>
+static PyObject *PyVtk_CallPython(
+	PyObject *pObject,
+	LPCSTR method,
+	LPCSTR format,
+	A... argv)
+{
+	PyVtk_PythonScope python(method);
+	return PyObject_CallMethod(pObject, method, format, argv...);
+}
+
+
+/*
+ * PyVtk_CallPython made for the node of pVtkObject.
+ */
+template<typename... A>
+static PyObject *PyVtk_CallPythonFor(
+	const vtkObjectBase *pVtkObject,
+	PyObject *pObject,
+	LPCSTR method,
+	LPCSTR format,
+	A... argv)
+{
+	PyVtk_PythonScope python(method, pVtkObject);
+	return PyObject_CallMethod(pObject, method, format, argv...);
+}
+
+
+/*
+ * The CPU time of the process is only sampled from the first execution on, as
+ * the call costs more than most property accesses.
+ */
+static void PyVtk_BeginVtk(
+	bool execution = false)
+{
+	if (vtkDepth++ == 0)
+	{
+		vtkStart = pCurrentCall != NULL ? PyVtk_Now() : 0;
+		vtkCpuStart = 0;
+	}
+	if (execution && vtkCpuStart == 0 && pCurrentCall != NULL)
+	{
+		vtkCpuStart = PyVtk_CpuNow();
+	}
+}
+
+static void PyVtk_EndVtk()
+{
+	if (vtkDepth > 0 && --vtkDepth == 0 && pCurrentCall != NULL && vtkStart != 0)
+	{
+		unsigned long long elapsed = PyVtk_Now() - vtkStart;
+		pCurrentCall->vtk += elapsed;
+		if (vtkCpuStart != 0)
+		{
+			pCurrentCall->vtkCpu += PyVtk_CpuNow() - vtkCpuStart;
+		}
+		if (pythonDepth > 0)
+		{
+			pCurrentCall->vtkInPython += elapsed;
+		}
+	}
+}
+
+/*
+ * Times VTK execution started directly from here, as opposed to through Python,
+ * where the Start/EndEvent observers of the algorithms take care of it.
+ */
+class PyVtk_VtkScope
+{
+public:
+	explicit PyVtk_VtkScope(const vtkObjectBase *pObject, bool execution = false)
+		: pObject(tracing ? pObject : NULL)
+	{
+		if (this->pObject != NULL)
+		{
+			PyVtk_Trace('B', "vtk", this->pObject->GetClassName(), this->pObject);
+		}
+		PyVtk_BeginVtk(execution);
+	}
+
+	~PyVtk_VtkScope()
+	{
+		PyVtk_EndVtk();
+		if (pObject != NULL)
+		{
+			PyVtk_Trace('E', "vtk", pObject->GetClassName(), pObject);
+		}
+	}
+
+private:
+	const vtkObjectBase *pObject;
+};
+
+
+static void PyVtk_VtkTimerEvent(
+	vtkObject *pCaller,
+	unsigned long eventId,
+	void *pClientData,
+	void *pCallData)
+{
+	if (eventId == vtkCommand::StartEvent)
+	{
+		if (tracing)
+		{
+			PyVtk_Trace('B', "vtk", pCaller->GetClassName(), pCaller);
+		}
+		PyVtk_BeginVtk(true);
+	}
+	else if (eventId == vtkCommand::EndEvent)
+	{
+		PyVtk_EndVtk();
+		if (tracing)
+		{
+			PyVtk_Trace('E', "vtk", pCaller->GetClassName(), pCaller);
+		}
+	}
+	else if (tracing && pCallData != NULL)
+	{
+		PyVtk_Trace('i', "vtk", "Progress", pCaller, *(double *) pCallData);
+	}
+}
+
+static vtkCallbackCommand *pVtkTimer = NULL;
+
+/*
+ * Observes the execution of an algorithm created through the embedding layer.
+ * Pooled algorithms come back already observed.
+ */
+static void PyVtk_ObserveExecution(
+	vtkObjectBase *pVtkObject)
+{
+	vtkAlgorithm *pAlgorithm = vtkAlgorithm::SafeDownCast(pVtkObject);
+	if (pAlgorithm != NULL && pVtkTimer != NULL && !pAlgorithm->HasObserver(vtkCommand::StartEvent, pVtkTimer))
+	{
+		pAlgorithm->AddObserver(vtkCommand::StartEvent, pVtkTimer);
+		pAlgorithm->AddObserver(vtkCommand::EndEvent, pVtkTimer);
+		pAlgorithm->AddObserver(vtkCommand::ProgressEvent, pVtkTimer);
+	}
+}
+
+
+/*
+ * Takes the GIL from a thread that does not hold it, counting the wait.
+ */
+static PyGILState_STATE PyVtk_EnsureGil()
+{
+	unsigned long long start = pCurrentCall != NULL ? PyVtk_Now() : 0;
+	PyGILState_STATE gil = PyGILState_Ensure();
+	if (pCurrentCall != NULL)
+	{
+		pCurrentCall->gilWait += PyVtk_Now() - start;
+	}
+	return gil;
+}
+
+/*
+ * Executions running VTK with the GIL released, during which the calls of other
+ * threads leave shared pipelines alone.
+ */
+static std::atomic<int> releasedExecutions(0);
+
+static PyThreadState *PyVtk_ReleaseGil()
+{
+	++releasedExecutions;
+	return PyEval_SaveThread();
+}
+
+static void PyVtk_RestoreGil(
+	PyThreadState *pThreadState)
+{
+	unsigned long long start = pCurrentCall != NULL ? PyVtk_Now() : 0;
+	PyEval_RestoreThread(pThreadState);
+	--releasedExecutions;
+	if (pCurrentCall != NULL)
+	{
+		pCurrentCall->gilWait += PyVtk_Now() - start;
+	}
+}
+
+
+/*
+ * Object allocator of Python wrapped to count allocations per thread. Python
+ * allows hooks that only forward to the allocator they replace to be installed
+ * after initialization, and blocks allocated through the hook can be freed once
+ * it is removed, as they come from the same allocator.
+ */
+static PyMemAllocatorEx pythonObjectAllocator;
+static bool countingAllocations = false;
+
+static void *PyVtk_CountingMalloc(
+	void *pContext,
+	size_t size)
+{
+	++pythonAllocations;
+	return pythonObjectAllocator.malloc(pythonObjectAllocator.ctx, size);
+}
+
+static void *PyVtk_CountingCalloc(
+	void *pContext,
+	size_t count,
+	size_t size)
+{
+	++pythonAllocations;
+	return pythonObjectAllocator.calloc(pythonObjectAllocator.ctx, count, size);
+}
+
+static void *PyVtk_CountingRealloc(
+	void *pContext,
+	void *p,
+	size_t size)
+{
+	if (p == NULL)
+	{
+		++pythonAllocations;
+	}
+	return pythonObjectAllocator.realloc(pythonObjectAllocator.ctx, p, size);
+}
+
+static void PyVtk_CountingFree(
+	void *pContext,
+	void *p)
+{
+	pythonObjectAllocator.free(pythonObjectAllocator.ctx, p);
+}
+
+static void PyVtk_CountAllocations(
+	bool enabled)
+{
+	if (enabled && !countingAllocations)
+	{
+		PyMem_GetAllocator(PYMEM_DOMAIN_OBJ, &pythonObjectAllocator);
+		PyMemAllocatorEx counting = { NULL, PyVtk_CountingMalloc, PyVtk_CountingCalloc, PyVtk_CountingRealloc, PyVtk_CountingFree };
+		PyMem_SetAllocator(PYMEM_DOMAIN_OBJ, &counting);
+		countingAllocations = true;
+	}
+	else if (!enabled && countingAllocations)
+	{
+		PyMem_SetAllocator(PYMEM_DOMAIN_OBJ, &pythonObjectAllocator);
+		countingAllocations = false;
+	}
+}
+
+static void PyVtk_StartInstrumentation()
+{
+	PyVtk_CountAllocations(instrumenting);
+
+	if (pVtkTimer == NULL)
+	{
+		pVtkTimer = vtkCallbackCommand::New();
+		pVtkTimer->SetCallback(PyVtk_VtkTimerEvent);
+	}
+}
+
+/*
+ * Called once the interpreter is finalized.
+ */
+static void PyVtk_StopInstrumentation()
+{
+	PyVtk_CountAllocations(false);
+
+	if (pVtkTimer != NULL)
+	{
+		pVtkTimer->Delete();
+		pVtkTimer = NULL;
+	}
+}
+
+
+/*
+ * Enables or disables the per-call counters, which are enabled by default.
+ * Disabled, entry points read no clock and Python allocations are not hooked.
+ * Needs the GIL once the interpreter is up, and no call in progress.
+ */
+void PyVtk_SetInstrumentation(
+	bool enabled)
+{
+	instrumenting = enabled;
+	if (Py_IsInitialized())
+	{
+		PyVtk_CountAllocations(enabled);
+	}
+}
+
+
+static void PyVtk_SummarizeLatency(
+	const unsigned long long *pCounts,
+	unsigned long long calls,
+	unsigned long long sum,
+	unsigned long long max,
+	PyVtk_Latency *pLatency)
+{
+	pLatency->sum = sum;
+	pLatency->max = max;
+	pLatency->p50 = pLatency->p90 = pLatency->p99 = 0;
+
+	unsigned long long ranks[3] = {
+		(calls * 50 + 99) / 100,
+		(calls * 90 + 99) / 100,
+		(calls * 99 + 99) / 100
+	};
+	unsigned long long *pPercentiles[3] = { &pLatency->p50, &pLatency->p90, &pLatency->p99 };
+
+	unsigned long long seen = 0;
+	size_t next = 0;
+	for (size_t i = 0; i < PyVtk_Histogram::Buckets && next < 3; ++i)
+	{
+		seen += pCounts[i];
+		while (next < 3 && ranks[next] > 0 && seen >= ranks[next])
+		{
+			*pPercentiles[next++] = std::min(PyVtk_Histogram::Upper(i), max);
+		}
+	}
+}
+
+
+/*
+ * Merges the counters of every thread. Percentiles are upper bounds of their
+ * histogram bucket, capped by the largest value seen.
+ */
+size_t PyVtk_GetInstrumentation(
+	PyVtk_EntryStats *pStats,
+	size_t capacity)
+{
+	std::vector<unsigned long long> counts(4 * PyVtk_Histogram::Buckets);
+
+	std::lock_guard<std::mutex> lock(countersMutex);
+	size_t count = std::min<size_t>(capacity, PYVTK_ENTRY_COUNT);
+	for (size_t entry = 0; entry < count; ++entry)
+	{
+		PyVtk_EntryStats &stats = pStats[entry];
+		stats.name = entryNames[entry];
+		stats.calls = stats.gilWait = stats.pythonAllocations = stats.vtkCpu = 0;
+		std::fill(counts.begin(), counts.end(), 0);
+
+		unsigned long long sums[4] = { 0, 0, 0, 0 };
+		unsigned long long maxima[4] = { 0, 0, 0, 0 };
+		for (PyVtk_ThreadCounters *pCounters : threadCounters)
+		{
+			const PyVtk_EntryCounters &counters = pCounters->entries[entry];
+			stats.calls += counters.calls.load(std::memory_order_relaxed);
+			stats.gilWait += counters.gilWait.load(std::memory_order_relaxed);
+			stats.pythonAllocations += counters.pythonAllocations.load(std::memory_order_relaxed);
+			stats.vtkCpu += counters.vtkCpu.load(std::memory_order_relaxed);
+			counters.total.MergeInto(&counts[0], &sums[0], &maxima[0]);
+			counters.marshal.MergeInto(&counts[PyVtk_Histogram::Buckets], &sums[1], &maxima[1]);
+			counters.python.MergeInto(&counts[2 * PyVtk_Histogram::Buckets], &sums[2], &maxima[2]);
+			counters.vtk.MergeInto(&counts[3 * PyVtk_Histogram::Buckets], &sums[3], &maxima[3]);
+		}
+
+		PyVtk_SummarizeLatency(&counts[0], stats.calls, sums[0], maxima[0], &stats.total);
+		PyVtk_SummarizeLatency(&counts[PyVtk_Histogram::Buckets], stats.calls, sums[1], maxima[1], &stats.marshal);
+		PyVtk_SummarizeLatency(&counts[2 * PyVtk_Histogram::Buckets], stats.calls, sums[2], maxima[2], &stats.python);
+		PyVtk_SummarizeLatency(&counts[3 * PyVtk_Histogram::Buckets], stats.calls, sums[3], maxima[3], &stats.vtk);
+	}
+
+	return count;
+}
+
+
+/*
+ * Clears the counters of every thread. Calls completing while it runs may be
+ * partly kept.
+ */
+void PyVtk_ResetInstrumentation()
+{
+	std::lock_guard<std::mutex> lock(countersMutex);
+	for (PyVtk_ThreadCounters *pCounters : threadCounters)
+	{
+		for (PyVtk_EntryCounters &counters : pCounters->entries)
+		{
+			counters.calls.store(0, std::memory_order_relaxed);
+			counters.gilWait.store(0, std::memory_order_relaxed);
+			counters.pythonAllocations.store(0, std::memory_order_relaxed);
+			counters.vtkCpu.store(0, std::memory_order_relaxed);
+			counters.total.Reset();
+			counters.marshal.Reset();
+			counters.python.Reset();
+			counters.vtk.Reset();
+		}
+	}
+}
+
+
+static void PyVtk_WriteLatency(
+	FILE *pFile,
+	LPCSTR name,
+	const PyVtk_Latency &latency,
+	bool json)
+{
+	if (json)
+	{
+		fprintf(pFile, ", \"%s\": { \"sum\": %llu, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"max\": %llu }",
+			name, latency.sum, latency.p50, latency.p90, latency.p99, latency.max);
+	}
+	else
+	{
+		fprintf(pFile, "\t%llu\t%llu\t%llu\t%llu\t%llu", latency.sum, latency.p50, latency.p90, latency.p99, latency.max);
+	}
+}
+
+/*
+ * Writes one snapshot of the entry points that were called. JSON snapshots take
+ * one line each; text ones are a tab separated table under a timestamp line.
+ */
+static void PyVtk_WriteInstrumentation(
+	FILE *pFile,
+	bool json)
+{
+	PyVtk_EntryStats stats[PYVTK_ENTRY_COUNT];
+	size_t count = PyVtk_GetInstrumentation(stats, PYVTK_ENTRY_COUNT);
+	long long timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+
+	if (json)
+	{
+		fprintf(pFile, "{ \"timestamp\": %lld, \"entries\": [", timestamp);
+	}
+	else
+	{
+		fprintf(pFile, "# %lld\n", timestamp);
+	}
+
+	bool first = true;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const PyVtk_EntryStats &entry = stats[i];
+		if (entry.calls == 0)
+		{
+			continue;
+		}
+
+		if (json)
+		{
+			fprintf(pFile, "%s{ \"name\": \"%s\", \"calls\": %llu, \"gilWait\": %llu, \"pythonAllocations\": %llu, \"vtkCpu\": %llu",
+				first ? " " : ", ", entry.name, entry.calls, entry.gilWait, entry.pythonAllocations, entry.vtkCpu);
+		}
+		else
+		{
+			fprintf(pFile, "%s\t%llu\t%llu\t%llu\t%llu", entry.name, entry.calls, entry.gilWait, entry.pythonAllocations, entry.vtkCpu);
+		}
+		PyVtk_WriteLatency(pFile, "total", entry.total, json);
+		PyVtk_WriteLatency(pFile, "marshal", entry.marshal, json);
+		PyVtk_WriteLatency(pFile, "python", entry.python, json);
+		PyVtk_WriteLatency(pFile, "vtk", entry.vtk, json);
+		fprintf(pFile, json ? " }" : "\n");
+		first = false;
+	}
+
+	if (json)
+	{
+		fprintf(pFile, " ] }\n");
+	}
+	fflush(pFile);
+}
+
+
+/*
+ * Background thread writing a snapshot of the instrumentation periodically.
+ */
+static std::thread instrumentationExporter;
+static std::atomic<bool> instrumentationExporterRunning(false);
+
+
+bool PyVtk_StartInstrumentationExport(
+	LPCSTR path,
+	unsigned int intervalMilliseconds,
+	bool json)
+{
+	if (instrumentationExporterRunning)
+	{
+		return false;
+	}
+
+	FILE *pFile = fopen(path, "a");
+	if (pFile == NULL)
+	{
+		PyVtk_PushError(PYVTK_E_ARGUMENT, NULL, "PyVtk_StartInstrumentationExport", path);
+		return false;
+	}
+
+	instrumentationExporterRunning = true;
+	instrumentationExporter = std::thread([pFile, intervalMilliseconds, json]()
+	{
+		std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+		while (instrumentationExporterRunning)
+		{
+			if (std::chrono::steady_clock::now() >= next)
+			{
+				PyVtk_WriteInstrumentation(pFile, json);
+				next = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(1u, intervalMilliseconds));
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+
+		/* A last snapshot with everything up to the stop. */
+		PyVtk_WriteInstrumentation(pFile, json);
+		fclose(pFile);
+	});
+
+	return true;
+}
+
+
+void PyVtk_StopInstrumentationExport()
+{
+	if (instrumentationExporterRunning)
+	{
+		instrumentationExporterRunning = false;
+		instrumentationExporter.join();
+	}
+}
+
+
+/*
+ * Call recording. While enabled, every outermost call into the API is appended
+ * to a binary file with its arguments, the handles of the objects involved, its
+ * start time and its duration, so that a session can be replayed offline with
+ * PyVtk_ReplayRecording. Integers are written as LEB128 varints. Objects are
+ * written as small ids; the first time an id appears it carries the class name
+ * of the object, and an id is forgotten once its object is deleted, so reused
+ * addresses get a fresh one.
+ *
+ * A record is the entry id, the start relative to the recording, the duration,
+ * then typed items, each introduced by its kind, and a 0 kind ending it.
+ */
+static const char recordingMagic[8] = { 'P', 'Y', 'V', 'T', 'K', 'R', 'E', 'C' };
+static const unsigned int recordingVersion = 1;
+
+enum PyVtk_RecordItem
+{
+	PYVTK_ITEM_END = 0,
+	PYVTK_ITEM_STRING,
+	PYVTK_ITEM_NUMBER,
+	PYVTK_ITEM_HANDLE,
+	PYVTK_ITEM_STRINGS,
+	PYVTK_ITEM_HANDLES,
+	PYVTK_ITEM_RESULT
+};
+
+static std::mutex recordingMutex;
+static std::atomic<bool> recordingCalls(false);
+static FILE *pRecording = NULL;
+static unsigned long long recordingStart = 0;
+static std::unordered_map<const void *, unsigned long long> recordedHandles;
+static unsigned long long nextRecordedHandle = 1;
+static thread_local bool insideRecordedCall = false;
+
+static void PyVtk_PutVarint(
+	FILE *pFile,
+	unsigned long long value)
+{
+	do
+	{
+		unsigned char byte = value & 0x7f;
+		value >>= 7;
+		fputc(byte | (value != 0 ? 0x80 : 0), pFile);
+	} while (value != 0);
+}
+
+static void PyVtk_PutString(
+	FILE *pFile,
+	LPCSTR str)
+{
+	/* 0 stands for NULL, so lengths are shifted by one. */
+	size_t len = str != NULL ? strlen(str) : 0;
+	PyVtk_PutVarint(pFile, str != NULL ? len + 1 : 0);
+	fwrite(str, 1, len, pFile);
+}
+
+static void PyVtk_PutHandle(
+	FILE *pFile,
+	const void *pHandle,
+	LPCSTR className)
+{
+	if (pHandle == NULL)
+	{
+		PyVtk_PutVarint(pFile, 0);
+		return;
+	}
+
+	auto iHandle = recordedHandles.find(pHandle);
+	if (iHandle != recordedHandles.end())
+	{
+		PyVtk_PutVarint(pFile, iHandle->second << 1);
+		return;
+	}
+
+	unsigned long long id = nextRecordedHandle++;
+	recordedHandles.insert(std::make_pair(pHandle, id));
+	PyVtk_PutVarint(pFile, (id << 1) | 1);
+	PyVtk_PutString(pFile, className);
+}
+
+
+/*
+ * Collects the arguments of an entry point while it runs and writes its record
+ * when it returns. Arguments are kept by pointer, as they outlive the call.
+ */
+class PyVtk_CallRecord
+{
+public:
+	explicit PyVtk_CallRecord(PyVtk_Entry entry)
+		: entry(entry), active(recordingCalls && !insideRecordedCall), argumentCount(0),
+		pResult(NULL), resultClass(NULL)
+	{
+		if (active)
+		{
+			insideRecordedCall = true;
+			start = PyVtk_Now();
+		}
+	}
+
+	~PyVtk_CallRecord()
+	{
+		if (!active)
+		{
+			return;
+		}
+
+		unsigned long long end = PyVtk_Now();
+		insideRecordedCall = false;
+
+		std::lock_guard<std::mutex> lock(recordingMutex);
+		if (pRecording == NULL)
+		{
+			return;
+		}
+
+		PyVtk_PutVarint(pRecording, entry);
+		PyVtk_PutVarint(pRecording, start > recordingStart ? start - recordingStart : 0);
+		PyVtk_PutVarint(pRecording, end - start);
+		for (size_t i = 0; i < argumentCount; ++i)
+		{
+			const Item &item = arguments[i];
+			PyVtk_PutVarint(pRecording, item.kind);
+			switch (item.kind)
+			{
+			case PYVTK_ITEM_STRING:
+				PyVtk_PutString(pRecording, (LPCSTR) item.pValue);
+				break;
+			case PYVTK_ITEM_NUMBER:
+				PyVtk_PutVarint(pRecording, item.number);
+				break;
+			case PYVTK_ITEM_HANDLE:
+				PyVtk_PutHandle(pRecording, item.pValue, item.className);
+				break;
+			case PYVTK_ITEM_STRINGS:
+			{
+				const std::vector<LPCSTR> &strings = *(const std::vector<LPCSTR> *) item.pValue;
+				PyVtk_PutVarint(pRecording, strings.size());
+				for (LPCSTR str : strings)
+				{
+					PyVtk_PutString(pRecording, str);
+				}
+				break;
+			}
+			case PYVTK_ITEM_HANDLES:
+			{
+				const std::vector<vtkObjectBase *> &handles = *(const std::vector<vtkObjectBase *> *) item.pValue;
+				PyVtk_PutVarint(pRecording, handles.size());
+				for (vtkObjectBase *pHandle : handles)
+				{
+					PyVtk_PutHandle(pRecording, pHandle, pHandle != NULL ? pHandle->GetClassName() : NULL);
+				}
+				break;
+			}
+			default:
+				break;
+			}
+		}
+
+		PyVtk_PutVarint(pRecording, PYVTK_ITEM_RESULT);
+		PyVtk_PutHandle(pRecording, pResult, resultClass);
+		PyVtk_PutVarint(pRecording, PYVTK_ITEM_END);
+
+		for (const void *pHandle : forgotten)
+		{
+			recordedHandles.erase(pHandle);
+		}
+	}
+
+	PyVtk_CallRecord &String(LPCSTR str)
+	{
+		return Add(PYVTK_ITEM_STRING, str, NULL, 0);
+	}
+
+	PyVtk_CallRecord &Number(unsigned long long number)
+	{
+		return Add(PYVTK_ITEM_NUMBER, NULL, NULL, number);
+	}
+
+	/* The class name is taken now, as the object may be gone by the end of the call. */
+	PyVtk_CallRecord &Handle(const vtkObjectBase *pObject)
+	{
+		return Add(PYVTK_ITEM_HANDLE, pObject, active && pObject != NULL ? pObject->GetClassName() : NULL, 0);
+	}
+
+	PyVtk_CallRecord &Handle(const PyVtk_Chain *pChain)
+	{
+		return Add(PYVTK_ITEM_HANDLE, pChain, "PyVtk_Chain", 0);
+	}
+
+	PyVtk_CallRecord &Strings(const std::vector<LPCSTR> &strings)
+	{
+		return Add(PYVTK_ITEM_STRINGS, &strings, NULL, 0);
+	}
+
+	PyVtk_CallRecord &Handles(const std::vector<vtkObjectBase *> &handles)
+	{
+		return Add(PYVTK_ITEM_HANDLES, &handles, NULL, 0);
+	}
+
+	/* Whether the call is recorded, for arguments that need encoding first. */
+	bool Active() const
+	{
+		return active;
+	}
+
+	/* The handle of an object deleted by the call, whose id is to be dropped. */
+	void Forget(const void *pHandle)
+	{
+		forgotten.push_back(pHandle);
+	}
+
+	template<typename T>
+	T *Result(T *pObject)
+	{
+		if (active && pObject != NULL)
+		{
+			pResult = pObject;
+			resultClass = pObject->GetClassName();
+		}
+		return pObject;
+	}
+
+	PyVtk_Chain *Result(PyVtk_Chain *pChain)
+	{
+		if (active && pChain != NULL)
+		{
+			pResult = pChain;
+			resultClass = "PyVtk_Chain";
+		}
+		return pChain;
+	}
+
+private:
+	struct Item
+	{
+		PyVtk_RecordItem kind;
+		const void *pValue;
+		LPCSTR className;
+		unsigned long long number;
+	};
+
+	PyVtk_CallRecord &Add(PyVtk_RecordItem kind, const void *pValue, LPCSTR className, unsigned long long number)
+	{
+		if (active && argumentCount < MaxItems)
+		{
+			Item &item = arguments[argumentCount++];
+			item.kind = kind;
+			item.pValue = pValue;
+			item.className = className;
+			item.number = number;
+		}
+		return *this;
+	}
+
+	static const size_t MaxItems = 8;
+
+	PyVtk_Entry entry;
+	bool active;
+	unsigned long long start;
+	Item arguments[MaxItems];
+	size_t argumentCount;
+	const void *pResult;
+	LPCSTR resultClass;
+	std::vector<const void *> forgotten;
+};
+
+
+bool PyVtk_StartRecording(
+	LPCSTR path)
+{
+	std::lock_guard<std::mutex> lock(recordingMutex);
+	if (pRecording != NULL)
+	{
+		return false;
+	}
+
+	pRecording = fopen(path, "wb");
+	if (pRecording == NULL)
+	{
+		PyVtk_PushError(PYVTK_E_ARGUMENT, NULL, "PyVtk_StartRecording", path);
+		return false;
+	}
+
+	fwrite(recordingMagic, 1, sizeof(recordingMagic), pRecording);
+	PyVtk_PutVarint(pRecording, recordingVersion);
+
+	recordedHandles.clear();
+	nextRecordedHandle = 1;
+	recordingStart = PyVtk_Now();
+	recordingCalls = true;
+	return true;
+}
+
+
+void PyVtk_StopRecording()
+{
+	recordingCalls = false;
+
+	std::lock_guard<std::mutex> lock(recordingMutex);
+	if (pRecording != NULL)
+	{
+		fclose(pRecording);
+		pRecording = NULL;
+	}
+	recordedHandles.clear();
+}
+
+
+/*
+ * Output window installed in place of VTK's default one. It does not display
+ * anything: the errors and warnings it receives reach the error ring through the
+ * observers below. The Python ErrorObserver is only attached while the class tree
+ * checks an input connection.
+ */
+class PyVtk_OutputWindow : public vtkOutputWindow
+{
+public:
+	static PyVtk_OutputWindow *New();
+	vtkTypeMacro(PyVtk_OutputWindow, vtkOutputWindow);
+
+	void DisplayText(const char *) override
+	{
+	}
+
+protected:
+	PyVtk_OutputWindow()
+	{
+	}
+};
+
+vtkStandardNewMacro(PyVtk_OutputWindow);
+
+
+static void PyVtk_OutputWindowEvent(
+	vtkObject *pCaller,
+	unsigned long eventId,
+	void *pClientData,
+	void *pCallData)
+{
+	PyVtk_RecordError(eventId == vtkCommand::ErrorEvent ? PYVTK_E_VTK_ERROR : PYVTK_E_VTK_WARNING,
+		NULL, "vtkOutputWindow", (const char *) pCallData);
+}
+
+
+/*
+ * Installed once per process: Introspectors keep a reference to the window they
+ * found, and a replaced one would no longer receive any event.
+ */
+static void PyVtk_InstallOutputWindow()
+{
+	static bool installed = false;
+	if (installed)
+	{
+		return;
+	}
+	installed = true;
+
+	vtkSmartPointer<PyVtk_OutputWindow> pOutputWindow = vtkSmartPointer<PyVtk_OutputWindow>::New();
+	vtkSmartPointer<vtkCallbackCommand> pCallback = vtkSmartPointer<vtkCallbackCommand>::New();
+	pCallback->SetCallback(PyVtk_OutputWindowEvent);
+	pOutputWindow->AddObserver(vtkCommand::ErrorEvent, pCallback);
+	pOutputWindow->AddObserver(vtkCommand::WarningEvent, pCallback);
+	vtkOutputWindow::SetInstance(pOutputWindow);
+}
+
+
+/*
+ * Property writes held back while coalescing is enabled. Each object keeps one
+ * entry per property, and a later write to the same property overwrites the
+ * earlier one, so a burst of writes costs a single Python call per property.
+ * Entries are reused across flushes, keeping the steady state allocation-free.
+ */
+struct PyVtk_PendingWrite
+{
+	std::string propertyName;
+	std::string format;
+	std::string value;
+	bool pending;
+};
+
+static std::unordered_map<vtkObjectBase *, std::vector<PyVtk_PendingWrite>> pendingWrites;
+static size_t pendingCount = 0;
+static bool coalescing = false;
+static std::chrono::steady_clock::duration coalescingTick;
+static std::chrono::steady_clock::time_point lastFlush;
+
+
+/*
+ * Sends every pending property write to Python in one batch.
+ */
+static bool PyVtk_FlushWrites(
+	PyObject *pIntrospector)
+{
+	lastFlush = std::chrono::steady_clock::now();
+	if (pendingCount == 0)
+	{
+		return true;
+	}
+
+	PyObject *pWrites = PyList_New(pendingCount);
+	if (pWrites == NULL)
+	{
+		PyVtk_Error(PYVTK_E_PYTHON, NULL, "setVtkObjectAttributes", "Unable to create a list of size %zu", pendingCount);
+		return false;
+	}
+
+	size_t i = 0;
+	for (auto &object : pendingWrites)
+	{
+		auto iNode = nodes.find(object.first);
+		for (auto &write : object.second)
+		{
+			if (!write.pending)
+			{
+				continue;
+			}
+			write.pending = false;
+
+			/* Writes are only queued for registered objects, and dropped on deletion. */
+			PyObject *pWrite = Py_BuildValue("(Osss)", iNode->second,
+				write.propertyName.c_str(), write.format.c_str(), write.value.c_str());
+			if (pWrite == NULL)
+			{
+				pWrite = Py_None;
+				Py_INCREF(pWrite);
+			}
+			PyList_SET_ITEM(pWrites, i++, pWrite);
+		}
+	}
+	pendingCount = 0;
+
+	PyObject *pCheck = PyVtk_CallPython(pIntrospector, "setVtkObjectAttributes", "(O)", pWrites);
+	Py_DECREF(pWrites);
+	if (pCheck == NULL)
+	{
+		PyVtk_Error(PYVTK_E_PYTHON, NULL, "setVtkObjectAttributes", "Cannot set the pending VTK object attributes");
+		return false;
+	}
+	Py_DECREF(pCheck);
+
+	return true;
+}
+
+
+bool PyVtk_FlushProperties(
+	PyObject *pIntrospector)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_FLUSH_PROPERTIES);
+	PyVtk_CallRecord record(PYVTK_ENTRY_FLUSH_PROPERTIES);
+
+	return PyVtk_FlushWrites(pIntrospector);
+}
+
+
+/*
+ * Enables or disables coalescing of property writes. While enabled, writes are
+ * flushed once tickMilliseconds have passed since the last flush, and always
+ * before anything reads from or executes the pipeline. A tick of 0 only flushes
+ * on those reads. Disabling flushes what is pending.
+ */
+void PyVtk_SetCoalescing(
+	PyObject *pIntrospector,
+	bool enabled,
+	unsigned int tickMilliseconds)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_SET_COALESCING);
+	PyVtk_CallRecord record(PYVTK_ENTRY_SET_COALESCING);
+	record.Number(enabled ? 1 : 0).Number(tickMilliseconds);
+
+	if (!enabled)
+	{
+		PyVtk_FlushProperties(pIntrospector);
+	}
+
+	coalescing = enabled;
+	coalescingTick = std::chrono::milliseconds(tickMilliseconds);
+	lastFlush = std::chrono::steady_clock::now();
+}
+
+
+/*
+ * Queues a write while coalescing, flushing the batch when the tick is due.
+ */
+static bool PyVtk_CoalesceProperty(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	LPCSTR propertyName,
+	LPCSTR format,
+	LPCSTR newValue)
+{
+	std::vector<PyVtk_PendingWrite> &writes = pendingWrites[pVtkObject];
+
+	PyVtk_PendingWrite *pWrite = NULL;
+	for (auto &write : writes)
+	{
+		if (write.propertyName == propertyName)
+		{
+			pWrite = &write;
+			break;
+		}
+	}
+
+	if (pWrite == NULL)
+	{
+		writes.push_back(PyVtk_PendingWrite());
+		pWrite = &writes.back();
+		pWrite->propertyName = propertyName;
+		pWrite->pending = false;
+	}
+
+	/* Latest write wins. */
+	pWrite->format = format;
+	pWrite->value = newValue;
+	if (!pWrite->pending)
+	{
+		pWrite->pending = true;
+		++pendingCount;
+	}
+
+	if (coalescingTick.count() > 0 && std::chrono::steady_clock::now() - lastFlush >= coalescingTick)
+	{
+		return PyVtk_FlushProperties(pIntrospector);
+	}
+
+	return true;
+}
+
+
+/*
+ * Drops the pending writes of an object that is going away.
+ */
+static void PyVtk_DiscardPending(
+	vtkObjectBase *pVtkObject)
+{
+	auto iWrites = pendingWrites.find(pVtkObject);
+	if (pendingWrites.end() != iWrites)
+	{
+		for (auto &write : iWrites->second)
+		{
+			if (write.pending)
+			{
+				--pendingCount;
+			}
+		}
+		pendingWrites.erase(iWrites);
+	}
+}
+
+
+/*
+ * Direct dispatch of the properties and methods listed in PyVtkFastPath.h. They
+ * are called on the registered VTK object itself, with the values parsed and
+ * printed here the way the Introspector would, so both paths give the same
+ * results. A call that does not fit its entry, such as a value of another
+ * format, takes the Python path, which reports whatever is wrong with it.
+ */
+struct PyVtk_FastProperty
+{
+	LPCSTR className;
+	LPCSTR name;
+	char format;
+	size_t size;
+	void (*set)(vtkObjectBase *pVtkObject, double *values, LPCSTR str);
+	void (*get)(vtkObjectBase *pVtkObject, double *values, LPCSTR *pStr);
+};
+
+struct PyVtk_FastMethod
+{
+	LPCSTR className;
+	LPCSTR name;
+	void (*call)(vtkObjectBase *pVtkObject);
+};
+
+#define PYVTK_FAST_SCALAR(cls, prop, fmt) \
+	{ #cls, #prop, fmt, 0, \
+		[](vtkObjectBase *p, double *v, LPCSTR) { \
+			static_cast<cls *>(p)->Set##prop((decltype(static_cast<cls *>(p)->Get##prop())) v[0]); }, \
+		[](vtkObjectBase *p, double *v, LPCSTR *) { v[0] = (double) static_cast<cls *>(p)->Get##prop(); } },
+#define PYVTK_FAST_VECTOR(cls, prop, n) \
+	{ #cls, #prop, 'f', n, \
+		[](vtkObjectBase *p, double *v, LPCSTR) { static_cast<cls *>(p)->Set##prop(v); }, \
+		[](vtkObjectBase *p, double *v, LPCSTR *) { memcpy(v, static_cast<cls *>(p)->Get##prop(), n * sizeof(double)); } },
+#define PYVTK_FAST_STRING(cls, prop) \
+	{ #cls, #prop, 's', 0, \
+		[](vtkObjectBase *p, double *, LPCSTR s) { static_cast<cls *>(p)->Set##prop(s); }, \
+		[](vtkObjectBase *p, double *, LPCSTR *s) { *s = static_cast<cls *>(p)->Get##prop(); } },
+#define PYVTK_FAST_METHOD(cls, method) \
+	{ #cls, #method, [](vtkObjectBase *p) { static_cast<cls *>(p)->method(); } },
+
+static const PyVtk_FastProperty fastProperties[] = {
+	PYVTK_FAST_PROPERTIES(PYVTK_FAST_SCALAR, PYVTK_FAST_VECTOR, PYVTK_FAST_STRING)
+};
+
+static const PyVtk_FastMethod fastMethods[] = {
+	PYVTK_FAST_METHODS(PYVTK_FAST_METHOD)
+};
+
+#undef PYVTK_FAST_SCALAR
+#undef PYVTK_FAST_VECTOR
+#undef PYVTK_FAST_STRING
+#undef PYVTK_FAST_METHOD
+
+/* Largest vector a fast property may have. */
+static const size_t fastVectorSize = 4;
+
+static bool fastPath = true;
+
+
+/*
+ * Enables or disables direct dispatch, which is enabled by default.
+ */
+void PyVtk_SetFastPath(
+	bool enabled)
+{
+	fastPath = enabled;
+}
+
+
+/*
+ * The tables are short, so they are scanned rather than hashed, which keeps the
+ * lookups free of allocations.
+ */
+static const PyVtk_FastProperty *PyVtk_FindFastProperty(
+	vtkObjectBase *pVtkObject,
+	LPCSTR propertyName)
+{
+	if (!fastPath || pVtkObject == NULL || propertyName == NULL)
+	{
+		return NULL;
+	}
+
+	LPCSTR className = pVtkObject->GetClassName();
+	for (const PyVtk_FastProperty &property : fastProperties)
+	{
+		if (strcmp(property.name, propertyName) == 0 && strcmp(property.className, className) == 0)
+		{
+			return property.size <= fastVectorSize ? &property : NULL;
+		}
+	}
+	return NULL;
+}
+
+static const PyVtk_FastMethod *PyVtk_FindFastMethod(
+	vtkObjectBase *pVtkObject,
+	LPCSTR method)
+{
+	if (!fastPath || pVtkObject == NULL || method == NULL)
+	{
+		return NULL;
+	}
+
+	LPCSTR className = pVtkObject->GetClassName();
+	for (const PyVtk_FastMethod &fastMethod : fastMethods)
+	{
+		if (strcmp(fastMethod.name, method) == 0 && strcmp(fastMethod.className, className) == 0)
+		{
+			return &fastMethod;
+		}
+	}
+	return NULL;
+}
+
+
+/*
+ * Parses a value the way decodeValue of the Introspector does: a single value,
+ * or the given number of comma separated ones, optionally in brackets. Returns
+ * false if the format or the value does not fit the property.
+ */
+static bool PyVtk_ParseFastValue(
+	const PyVtk_FastProperty *pProperty,
+	LPCSTR format,
+	LPCSTR value,
+	double *values)
+{
+	char kind = (char) tolower((unsigned char) format[0]);
+	size_t size = format[0] != '\0' && format[1] != '\0' ? (size_t) atoi(format + 1) : 0;
+	if (size != pProperty->size || (pProperty->format == 's') != (kind == 's'))
+	{
+		return false;
+	}
+	if (kind == 's')
+	{
+		return true;
+	}
+	if ((kind != 'f' && kind != 'd') || (pProperty->format == 'd' && kind != 'd'))
+	{
+		return false;
+	}
+
+	LPCSTR p = value;
+	while (size > 0 && (*p == '(' || *p == '[' || isspace((unsigned char) *p)))
+	{
+		++p;
+	}
+	for (size_t i = 0; i < std::max(size, (size_t) 1); ++i)
+	{
+		char *end;
+		values[i] = kind == 'f' ? strtod(p, &end) : (double) strtoll(p, &end, 10);
+		if (end == p)
+		{
+			return false;
+		}
+
+		/* strtod also takes hexadecimal, inf and nan forms; only plain decimals
+		   are sure to read as Python's float() reads them. */
+		while (isspace((unsigned char) *p))
+		{
+			++p;
+		}
+		if (kind == 'f' && strspn(p, "+-.0123456789eE") < (size_t) (end - p))
+		{
+			return false;
+		}
+		p = end;
+		while (isspace((unsigned char) *p) || (size > 0 && (*p == ',' || *p == ')' || *p == ']')))
+		{
+			++p;
+		}
+	}
+
+	/* Anything left is not a number Python would accept. */
+	return *p == '\0';
+}
+
+
+/*
+ * Prints a double as Python's str() does.
+ */
+static bool PyVtk_AppendDouble(
+	std::string *pStr,
+	double value)
+{
+	char *repr = PyOS_double_to_string(value, 'r', 0, Py_DTSF_ADD_DOT_0, NULL);
+	if (repr == NULL)
+	{
+		PyErr_Clear();
+		return false;
+	}
+	pStr->append(repr);
+	PyMem_Free(repr);
+	return true;
+}
+
+
+/*
+ * Reads a fast property into the scratch arena as "expectedType::value", the
+ * value printed as the Introspector's str() of it would be.
+ */
+static LPCSTR PyVtk_GetFastProperty(
+	const PyVtk_FastProperty *pProperty,
+	vtkObjectBase *pVtkObject,
+	LPCSTR expectedType)
+{
+	double values[fastVectorSize];
+	LPCSTR str = NULL;
+	pProperty->get(pVtkObject, values, &str);
+
+	/* Reused per thread, so it stops allocating once grown. */
+	static thread_local std::string text;
+	text.assign(expectedType);
+	text.append("::");
+	if (pProperty->format == 's')
+	{
+		text.append(str != NULL ? str : "None");
+	}
+	else if (pProperty->size == 0)
+	{
+		if (pProperty->format == 'f')
+		{
+			PyVtk_AppendDouble(&text, values[0]);
+		}
+		else
+		{
+			char number[32];
+			snprintf(number, sizeof(number), "%lld", (long long) values[0]);
+			text.append(number);
+		}
+	}
+	else
+	{
+		text.append("(");
+		for (size_t i = 0; i < pProperty->size; ++i)
+		{
+			text.append(i > 0 ? ", " : "");
+			PyVtk_AppendDouble(&text, values[i]);
+		}
+		text.append(")");
+	}
+
+	return scratch.CopyString(text.c_str());
+}
+
+
+/*
+ * Drops a pending write of a property that is about to be written directly, as
+ * the direct write is the later one.
+ */
+static void PyVtk_DiscardPendingProperty(
+	vtkObjectBase *pVtkObject,
+	LPCSTR propertyName)
+{
+	auto iWrites = pendingWrites.find(pVtkObject);
+	if (pendingWrites.end() == iWrites)
+	{
+		return;
+	}
+
+	for (auto &write : iWrites->second)
+	{
+		if (write.pending && write.propertyName == propertyName)
+		{
+			write.pending = false;
+			--pendingCount;
+		}
+	}
+}
+
+
+/*
+ * Frozen modules. Builds with PYVTK_FROZEN_MODULES carry the embedding modules
+ * as bytecode generated by freeze.py, appended to the modules Python freezes
+ * itself, so that they are imported from memory by its frozen importer instead
+ * of being looked up on sys.path, which then goes without the working
+ * directory and its parent that source builds need. Only the modules are
+ * embedded: the Introspector still reads categories.txt, categoriesMapping.txt
+ * and classIndex.json from the working directory.
+ */
+#ifdef PYVTK_FROZEN_MODULES
+#include "PyVtkFrozen.h"
+#if (PY_VERSION_HEX >> 16) != PYVTK_FROZEN_PYTHON
+#error "The frozen modules were compiled for another version of Python"
+#endif
+
+static std::vector<struct _frozen> frozenModules;
+#endif
+
+static void PyVtk_RegisterFrozenModules()
+{
+#ifdef PYVTK_FROZEN_MODULES
+	if (!frozenModules.empty())
+	{
+		return;
+	}
+
+	for (const struct _frozen *pModule = PyImport_FrozenModules; pModule->name != NULL; ++pModule)
+	{
+		frozenModules.push_back(*pModule);
+	}
+	for (const struct _frozen &module : pyvtkFrozenModules)
+	{
+		frozenModules.push_back(module);
+	}
+
+	struct _frozen terminator;
+	memset(&terminator, 0, sizeof(terminator));
+	frozenModules.push_back(terminator);
+	PyImport_FrozenModules = frozenModules.data();
+#endif
+}
+
+
+/*
+ * Directories the embedding modules are looked up in, the working directory and
+ * its parent, as both the "." and cwd notations may change once built in a DLL.
+ */
+static std::vector<std::wstring> PyVtk_ModulePaths()
+{
+	std::vector<std::wstring> paths;
+#ifndef PYVTK_FROZEN_MODULES
+	std::wstring cwd(GetCurrentDirectoryW(0, NULL), L'\0');
+	cwd.resize(GetCurrentDirectoryW((DWORD) cwd.size(), &cwd[0]));
+
+	/* The parent keeps its separator when it is a root, as os.path.dirname does. */
+	size_t separator = cwd.find_last_of(L"\\/");
+	if (separator != std::wstring::npos)
+	{
+		bool root = separator == 0 || cwd[separator - 1] == L':';
+		paths.push_back(cwd.substr(0, root ? separator + 1 : separator));
+	}
+	paths.push_back(L".");
+#endif
+	return paths;
+}
+
+
+static unsigned long long initPhases[4];
+static bool initFrozen = false;
+
+PyVtk_InitStats PyVtk_GetInitStats()
+{
+	PyVtk_InitStats stats;
+	stats.initialize = initPhases[0];
+	stats.paths = initPhases[1];
+	stats.imports = initPhases[2];
+	stats.instantiate = initPhases[3];
+	stats.frozenModules = initFrozen;
+	return stats;
+}
+
+
+/*
+ * Initializes Python interpreter and the Introspection object. Later sessions
+ * share the interpreter the first one set up.
+ */
+PyObject *PyVtk_InitIntrospector()
+{
+	PyVtk_InitOptions options = { false, NULL };
+	return PyVtk_InitIntrospectorWithOptions(&options);
+}
+
+
+PyObject *PyVtk_InitIntrospectorWithOptions(
+	const PyVtk_InitOptions *pOptions)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_INIT);
+	unsigned long long phaseStart = PyVtk_Now();
+
+	/* Initializing Python environment, with the module paths set up front where the
+	   configuration API allows it. */
+	PyVtk_RegisterFrozenModules();
+	std::vector<std::wstring> modulePaths = PyVtk_ModulePaths();
+	bool initialized = Py_IsInitialized() != 0;
+	bool pathsConfigured = false;
+	if (!initialized)
+	{
+		PyVtk_PythonScope python;
+#if PY_VERSION_HEX >= 0x03080000
+		PyConfig config;
+		PyConfig_InitPythonConfig(&config);
+		PyStatus status = PyConfig_Read(&config);
+
+		/* Up to Python 3.10 reading the configuration computes the search path,
+		   which the module paths are appended to. Later versions only compute it
+		   while initializing, so the paths are appended to sys.path below instead
+		   of replacing the standard library. */
+		if (!PyStatus_Exception(status) && config.module_search_paths_set)
+		{
+			for (size_t i = 0; !PyStatus_Exception(status) && i < modulePaths.size(); ++i)
+			{
+				status = PyWideStringList_Append(&config.module_search_paths, modulePaths[i].c_str());
+			}
+			pathsConfigured = true;
+		}
+		if (!PyStatus_Exception(status))
+		{
+			status = Py_InitializeFromConfig(&config);
+		}
+		PyConfig_Clear(&config);
+		if (PyStatus_Exception(status))
+		{
+			PyVtk_PushError(PYVTK_E_PYTHON, NULL, "Py_InitializeFromConfig", status.err_msg != NULL ? status.err_msg : "Cannot initialize Python");
+			return NULL;
+		}
+#else
+		Py_Initialize();
+#endif
+	}
+	initPhases[0] = PyVtk_Now() - phaseStart;
+	phaseStart = PyVtk_Now();
+#if PY_VERSION_HEX < 0x03070000
+	/* Sweeps hand the GIL over to worker threads. */
+	PyEval_InitThreads();
+#endif
+
+	/* VTK errors and warnings go to the error ring instead of being displayed. */
+	PyVtk_InstallOutputWindow();
+
+	/* Counting Python allocations and timing VTK execution from now on. */
+	PyVtk_StartInstrumentation();
+
+	/* Without the search path in the configuration the paths go straight into
+	   sys.path, once for all sessions. */
+	bool pathsPending = !initialized && !pathsConfigured;
+	PyObject *pSysPath = pathsPending ? PySys_GetObject("path") : NULL;
+	for (size_t i = 0; pathsPending && i < modulePaths.size(); ++i)
+	{
+		PyObject *pPath = PyUnicode_FromWideChar(modulePaths[i].c_str(), (Py_ssize_t) modulePaths[i].size());
+		if (pSysPath == NULL || pPath == NULL || PyList_Append(pSysPath, pPath) != 0)
+		{
+			Py_XDECREF(pPath);
+			PyVtk_Error(PYVTK_E_PYTHON, NULL, "sys.path", "Cannot set the module paths");
+			return NULL;
+		}
+		Py_DECREF(pPath);
+	}
+	initPhases[1] = PyVtk_Now() - phaseStart;
+	phaseStart = PyVtk_Now();
+
+	/* The import mode of VTK has to be chosen before the Introspector modules import it. */
+	if (pOptions->lazyImports)
+	{
+		PyObject *pLoader;
+		{
+			PyVtk_PythonScope python("import vtkLoader");
+			pLoader = PyImport_ImportModule("vtkLoader");
+		}
+		PyObject *pCheck = pLoader != NULL
+			? PyVtk_CallPython(pLoader, "configure", "Os", Py_True, pOptions->classModules != NULL ? pOptions->classModules : "classModules.json")
+			: NULL;
+		Py_XDECREF(pLoader);
+		if (pCheck == NULL)
+		{
+			PyVtk_Error(PYVTK_E_PYTHON, NULL, "vtkLoader", "Cannot configure lazy imports");
+			return NULL;
+		}
+		Py_DECREF(pCheck);
+	}
+
+	/* Decode module from its name. Returns error if the name is not decodable. */
+	PyObject *pIntrospectorModuleName = PyUnicode_DecodeFSDefault("Introspector");
+	if (pIntrospectorModuleName == NULL)
+	{
+		PyVtk_Error(PYVTK_E_PYTHON, NULL, "Introspector", "Fatal error: cannot decode module name");
+		return NULL;
+	}
+
+	/* Imports the module previously decoded. Returns error if the module is not found. */
+	PyObject *pIntrospectorModule;
+	{
+		PyVtk_PythonScope python("import Introspector");
+		pIntrospectorModule = PyImport_Import(pIntrospectorModuleName);
+	}
+	Py_DECREF(pIntrospectorModuleName);
+	if (pIntrospectorModule == NULL)
+	{
+		PyVtk_Error(PYVTK_E_PYTHON, NULL, "Introspector", "Failed to load \"Introspector\"");
+		return NULL;
+	}
+
+	initPhases[2] = PyVtk_Now() - phaseStart;
+	phaseStart = PyVtk_Now();
+
+	/* Looks for the Introspector class in the module. If it does not find it, returns and error. */
+	PyObject* pIntrospectorClass = PyObject_GetAttrString(pIntrospectorModule, "Introspector");
+	Py_DECREF(pIntrospectorModule);
+	if (pIntrospectorClass == NULL || !PyCallable_Check(pIntrospectorClass))
+	{
+		PyVtk_Error(PYVTK_E_PYTHON, NULL, "Introspector", "Cannot find class \"Introspector\"");
+		if (pIntrospectorClass != NULL)
+		{
+			Py_DECREF(pIntrospectorClass);
+		}
+		return NULL;
+	}
+
+	/* Instantiates an Introspector object. If the call returns NULL there was an error
+	   creating the object, and thus it returns error. The output window installed above
+	   replaces the log file of the Introspector. */
+	PyObject *pArgs = PyTuple_New(0);
+	PyObject *pKwargs = Py_BuildValue("{s:O}", "logToFile", Py_False);
+	PyObject *pIntrospector = NULL;
+	if (pArgs != NULL && pKwargs != NULL)
+	{
+		PyVtk_PythonScope python("Introspector");
+		pIntrospector = PyObject_Call(pIntrospectorClass, pArgs, pKwargs);
+	}
+	Py_XDECREF(pArgs);
+	Py_XDECREF(pKwargs);
+	Py_DECREF(pIntrospectorClass);
+	if (pIntrospector == NULL)
+	{
+		PyVtk_Error(PYVTK_E_PYTHON, NULL, "Introspector", "Introspector instantiation failed");
+		return NULL;
+	}
+	initPhases[3] = PyVtk_Now() - phaseStart;
+#ifdef PYVTK_FROZEN_MODULES
+	initFrozen = true;
+#endif
+
+	return pIntrospector;
+}
+
+
+vtkObjectBase *PyVtk_CreateVtkObject(
+	PyObject *pIntrospector,
+	const char *sVtkClassName)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_CREATE);
+	PyVtk_CallRecord record(PYVTK_ENTRY_CREATE);
+	record.String(sVtkClassName);
+
+	/* Creating the object and getting the reference. Returns error if the object could not
+       be created.*/
+	PyObject *pPyVtkObject = PyVtk_CallPython(pIntrospector, "createVtkObject", "s", sVtkClassName);
+	if (pPyVtkObject == NULL)
+	{
+		PyVtk_Error(PYVTK_E_PYTHON, NULL, "createVtkObject", "Cannot call \"createVtkObject\" on \"%s\"", sVtkClassName);
+		return NULL;
+	}
+
+	/* Retrieving vtk instance. Returns error if it cannot access the vtk instance. */
+	PyObject *pPyVtkInstance = PyObject_GetAttrString(pPyVtkObject, "vtkInstance");
+	if (pPyVtkInstance == NULL)
+	{
+		PyVtk_Error(PYVTK_E_PYTHON, NULL, "vtkInstance", "Cannot access \"vtkInstance\" of VTK wrapped object");
+		return NULL;
+	}
+
+	/* Retrieving C object from vtk instance */
+	vtkObjectBase *pVtkObject = vtkPythonUtil::GetPointerFromObject(pPyVtkInstance, sVtkClassName);
+	Py_DECREF(pPyVtkInstance);
+
+	/* Adding a node entry to the vtk objects - nodes map. */
+	PyVtk_RegisterNode(pIntrospector, pVtkObject, pPyVtkObject);
+
+	/* Execution of the object is timed as VTK time of whichever call triggers it. */
+	PyVtk_ObserveExecution(pVtkObject);
+
+	return record.Result(pVtkObject);
+}
+
+
+const char *PyVtk_GetVtkObjectProperty(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	LPCSTR propertyName,
+	LPCSTR expectedType)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_GET_PROPERTY, pVtkObject);
+	PyVtk_CallRecord record(PYVTK_ENTRY_GET_PROPERTY);
+	record.Handle(pVtkObject).String(propertyName).String(expectedType);
+
+	/* Reads and executions see every write issued before them. */
+	PyVtk_FlushProperties(pIntrospector);
+
+	/* Retriving node from registry. Returns error if the VTK object has no node. */
+	auto iNode = nodes.find(pVtkObject);
+	if (nodes.end() != iNode)
+	{
+		/* Reading straight from VTK if the property has an accessor. */
+		const PyVtk_FastProperty *pFast = PyVtk_FindFastProperty(pVtkObject, propertyName);
+		if (pFast != NULL)
+		{
+			return PyVtk_GetFastProperty(pFast, pVtkObject, expectedType);
+		}
+
+		/* Getting Python node. */
+		PyObject *pNode = iNode->second;
+		
+		/* Retrieving the property value. Returns error if there is no property with the given name. */
+		PyObject *pVal = PyVtk_CallPythonFor(pVtkObject, pIntrospector, "getVtkObjectAttribute", "Os", pNode, propertyName);
+		if (pVal == NULL)
+		{
+			PyVtk_Error(PYVTK_E_PYTHON, pVtkObject, propertyName, "Cannot access the VTK object's attribute \"%s\"", propertyName);
+			return NULL;
+		}
+
+		/* Converting the value to string. Returns error if unable to. */
+		const char* propertyValue = PyString_AsString(pVal);
+		if (propertyValue == NULL)
+		{
+			Py_DECREF(pVal);
+			PyVtk_Error(PYVTK_E_PYTHON, pVtkObject, propertyName, "Cannot convert attribute \"%s\" to string", propertyName);
+			return NULL;
+		}
+
+		/* Returning decorated version of the value, built in the scratch arena. The
+		   string is owned by the Python value, so it is copied before releasing it. */
+		size_t typeLen = strlen(expectedType);
+		size_t valueLen = strlen(propertyValue);
+		char *buffer = (char *) scratch.Allocate(typeLen + 2 + valueLen + 1);
+		if (buffer != NULL)
+		{
+			memcpy(buffer, expectedType, typeLen);
+			memcpy(buffer + typeLen, "::", 2);
+			memcpy(buffer + typeLen + 2, propertyValue, valueLen + 1);
+		}
+		Py_DECREF(pVal);
+
+		return buffer;
+	}
+	else
+	{
+		PyVtk_Error(PYVTK_E_NOT_REGISTERED, pVtkObject, propertyName, "Cannot find node");
+		return NULL;
+	}
+}
+
+
+int PyVtk_SetVtkObjectProperty(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	LPCSTR propertyName,
+	LPCSTR format,
+	LPCSTR newValue)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_SET_PROPERTY, pVtkObject);
+	PyVtk_CallRecord record(PYVTK_ENTRY_SET_PROPERTY);
+	record.Handle(pVtkObject).String(propertyName).String(format).String(newValue);
+
+	/* Retriving node from registry. Returns error if the VTK object has no node. */
+	auto iNode = nodes.find(pVtkObject);
+	if (nodes.end() != iNode)
+	{
+		/* Writing straight to VTK if the property has an accessor and the value fits it. */
+		double values[fastVectorSize];
+		const PyVtk_FastProperty *pFast = PyVtk_FindFastProperty(pVtkObject, propertyName);
+		if (pFast != NULL && format != NULL && newValue != NULL && PyVtk_ParseFastValue(pFast, format, newValue, values))
+		{
+			PyVtk_DiscardPendingProperty(pVtkObject, propertyName);
+			pFast->set(pVtkObject, values, newValue);
+			return PYVTK_OK;
+		}
+
+		/* Holding the write back until the next flush. */
+		if (coalescing)
+		{
+			return PyVtk_CoalesceProperty(pIntrospector, pVtkObject, propertyName, format, newValue) ? PYVTK_OK : PYVTK_E_PYTHON;
+		}
+
+		/* Getting Python node. */
+		PyObject *pNode = iNode->second;
+
+		/* Executing method call to set value. Returns error if the value could not be set. */
+		PyObject *pCheck = PyVtk_CallPythonFor(pVtkObject, pIntrospector, "setVtkObjectAttribute", "Osss", pNode, propertyName, format, newValue);
+		if (pCheck == NULL)
+		{
+			PyVtk_Error(PYVTK_E_PYTHON, pVtkObject, propertyName, "Cannot set the VTK object's attribute \"%s\"", propertyName);
+			return PYVTK_E_PYTHON;
+		}
+		Py_DECREF(pCheck);
+
+		return PYVTK_OK;
+	}
+	else
+	{
+		PyVtk_Error(PYVTK_E_NOT_REGISTERED, pVtkObject, propertyName, "Cannot find node");
+		return PYVTK_E_NOT_REGISTERED;
+	}
+}
+
+
+/*
+ * Takes a typed value for a fast property the way PyVtk_ParseFastValue takes
+ * its text: integer properties only from integers, and tuples of their size.
+ */
+static bool PyVtk_FastResultValue(
+	const PyVtk_FastProperty *pProperty,
+	const PyVtk_Result *pValue,
+	double *values)
+{
+	if (pProperty->format == 's')
+	{
+		return pValue->kind == PYVTK_RESULT_STRING;
+	}
+
+	bool integers = pValue->kind == PYVTK_RESULT_INT;
+	if (pValue->arity != pProperty->size || (!integers && (pValue->kind != PYVTK_RESULT_DOUBLE || pProperty->format == 'd')))
+	{
+		return false;
+	}
+	if (integers ? pValue->pIntegers == NULL : pValue->pDoubles == NULL)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < std::max(pValue->arity, (size_t) 1); ++i)
+	{
+		values[i] = integers ? (double) pValue->pIntegers[i] : pValue->pDoubles[i];
+	}
+	return true;
+}
+
+
+/*
+ * Python value of a typed value, a new reference, or NULL if it holds none.
+ */
+static PyObject *PyVtk_ResultObject(
+	const PyVtk_Result *pValue)
+{
+	switch (pValue->kind)
+	{
+	case PYVTK_RESULT_INT:
+	case PYVTK_RESULT_DOUBLE:
+	{
+		bool integers = pValue->kind == PYVTK_RESULT_INT;
+		if (integers ? pValue->pIntegers == NULL : pValue->pDoubles == NULL)
+		{
+			return NULL;
+		}
+		if (pValue->arity == 0)
+		{
+			return integers ? PyLong_FromLongLong(pValue->pIntegers[0]) : PyFloat_FromDouble(pValue->pDoubles[0]);
+		}
+
+		PyObject *pTuple = PyTuple_New(pValue->arity);
+		for (size_t i = 0; pTuple != NULL && i < pValue->arity; ++i)
+		{
+			PyObject *pItem = integers ? PyLong_FromLongLong(pValue->pIntegers[i]) : PyFloat_FromDouble(pValue->pDoubles[i]);
+			if (pItem == NULL)
+			{
+				Py_DECREF(pTuple);
+				return NULL;
+			}
+			PyTuple_SET_ITEM(pTuple, i, pItem);
+		}
+		return pTuple;
+	}
+
+	case PYVTK_RESULT_STRING:
+		if (pValue->str == NULL)
+		{
+			Py_RETURN_NONE;
+		}
+		return PyString_FromString(pValue->str);
+
+	case PYVTK_RESULT_OBJECT:
+	case PYVTK_RESULT_ARRAY:
+		if (pValue->pObject == NULL)
+		{
+			Py_RETURN_NONE;
+		}
+		return vtkPythonUtil::GetObjectFromPointer(pValue->pObject);
+
+	default:
+		return NULL;
+	}
+}
+
+
+/*
+ * Sets a property to a typed value, such as one read by PyVtk_ObjectMethodInto,
+ * without printing it to text and parsing it back. The value is written straight
+ * to VTK if the property is on the fast path, and otherwise handed to Python as
+ * it is. Writes held back by coalescing are older, so they are flushed first.
+ */
+int PyVtk_SetVtkObjectPropertyValue(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	LPCSTR propertyName,
+	const PyVtk_Result *pValue)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_SET_PROPERTY_VALUE, pVtkObject);
+	PyVtk_CallRecord record(PYVTK_ENTRY_SET_PROPERTY_VALUE);
+	record.Handle(pVtkObject).String(propertyName);
+
+	if (pValue == NULL)
+	{
+		PyVtk_Error(PYVTK_E_ARGUMENT, pVtkObject, propertyName, "No value for \"%s\"", propertyName);
+		return PYVTK_E_ARGUMENT;
+	}
+
+	/* Numbers are only printed for the recording, and exactly. */
+	std::string recorded;
+	record.Number(pValue->kind).Number(pValue->arity);
+	if (pValue->kind == PYVTK_RESULT_OBJECT || pValue->kind == PYVTK_RESULT_ARRAY)
+	{
+		record.Handle(pValue->pObject);
+	}
+	else if (pValue->kind == PYVTK_RESULT_STRING)
+	{
+		record.String(pValue->str);
+	}
+	else if (record.Active() && (pValue->kind == PYVTK_RESULT_INT ? pValue->pIntegers != NULL
+		: pValue->kind == PYVTK_RESULT_DOUBLE && pValue->pDoubles != NULL))
+	{
+		for (size_t i = 0; i < std::max(pValue->arity, (size_t) 1); ++i)
+		{
+			char number[32];
+			if (pValue->kind == PYVTK_RESULT_INT)
+			{
+				snprintf(number, sizeof(number), "%lld", pValue->pIntegers[i]);
+			}
+			else
+			{
+				snprintf(number, sizeof(number), "%.17g", pValue->pDoubles[i]);
+			}
+			recorded.append(i > 0 ? "," : "").append(number);
+		}
+		record.String(recorded.c_str());
+	}
+
+	/* Retrieving node from registry. Returns error if the VTK object has no node. */
+	auto iNode = nodes.find(pVtkObject);
+	if (nodes.end() == iNode)
+	{
+		PyVtk_Error(PYVTK_E_NOT_REGISTERED, pVtkObject, propertyName, "Cannot find node");
+		return PYVTK_E_NOT_REGISTERED;
+	}
+
+	/* Writing straight to VTK if the property has an accessor and the value fits it. */
+	double values[fastVectorSize];
+	const PyVtk_FastProperty *pFast = PyVtk_FindFastProperty(pVtkObject, propertyName);
+	if (pFast != NULL && PyVtk_FastResultValue(pFast, pValue, values))
+	{
+		PyVtk_DiscardPendingProperty(pVtkObject, propertyName);
+		pFast->set(pVtkObject, values, pValue->str);
+		return PYVTK_OK;
+	}
+
+	PyVtk_FlushProperties(pIntrospector);
+
+	PyObject *pNewValue = PyVtk_ResultObject(pValue);
+	if (pNewValue == NULL)
+	{
+		PyErr_Clear();
+		PyVtk_Error(PYVTK_E_FORMAT, pVtkObject, propertyName, "No value of that kind for \"%s\"", propertyName);
+		return PYVTK_E_FORMAT;
+	}
+
+	/* Executing method call to set value. Returns error if the value could not be set. */
+	PyObject *pCheck = PyVtk_CallPythonFor(pVtkObject, pIntrospector, "setVtkObjectValue", "OsO", iNode->second, propertyName, pNewValue);
+	Py_DECREF(pNewValue);
+	if (pCheck == NULL)
+	{
+		PyVtk_Error(PYVTK_E_PYTHON, pVtkObject, propertyName, "Cannot set the VTK object's attribute \"%s\"", propertyName);
+		return PYVTK_E_PYTHON;
+	}
+	Py_DECREF(pCheck);
+
+	return PYVTK_OK;
+}
+
+
+const char *PyVtk_GetVtkObjectDescriptor(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_GET_DESCRIPTOR, pVtkObject);
+	PyVtk_CallRecord record(PYVTK_ENTRY_GET_DESCRIPTOR);
+	record.Handle(pVtkObject);
+
+	/* Reads and executions see every write issued before them. */
+	PyVtk_FlushProperties(pIntrospector);
+
+	auto iNode = nodes.find(pVtkObject);
+	if (nodes.end() != iNode)
+	{
+		/* Getting Python node. */
+		PyObject *pNode = iNode->second;
+
+		/* Retrieving the descriptor. Returns error if the descriptor could not be built. */
+		PyObject *pDescriptor = PyVtk_CallPythonFor(pVtkObject, pIntrospector, "getVtkObjectDescriptor", "O", pNode);
+		if (pDescriptor == NULL)
+		{
+			PyVtk_Error(PYVTK_E_PYTHON, pVtkObject, "getVtkObjectDescriptor", "Cannot access the VTK object's descriptor");
+			return NULL;
+		}
+
+		/* Converting the value to string. Returns error if unable to. */
+		PyObject *pDescriptorStr = PyObject_Str(pDescriptor);
+		Py_DECREF(pDescriptor);
+		const char* descriptor = pDescriptorStr != NULL ? PyString_AsString(pDescriptorStr) : NULL;
+		if (descriptor == NULL)
+		{
+			Py_XDECREF(pDescriptorStr);
+			PyVtk_Error(PYVTK_E_PYTHON, pVtkObject, "getVtkObjectDescriptor", "Cannot convert descriptor to string");
+			return NULL;
+		}
+
+		/* Copying out of the Python string before releasing it. */
+		LPCSTR result = scratch.CopyString(descriptor);
+		Py_DECREF(pDescriptorStr);
+
+		return result;
+	}
+	else
+	{
+		PyVtk_Error(PYVTK_E_NOT_REGISTERED, pVtkObject, NULL, "Cannot find node");
+		return NULL;
+	}
+}
+
+
+/*
+ * Searches the class index of the Introspector. The names found, at most limit
+ * of them unless it is 0, are returned in pNames and live in the scratch arena
+ * as the other results; the number found is returned, or -1 after an error.
+ */
+static LPCSTR const classQueryModes[] = { "prefix", "substring", "property" };
+
+long PyVtk_FindVtkClasses(
+	PyObject *pIntrospector,
+	LPCSTR query,
+	PyVtk_ClassQuery mode,
+	size_t limit,
+	LPCSTR **pNames)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_FIND_CLASSES);
+	PyVtk_CallRecord record(PYVTK_ENTRY_FIND_CLASSES);
+	record.String(query).Number(mode).Number(limit);
+
+	*pNames = NULL;
+	if (mode < PYVTK_CLASS_PREFIX || mode > PYVTK_CLASS_PROPERTY)
+	{
+		PyVtk_Error(PYVTK_E_ARGUMENT, NULL, "findVtkClasses", "Unknown search mode %d", (int) mode);
+		return -1;
+	}
+
+	PyObject *pFound = PyVtk_CallPython(pIntrospector, "findVtkClasses", "ssn", query, classQueryModes[mode], (Py_ssize_t) limit);
+	if (pFound == NULL || !PyList_Check(pFound))
+	{
+		Py_XDECREF(pFound);
+		PyVtk_Error(PYVTK_E_PYTHON, NULL, "findVtkClasses", "Cannot search the classes for \"%s\"", query);
+		return -1;
+	}
+
+	/* Copying the names out of the Python strings before releasing them. */
+	Py_ssize_t count = PyList_GET_SIZE(pFound);
+	LPCSTR *names = (LPCSTR *) scratch.Allocate(count * sizeof(LPCSTR));
+	for (Py_ssize_t i = 0; i < count; ++i)
+	{
+		LPCSTR name = PyString_AsString(PyList_GET_ITEM(pFound, i));
+		if (name == NULL)
+		{
+			Py_DECREF(pFound);
+			PyVtk_Error(PYVTK_E_FORMAT, NULL, "findVtkClasses", "Class names have to be strings");
+			return -1;
+		}
+		names[i] = scratch.CopyString(name);
+	}
+	Py_DECREF(pFound);
+
+	*pNames = names;
+	return (long) count;
+}
+
+
+/*
+ * Sizes of the columns of a snapshot, gathered in a first pass over the values.
+ */
+struct PyVtk_SnapshotLayout
+{
+	size_t count;
+	size_t textSize;
+	size_t components;
+};
+
+
+/*
+ * Type of a value read by the Introspector, with the number of characters or
+ * components it adds to the snapshot.
+ */
+static char PyVtk_SnapshotType(
+	PyObject *pValue,
+	size_t *pLength)
+{
+	*pLength = 0;
+	if (PyBool_Check(pValue))
+	{
+		return 'b';
+	}
+	if (PyLong_Check(pValue))
+	{
+		return 'd';
+	}
+	if (PyFloat_Check(pValue))
+	{
+		return 'f';
+	}
+	if (PyUnicode_Check(pValue))
+	{
+		Py_ssize_t size;
+		if (PyUnicode_AsUTF8AndSize(pValue, &size) == NULL)
+		{
+			PyErr_Clear();
+			return 0;
+		}
+		*pLength = (size_t) size;
+		return 's';
+	}
+	if (PyTuple_Check(pValue) || PyList_Check(pValue))
+	{
+		Py_ssize_t size = PySequence_Fast_GET_SIZE(pValue);
+		for (Py_ssize_t i = 0; i < size; ++i)
+		{
+			PyObject *pItem = PySequence_Fast_GET_ITEM(pValue, i);
+			if (!PyLong_Check(pItem) && !PyFloat_Check(pItem))
+			{
+				return 0;
+			}
+		}
+		*pLength = (size_t) size;
+		return 't';
+	}
+	return 0;
+}
+
+
+/*
+ * Reads properties of many objects in one call of the Introspector, returning
+ * its list of (index, name, value) tuples, checked, or NULL after an error.
+ */
+static PyObject *PyVtk_ReadProperties(
+	PyObject *pIntrospector,
+	const std::vector<vtkObjectBase *> &objects,
+	const std::vector<LPCSTR> &properties)
+{
+	PyObject *pNodes = PyList_New(objects.size());
+	PyObject *pAttributes = PyList_New(properties.size());
+	if (pNodes == NULL || pAttributes == NULL)
+	{
+		Py_XDECREF(pNodes);
+		Py_XDECREF(pAttributes);
+		PyVtk_Error(PYVTK_E_PYTHON, NULL, "getVtkObjectSnapshot", "Cannot build the arguments");
+		return NULL;
+	}
+
+	for (size_t i = 0; i < objects.size(); ++i)
+	{
+		auto iNode = nodes.find(objects[i]);
+		if (nodes.end() == iNode)
+		{
+			Py_DECREF(pNodes);
+			Py_DECREF(pAttributes);
+			PyVtk_Error(PYVTK_E_NOT_REGISTERED, objects[i], NULL, "Cannot find node");
+			return NULL;
+		}
+		Py_INCREF(iNode->second);
+		PyList_SET_ITEM(pNodes, i, iNode->second);
+	}
+	for (size_t i = 0; i < properties.size(); ++i)
+	{
+		PyList_SET_ITEM(pAttributes, i, PyUnicode_FromString(properties[i]));
+	}
+
+	PyObject *pValues = PyVtk_CallPython(pIntrospector, "getVtkObjectSnapshot", "OO", pNodes, pAttributes);
+	Py_DECREF(pNodes);
+	Py_DECREF(pAttributes);
+	if (pValues == NULL || !PyList_Check(pValues))
+	{
+		Py_XDECREF(pValues);
+		PyVtk_Error(PYVTK_E_PYTHON, NULL, "getVtkObjectSnapshot", "Cannot read the properties");
+		return NULL;
+	}
+
+	for (Py_ssize_t i = 0; i < PyList_GET_SIZE(pValues); ++i)
+	{
+		PyObject *pEntry = PyList_GET_ITEM(pValues, i);
+		if (!PyTuple_Check(pEntry) || PyTuple_GET_SIZE(pEntry) != 3
+			|| !PyLong_Check(PyTuple_GET_ITEM(pEntry, 0)) || !PyUnicode_Check(PyTuple_GET_ITEM(pEntry, 1)))
+		{
+			Py_DECREF(pValues);
+			PyVtk_Error(PYVTK_E_FORMAT, NULL, "getVtkObjectSnapshot", "Unexpected entry %zd", i);
+			return NULL;
+		}
+	}
+
+	return pValues;
+}
+
+
+/*
+ * Reads properties of many objects in one crossing into Python. Without
+ * properties, every property the Introspector lists for an object is read. The
+ * values come back in one block, column by column, and the block is freed with
+ * PyVtk_ReleaseSnapshot.
+ */
+PyVtk_Snapshot *PyVtk_SnapshotProperties(
+	PyObject *pIntrospector,
+	const std::vector<vtkObjectBase *> &objects,
+	const std::vector<LPCSTR> &properties)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_SNAPSHOT_PROPERTIES);
+	PyVtk_CallRecord record(PYVTK_ENTRY_SNAPSHOT_PROPERTIES);
+	record.Handles(objects).Strings(properties);
+
+	/* Reads and executions see every write issued before them. */
+	PyVtk_FlushProperties(pIntrospector);
+
+	PyObject *pValues = PyVtk_ReadProperties(pIntrospector, objects, properties);
+	if (pValues == NULL)
+	{
+		return NULL;
+	}
+
+	/* Sizing the columns. Names and strings are kept with their terminator. */
+	PyVtk_SnapshotLayout layout = { (size_t) PyList_GET_SIZE(pValues), 0, 0 };
+	for (size_t i = 0; i < layout.count; ++i)
+	{
+		PyObject *pEntry = PyList_GET_ITEM(pValues, i);
+		size_t length;
+		char type = PyVtk_SnapshotType(PyTuple_GET_ITEM(pEntry, 2), &length);
+
+		Py_ssize_t nameSize = 0;
+		PyUnicode_AsUTF8AndSize(PyTuple_GET_ITEM(pEntry, 1), &nameSize);
+		layout.textSize += (size_t) nameSize + 1;
+		if (type == 's')
+		{
+			layout.textSize += length + 1;
+		}
+		else if (type == 't')
+		{
+			layout.components += length;
+		}
+	}
+
+	/* One block: the header, then the columns from the widest type down. */
+	size_t size = sizeof(PyVtk_Snapshot)
+		+ (layout.count + layout.components) * sizeof(double)
+		+ 4 * layout.count * sizeof(unsigned int)
+		+ layout.count + layout.textSize;
+	char *pBlock = (char *) malloc(size);
+	if (pBlock == NULL)
+	{
+		Py_DECREF(pValues);
+		PyVtk_Error(PYVTK_E_ARGUMENT, NULL, "PyVtk_SnapshotProperties", "Cannot allocate %zu bytes", size);
+		return NULL;
+	}
+
+	PyVtk_Snapshot *pSnapshot = (PyVtk_Snapshot *) pBlock;
+	double *numbers = (double *) (pBlock + sizeof(PyVtk_Snapshot));
+	double *components = numbers + layout.count;
+	unsigned int *objectIndices = (unsigned int *) (components + layout.components);
+	unsigned int *names = objectIndices + layout.count;
+	unsigned int *starts = names + layout.count;
+	unsigned int *lengths = starts + layout.count;
+	char *types = (char *) (lengths + layout.count);
+	char *text = types + layout.count;
+
+	size_t textUsed = 0, componentsUsed = 0;
+	for (size_t i = 0; i < layout.count; ++i)
+	{
+		PyObject *pEntry = PyList_GET_ITEM(pValues, i);
+		PyObject *pValue = PyTuple_GET_ITEM(pEntry, 2);
+		size_t length;
+		char type = PyVtk_SnapshotType(pValue, &length);
+
+		Py_ssize_t nameSize = 0;
+		LPCSTR name = PyUnicode_AsUTF8AndSize(PyTuple_GET_ITEM(pEntry, 1), &nameSize);
+		objectIndices[i] = (unsigned int) PyLong_AsUnsignedLong(PyTuple_GET_ITEM(pEntry, 0));
+		names[i] = (unsigned int) textUsed;
+		memcpy(text + textUsed, name != NULL ? name : "", (size_t) nameSize + 1);
+		textUsed += (size_t) nameSize + 1;
+
+		types[i] = type;
+		numbers[i] = 0.0;
+		starts[i] = lengths[i] = 0;
+		if (type == 'b' || type == 'd' || type == 'f')
+		{
+			numbers[i] = PyFloat_AsDouble(pValue);
+		}
+		else if (type == 's')
+		{
+			starts[i] = (unsigned int) textUsed;
+			lengths[i] = (unsigned int) length;
+			memcpy(text + textUsed, PyUnicode_AsUTF8(pValue), length + 1);
+			textUsed += length + 1;
+		}
+		else if (type == 't')
+		{
+			starts[i] = (unsigned int) componentsUsed;
+			lengths[i] = (unsigned int) length;
+			for (size_t c = 0; c < length; ++c)
+			{
+				components[componentsUsed++] = PyFloat_AsDouble(PySequence_Fast_GET_ITEM(pValue, c));
+			}
+		}
+	}
+	Py_DECREF(pValues);
+
+	pSnapshot->count = layout.count;
+	pSnapshot->objects = objectIndices;
+	pSnapshot->names = names;
+	pSnapshot->types = types;
+	pSnapshot->numbers = numbers;
+	pSnapshot->starts = starts;
+	pSnapshot->lengths = lengths;
+	pSnapshot->text = text;
+	pSnapshot->components = components;
+	pSnapshot->size = size;
+	return pSnapshot;
+}
+
+
+void PyVtk_ReleaseSnapshot(
+	PyVtk_Snapshot *pSnapshot)
+{
+	free(pSnapshot);
+}
+
+
+/*
+ * Change feed. A subscription observes the Modified and Delete events of its
+ * objects, which only mark them. PyVtk_PollChanges reads the marked objects
+ * whose MTime moved in one call of the Introspector, and queues a record for
+ * every property whose value differs from the last one seen, to be taken with
+ * PyVtk_NextChange. Polling while none of the objects changed does not reach
+ * Python. Subscriptions only read, and are not recorded.
+ */
+struct PyVtk_SubscribedValue
+{
+	std::string name;
+	char type;
+	double number;
+	std::string text;
+	std::vector<double> components;
+
+	bool operator==(const PyVtk_SubscribedValue &other) const
+	{
+		return type == other.type && number == other.number && text == other.text && components == other.components;
+	}
+};
+
+struct PyVtk_SubscribedObject
+{
+	vtkMTimeType mtime;
+	unsigned long modifiedTag;
+	unsigned long deleteTag;
+	std::vector<PyVtk_SubscribedValue> values;
+};
+
+struct PyVtk_QueuedChange
+{
+	vtkObjectBase *pObject;
+	PyVtk_SubscribedValue value;
+};
+
+struct PyVtk_Subscription
+{
+	std::vector<std::string> properties;
+	std::unordered_map<vtkObjectBase *, PyVtk_SubscribedObject> objects;
+	vtkCallbackCommand *pObserver;
+
+	/* Filled by the observers, which run on whichever thread changes an object. */
+	std::mutex mutex;
+	std::vector<vtkObjectBase *> modified;
+	std::vector<vtkObjectBase *> deleted;
+
+	std::deque<PyVtk_QueuedChange> queue;
+	PyVtk_QueuedChange current;
+};
+
+
+static void PyVtk_SubscriptionEvent(
+	vtkObject *pCaller,
+	unsigned long eventId,
+	void *pClientData,
+	void *pCallData)
+{
+	PyVtk_Subscription *pSubscription = (PyVtk_Subscription *) pClientData;
+	std::lock_guard<std::mutex> lock(pSubscription->mutex);
+	std::vector<vtkObjectBase *> &marked = eventId == vtkCommand::DeleteEvent ? pSubscription->deleted : pSubscription->modified;
+
+	/* Bursts of writes to one object mark it once. */
+	if (marked.empty() || marked.back() != pCaller)
+	{
+		marked.push_back(pCaller);
+	}
+}
+
+
+/*
+ * Drops the objects deleted since the last call, which are not to be touched.
+ */
+static void PyVtk_DropDeleted(
+	PyVtk_Subscription *pSubscription,
+	std::vector<vtkObjectBase *> *pModified)
+{
+	std::vector<vtkObjectBase *> deleted;
+	{
+		std::lock_guard<std::mutex> lock(pSubscription->mutex);
+		deleted.swap(pSubscription->deleted);
+		if (pModified != NULL)
+		{
+			pModified->swap(pSubscription->modified);
+		}
+	}
+
+	for (vtkObjectBase *pDeleted : deleted)
+	{
+		pSubscription->objects.erase(pDeleted);
+		if (pModified != NULL)
+		{
+			pModified->erase(std::remove(pModified->begin(), pModified->end(), pDeleted), pModified->end());
+		}
+	}
+}
+
+
+static void PyVtk_StopObserving(
+	vtkObjectBase *pVtkObject,
+	const PyVtk_SubscribedObject &subscribed)
+{
+	vtkObject *pObject = vtkObject::SafeDownCast(pVtkObject);
+	pObject->RemoveObserver(subscribed.modifiedTag);
+	pObject->RemoveObserver(subscribed.deleteTag);
+}
+
+
+/*
+ * Reads the values of the given objects and compares them with the ones kept,
+ * queueing the differences if queue is set.
+ */
+static bool PyVtk_RefreshSubscribed(
+	PyObject *pIntrospector,
+	PyVtk_Subscription *pSubscription,
+	const std::vector<vtkObjectBase *> &objects,
+	bool queue)
+{
+	std::vector<LPCSTR> properties;
+	for (const std::string &property : pSubscription->properties)
+	{
+		properties.push_back(property.c_str());
+	}
+
+	PyObject *pValues = PyVtk_ReadProperties(pIntrospector, objects, properties);
+	if (pValues == NULL)
+	{
+		return false;
+	}
+
+	PyVtk_SubscribedValue value;
+	for (Py_ssize_t i = 0; i < PyList_GET_SIZE(pValues); ++i)
+	{
+		PyObject *pEntry = PyList_GET_ITEM(pValues, i);
+		vtkObjectBase *pVtkObject = objects[PyLong_AsSize_t(PyTuple_GET_ITEM(pEntry, 0))];
+		PyObject *pValue = PyTuple_GET_ITEM(pEntry, 2);
+
+		size_t length;
+		value.name = PyUnicode_AsUTF8(PyTuple_GET_ITEM(pEntry, 1));
+		value.type = PyVtk_SnapshotType(pValue, &length);
+		value.number = 0.0;
+		value.text.clear();
+		value.components.clear();
+		if (value.type == 'b' || value.type == 'd' || value.type == 'f')
+		{
+			value.number = PyFloat_AsDouble(pValue);
+		}
+		else if (value.type == 's')
+		{
+			value.text.assign(PyUnicode_AsUTF8(pValue), length);
+		}
+		else if (value.type == 't')
+		{
+			for (size_t c = 0; c < length; ++c)
+			{
+				value.components.push_back(PyFloat_AsDouble(PySequence_Fast_GET_ITEM(pValue, c)));
+			}
+		}
+
+		std::vector<PyVtk_SubscribedValue> &values = pSubscription->objects[pVtkObject].values;
+		auto iKept = std::find_if(values.begin(), values.end(),
+			[&](const PyVtk_SubscribedValue &kept) { return kept.name == value.name; });
+		if (values.end() == iKept)
+		{
+			values.push_back(value);
+		}
+		else if (*iKept == value)
+		{
+			continue;
+		}
+		else
+		{
+			*iKept = value;
+		}
+
+		if (queue)
+		{
+			PyVtk_QueuedChange change = { pVtkObject, value };
+			pSubscription->queue.push_back(change);
+		}
+	}
+
+	Py_DECREF(pValues);
+	return true;
+}
+
+
+/*
+ * Subscribes to the given properties of registered objects, or to every property
+ * the Introspector lists for them without properties. The current values are
+ * taken as the starting point and are not reported.
+ */
+PyVtk_Subscription *PyVtk_Subscribe(
+	PyObject *pIntrospector,
+	const std::vector<vtkObjectBase *> &objects,
+	const std::vector<LPCSTR> &properties)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_SUBSCRIBE);
+
+	/* Reads and executions see every write issued before them. */
+	PyVtk_FlushProperties(pIntrospector);
+
+	for (vtkObjectBase *pVtkObject : objects)
+	{
+		if (nodes.end() == nodes.find(pVtkObject) || vtkObject::SafeDownCast(pVtkObject) == NULL)
+		{
+			PyVtk_Error(PYVTK_E_NOT_REGISTERED, pVtkObject, NULL, "Cannot find node");
+			return NULL;
+		}
+	}
+
+	PyVtk_Subscription *pSubscription = new PyVtk_Subscription();
+	for (LPCSTR property : properties)
+	{
+		pSubscription->properties.push_back(property);
+	}
+
+	pSubscription->pObserver = vtkCallbackCommand::New();
+	pSubscription->pObserver->SetCallback(PyVtk_SubscriptionEvent);
+	pSubscription->pObserver->SetClientData(pSubscription);
+
+	for (vtkObjectBase *pVtkObject : objects)
+	{
+		vtkObject *pObject = vtkObject::SafeDownCast(pVtkObject);
+		PyVtk_SubscribedObject &subscribed = pSubscription->objects[pVtkObject];
+		subscribed.mtime = pObject->GetMTime();
+		subscribed.modifiedTag = pObject->AddObserver(vtkCommand::ModifiedEvent, pSubscription->pObserver);
+		subscribed.deleteTag = pObject->AddObserver(vtkCommand::DeleteEvent, pSubscription->pObserver);
+	}
+
+	if (!PyVtk_RefreshSubscribed(pIntrospector, pSubscription, objects, false))
+	{
+		PyVtk_Unsubscribe(pSubscription);
+		return NULL;
+	}
+
+	return pSubscription;
+}
+
+
+/*
+ * Queues the changes made to the subscribed objects since the last poll.
+ */
+bool PyVtk_PollChanges(
+	PyObject *pIntrospector,
+	PyVtk_Subscription *pSubscription)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_POLL_CHANGES);
+
+	/* Coalesced writes only modify their objects once flushed. */
+	PyVtk_FlushProperties(pIntrospector);
+
+	std::vector<vtkObjectBase *> modified;
+	PyVtk_DropDeleted(pSubscription, &modified);
+	if (modified.empty())
+	{
+		return true;
+	}
+
+	std::sort(modified.begin(), modified.end());
+	modified.erase(std::unique(modified.begin(), modified.end()), modified.end());
+
+	std::vector<vtkObjectBase *> changed;
+	for (vtkObjectBase *pVtkObject : modified)
+	{
+		auto iSubscribed = pSubscription->objects.find(pVtkObject);
+		if (pSubscription->objects.end() == iSubscribed)
+		{
+			continue;
+		}
+
+		/* Objects deleted through the API, or given back to a pool, leave the subscription. */
+		if (nodes.end() == nodes.find(pVtkObject))
+		{
+			PyVtk_StopObserving(pVtkObject, iSubscribed->second);
+			pSubscription->objects.erase(iSubscribed);
+			continue;
+		}
+
+		vtkMTimeType mtime = vtkObject::SafeDownCast(pVtkObject)->GetMTime();
+		if (mtime != iSubscribed->second.mtime)
+		{
+			iSubscribed->second.mtime = mtime;
+			changed.push_back(pVtkObject);
+		}
+	}
+
+	return changed.empty() || PyVtk_RefreshSubscribed(pIntrospector, pSubscription, changed, true);
+}
+
+
+/*
+ * Takes the oldest queued change, if any.
+ */
+bool PyVtk_NextChange(
+	PyVtk_Subscription *pSubscription,
+	PyVtk_Change *pChange)
+{
+	if (pSubscription->queue.empty())
+	{
+		return false;
+	}
+
+	pSubscription->current = std::move(pSubscription->queue.front());
+	pSubscription->queue.pop_front();
+
+	const PyVtk_SubscribedValue &value = pSubscription->current.value;
+	pChange->pObject = pSubscription->current.pObject;
+	pChange->property = value.name.c_str();
+	pChange->type = value.type;
+	pChange->number = value.number;
+	pChange->text = value.type == 's' ? value.text.c_str() : NULL;
+	pChange->components = value.type == 't' ? value.components.data() : NULL;
+	pChange->length = value.type == 's' ? value.text.size() : value.components.size();
+	return true;
+}
+
+
+void PyVtk_Unsubscribe(
+	PyVtk_Subscription *pSubscription)
+{
+	if (pSubscription == NULL)
+	{
+		return;
+	}
+
+	PyVtk_DropDeleted(pSubscription, NULL);
+	for (auto &entry : pSubscription->objects)
+	{
+		PyVtk_StopObserving(entry.first, entry.second);
+	}
+
+	pSubscription->pObserver->Delete();
+	delete pSubscription;
+}
+
+
+/*
+ * Preview mode. A pipeline ending in a sink is given reduction stages right
+ * after its sources: structured data is subsampled at a stride, either given or
+ * derived from a target cell count, and the seeds read on port 1 of the
+ * consumers only keep one point out of a ratio. While the parameters of the
+ * pipeline change, everything downstream runs on the reduced data. Once no
+ * algorithm of the pipeline was modified for the settle time, PyVtk_PollPreviews
+ * or a PyVtk_UpdatePipeline of the sink opens the stages up to full resolution
+ * and updates the sink on the caller's thread; the next modification reduces
+ * the data again. Other calls never settle a preview, so the full update is not
+ * charged to an unrelated read. Settling waits while executions of other threads
+ * run VTK without the GIL, as they may share the pipeline. The stages are only
+ * known here, the Introspector and the host keep seeing the original
+ * connections, but reconnecting a previewed pipeline needs its preview to be set
+ * again.
+ */
+struct PyVtk_PreviewStage
+{
+	vtkAlgorithm *pStage;
+	vtkAlgorithmOutput *pOriginal;
+	bool seeds;
+	int reduction;
+};
+
+struct PyVtk_Preview
+{
+	PyObject *pIntrospector;
+	vtkAlgorithm *pSink;
+	PyVtk_PreviewOptions options;
+	std::vector<PyVtk_PreviewStage> stages;
+	std::vector<std::pair<vtkAlgorithm *, int> > rewired;
+	std::vector<vtkObject *> pWatched;
+	std::vector<unsigned long> observerTags;
+	vtkCallbackCommand *pObserver;
+	std::atomic<bool> reduced;
+	std::atomic<bool> finishing;
+	std::atomic<unsigned long long> lastChange;
+};
+
+static std::unordered_map<vtkObjectBase *, PyVtk_Preview *> previews;
+static std::mutex previewsMutex;
+static std::atomic<size_t> previewCount(0);
+static thread_local bool settlingPreviews = false;
+
+
+static bool PyVtk_PreviewSettled(
+	PyVtk_Preview *pPreview)
+{
+	unsigned long long lastChange = pPreview->lastChange;
+	return PyVtk_Now() - lastChange >= pPreview->options.settleMilliseconds * 1000000ULL;
+}
+
+
+static void PyVtk_SetPreviewStages(
+	PyVtk_Preview *pPreview,
+	bool reduced)
+{
+	for (PyVtk_PreviewStage &stage : pPreview->stages)
+	{
+		int rate = reduced ? stage.reduction : 1;
+		if (stage.seeds)
+		{
+			static_cast<vtkMaskPoints *>(stage.pStage)->SetOnRatio(rate);
+		}
+		else if (vtkExtractGrid *pExtract = vtkExtractGrid::SafeDownCast(stage.pStage))
+		{
+			pExtract->SetSampleRate(rate, rate, rate);
+		}
+		else
+		{
+			static_cast<vtkExtractVOI *>(stage.pStage)->SetSampleRate(rate, rate, rate);
+		}
+	}
+	pPreview->reduced = reduced;
+}
+
+
+static void PyVtk_PreviewEvent(
+	vtkObject *pCaller,
+	unsigned long eventId,
+	void *pClientData,
+	void *pCallData)
+{
+	PyVtk_Preview *pPreview = (PyVtk_Preview *) pClientData;
+	if (pPreview->finishing)
+	{
+		return;
+	}
+
+	pPreview->lastChange = PyVtk_Now();
+	if (!pPreview->reduced)
+	{
+		PyVtk_SetPreviewStages(pPreview, true);
+	}
+}
+
+
+/*
+ * Inserts the stages above pAlgorithm, going up to the sources of the pipeline.
+ */
+static void PyVtk_InsertPreviewStages(
+	PyVtk_Preview *pPreview,
+	vtkAlgorithm *pAlgorithm,
+	std::unordered_map<vtkAlgorithm *, bool> &visited)
+{
+	if (visited.end() != visited.find(pAlgorithm))
+	{
+		return;
+	}
+	visited[pAlgorithm] = true;
+	pPreview->pWatched.push_back(pAlgorithm);
+
+	for (int port = 0; port < pAlgorithm->GetNumberOfInputPorts(); ++port)
+	{
+		std::vector<vtkAlgorithmOutput *> connections;
+		bool replaced = false;
+		for (int i = 0; i < pAlgorithm->GetNumberOfInputConnections(port); ++i)
+		{
+			vtkAlgorithmOutput *pConnection = pAlgorithm->GetInputConnection(port, i);
+			vtkAlgorithm *pProducer = pConnection->GetProducer();
+			connections.push_back(pConnection);
+			if (pProducer->GetNumberOfInputPorts() > 0)
+			{
+				PyVtk_InsertPreviewStages(pPreview, pProducer, visited);
+				continue;
+			}
+
+			if (visited.end() == visited.find(pProducer))
+			{
+				visited[pProducer] = true;
+				pPreview->pWatched.push_back(pProducer);
+			}
+
+			/* Sources are read once to size their reduction. */
+			{
+				PyVtk_VtkScope vtk(pProducer, true);
+				pProducer->Update(pConnection->GetIndex());
+			}
+			vtkDataObject *pData = pProducer->GetOutputDataObject(pConnection->GetIndex());
+
+			/* Consumers of the same source share its stage. */
+			bool seeds = port == 1 && vtkPolyData::SafeDownCast(pData) != NULL;
+			auto iStage = std::find_if(pPreview->stages.begin(), pPreview->stages.end(),
+				[&](const PyVtk_PreviewStage &stage) { return stage.pOriginal == pConnection && stage.seeds == seeds; });
+			if (pPreview->stages.end() != iStage)
+			{
+				connections.back() = iStage->pStage->GetOutputPort();
+				replaced = true;
+				continue;
+			}
+
+			PyVtk_PreviewStage stage = { NULL, pConnection, seeds, (int) pPreview->options.stride };
+			if (stage.reduction == 0 && pPreview->options.targetCells != 0 && vtkDataSet::SafeDownCast(pData) != NULL)
+			{
+				double ratio = (double) vtkDataSet::SafeDownCast(pData)->GetNumberOfCells() / pPreview->options.targetCells;
+				stage.reduction = (int) std::ceil(std::cbrt(ratio));
+			}
+			stage.reduction = std::max(1, stage.reduction);
+
+			if (seeds)
+			{
+				stage.pStage = vtkMaskPoints::New();
+			}
+			else if (vtkStructuredGrid::SafeDownCast(pData) != NULL)
+			{
+				stage.pStage = vtkExtractGrid::New();
+			}
+			else if (vtkImageData::SafeDownCast(pData) != NULL)
+			{
+				stage.pStage = vtkExtractVOI::New();
+			}
+			else
+			{
+				continue;
+			}
+
+			stage.pStage->SetInputConnection(pConnection);
+			connections.back() = stage.pStage->GetOutputPort();
+			pPreview->stages.push_back(stage);
+			replaced = true;
+		}
+
+		if (replaced)
+		{
+			pAlgorithm->RemoveAllInputConnections(port);
+			for (vtkAlgorithmOutput *pConnection : connections)
+			{
+				pAlgorithm->AddInputConnection(port, pConnection);
+			}
+			pPreview->rewired.push_back(std::make_pair(pAlgorithm, port));
+		}
+	}
+}
+
+
+/*
+ * Puts the original connections back and drops the stages.
+ */
+static void PyVtk_RemovePreview(
+	PyVtk_Preview *pPreview)
+{
+	for (size_t i = 0; i < pPreview->pWatched.size(); ++i)
+	{
+		pPreview->pWatched[i]->RemoveObserver(pPreview->observerTags[i]);
+	}
+	pPreview->pObserver->Delete();
+
+	for (auto &rewired : pPreview->rewired)
+	{
+		std::vector<vtkAlgorithmOutput *> connections;
+		for (int i = 0; i < rewired.first->GetNumberOfInputConnections(rewired.second); ++i)
+		{
+			vtkAlgorithmOutput *pConnection = rewired.first->GetInputConnection(rewired.second, i);
+			for (PyVtk_PreviewStage &stage : pPreview->stages)
+			{
+				if (pConnection->GetProducer() == stage.pStage)
+				{
+					pConnection = stage.pOriginal;
+					break;
+				}
+			}
+			connections.push_back(pConnection);
+		}
+
+		rewired.first->RemoveAllInputConnections(rewired.second);
+		for (vtkAlgorithmOutput *pConnection : connections)
+		{
+			rewired.first->AddInputConnection(rewired.second, pConnection);
+		}
+	}
+
+	for (PyVtk_PreviewStage &stage : pPreview->stages)
+	{
+		stage.pStage->Delete();
+	}
+	delete pPreview;
+}
+
+
+/*
+ * Brings the settled previews of an Introspector to full resolution, on the
+ * caller's thread, which holds the GIL and has flushed its writes. If pSinks is
+ * given, only the previews of those sinks are. Returns how many were.
+ */
+static size_t PyVtk_SettlePreviews(
+	PyObject *pIntrospector,
+	const std::vector<vtkObjectBase *> *pSinks = NULL)
+{
+	if (previewCount == 0 || settlingPreviews || releasedExecutions > 0)
+	{
+		return 0;
+	}
+
+	size_t settled = 0;
+	settlingPreviews = true;
+	{
+		std::lock_guard<std::mutex> lock(previewsMutex);
+		for (auto &entry : previews)
+		{
+			PyVtk_Preview *pPreview = entry.second;
+			if (pPreview->pIntrospector != pIntrospector || !pPreview->reduced || !PyVtk_PreviewSettled(pPreview))
+			{
+				continue;
+			}
+			if (pSinks != NULL && std::find(pSinks->begin(), pSinks->end(), entry.first) == pSinks->end())
+			{
+				continue;
+			}
+
+			PyVtk_CallScope scope(PYVTK_ENTRY_PREVIEW_FINAL, pPreview->pSink);
+			pPreview->finishing = true;
+			PyVtk_SetPreviewStages(pPreview, false);
+			{
+				PyVtk_VtkScope vtk(pPreview->pSink, true);
+				pPreview->pSink->Update();
+			}
+			pPreview->finishing = false;
+			++settled;
+		}
+	}
+	settlingPreviews = false;
+
+	return settled;
+}
+
+
+static void PyVtk_DropPreview(
+	vtkObjectBase *pVtkSink)
+{
+	std::lock_guard<std::mutex> lock(previewsMutex);
+	auto iPreview = previews.find(pVtkSink);
+	if (previews.end() != iPreview)
+	{
+		PyVtk_RemovePreview(iPreview->second);
+		previews.erase(iPreview);
+		previewCount = previews.size();
+	}
+}
+
+
+/*
+ * Sets the preview of the pipeline ending in pVtkSink, replacing the one it
+ * had, or removes it if pOptions is NULL.
+ */
+bool PyVtk_SetPreview(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkSink,
+	const PyVtk_PreviewOptions *pOptions)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_SET_PREVIEW, pVtkSink);
+	PyVtk_CallRecord record(PYVTK_ENTRY_SET_PREVIEW);
+	record.Handle(pVtkSink).Number(pOptions != NULL ? 1 : 0);
+	if (pOptions != NULL)
+	{
+		record.Number(pOptions->stride).Number(pOptions->targetCells).Number(pOptions->seedRatio).Number(pOptions->settleMilliseconds);
+	}
+
+	vtkAlgorithm *pSink = vtkAlgorithm::SafeDownCast(pVtkSink);
+	if (pSink == NULL)
+	{
+		PyVtk_Error(PYVTK_E_ARGUMENT, pVtkSink, "SetPreview", "Only pipelines ending in an algorithm can be previewed");
+		return false;
+	}
+
+	/* Reads and executions see every write issued before them. */
+	PyVtk_FlushProperties(pIntrospector);
+
+	PyVtk_DropPreview(pVtkSink);
+	if (pOptions == NULL)
+	{
+		return true;
+	}
+
+	PyVtk_Preview *pPreview = new PyVtk_Preview();
+	pPreview->pIntrospector = pIntrospector;
+	pPreview->pSink = pSink;
+	pPreview->options = *pOptions;
+
+	std::unordered_map<vtkAlgorithm *, bool> visited;
+	PyVtk_InsertPreviewStages(pPreview, pSink, visited);
+
+	/* Seeds are reduced as much as the field unless told otherwise. */
+	int fieldReduction = 1;
+	for (PyVtk_PreviewStage &stage : pPreview->stages)
+	{
+		fieldReduction = stage.seeds ? fieldReduction : std::max(fieldReduction, stage.reduction);
+	}
+	for (PyVtk_PreviewStage &stage : pPreview->stages)
+	{
+		if (stage.seeds)
+		{
+			stage.reduction = pOptions->seedRatio != 0 ? (int) pOptions->seedRatio : fieldReduction;
+		}
+	}
+	PyVtk_SetPreviewStages(pPreview, true);
+	pPreview->finishing = false;
+	pPreview->lastChange = PyVtk_Now();
+
+	pPreview->pObserver = vtkCallbackCommand::New();
+	pPreview->pObserver->SetCallback(PyVtk_PreviewEvent);
+	pPreview->pObserver->SetClientData(pPreview);
+	for (vtkObject *pObject : pPreview->pWatched)
+	{
+		pPreview->observerTags.push_back(pObject->AddObserver(vtkCommand::ModifiedEvent, pPreview->pObserver));
+	}
+
+	std::lock_guard<std::mutex> lock(previewsMutex);
+	previews[pVtkSink] = pPreview;
+	previewCount = previews.size();
+	return true;
+}
+
+
+bool PyVtk_IsPreview(
+	vtkObjectBase *pVtkSink)
+{
+	std::lock_guard<std::mutex> lock(previewsMutex);
+	auto iPreview = previews.find(pVtkSink);
+	return previews.end() != iPreview && iPreview->second->reduced;
+}
+
+
+/*
+ * Brings the previews of the Introspector that settled to full resolution, for
+ * hosts that want the full result without reading the pipeline. Returns how
+ * many were.
+ */
+size_t PyVtk_PollPreviews(
+	PyObject *pIntrospector)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_POLL_PREVIEWS);
+	PyVtk_CallRecord record(PYVTK_ENTRY_POLL_PREVIEWS);
+
+	/* Writes held back by coalescing are changes too. */
+	PyVtk_FlushWrites(pIntrospector);
+	return PyVtk_SettlePreviews(pIntrospector);
+}
+
+
+/*
+ * Removes the previews of an Introspector, or every preview if it is NULL.
+ */
+static void PyVtk_DropPreviews(
+	PyObject *pIntrospector)
+{
+	std::lock_guard<std::mutex> lock(previewsMutex);
+	for (auto iPreview = previews.begin(); iPreview != previews.end();)
+	{
+		if (pIntrospector != NULL && iPreview->second->pIntrospector != pIntrospector)
+		{
+			++iPreview;
+			continue;
+		}
+
+		PyVtk_RemovePreview(iPreview->second);
+		iPreview = previews.erase(iPreview);
+	}
+	previewCount = previews.size();
+}
+
+
+/*
+ * Whether a registered algorithm still reads an output of this one.
+ */
+static bool PyVtk_HasConsumers(
+	vtkObjectBase *pVtkObject)
+{
+	vtkAlgorithm *pProducer = vtkAlgorithm::SafeDownCast(pVtkObject);
+	if (pProducer == NULL)
+	{
+		return false;
+	}
+
+	for (auto &node : nodes)
+	{
+		vtkAlgorithm *pConsumer = vtkAlgorithm::SafeDownCast(node.first);
+		if (pConsumer == NULL || pConsumer == pProducer)
+		{
+			continue;
+		}
+
+		for (int port = 0; port < pConsumer->GetNumberOfInputPorts(); ++port)
+		{
+			for (int i = 0; i < pConsumer->GetNumberOfInputConnections(port); ++i)
+			{
+				vtkAlgorithmOutput *pConnection = pConsumer->GetInputConnection(port, i);
+				if (pConnection != NULL && pConnection->GetProducer() == pProducer)
+				{
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+
+bool PyVtk_DeleteVtkObject(
+	PyObject *pIntrospector,
+	vtkObjectBase* pVtkObject)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_DELETE, pVtkObject);
+	PyVtk_CallRecord record(PYVTK_ENTRY_DELETE);
+	record.Handle(pVtkObject).Forget(pVtkObject);
+
+	/* A previewed sink takes its preview along. */
+	PyVtk_DropPreview(pVtkObject);
+
+	auto iNode = nodes.find(pVtkObject);
+	if (nodes.end() != iNode)
+	{
+		/* Getting Python node. */
+		PyObject *pNode = iNode->second;
+
+		/* A node other nodes still read from stays wired to them, so it is not pooled. */
+		PyObject *pCheck = PyVtk_CallPythonFor(pVtkObject, pIntrospector, "deleteVtkObject", "Oi", pNode, PyVtk_HasConsumers(pVtkObject) ? 1 : 0);
+		if (pCheck == NULL)
+		{
+			PyVtk_Error(PYVTK_E_PYTHON, pVtkObject, "deleteVtkObject", "Cannot delete the VTK object");
+			return false;
+		}
+		Py_DECREF(pCheck);
+
+		/* Freeing the node's space and cleaning up. */
+		PyVtk_DiscardPending(pVtkObject);
+		Py_DECREF(pNode);
+		nodes.erase(pVtkObject);
+		nodeSessions.erase(pVtkObject);
+		threadBudgets.erase(pVtkObject);
+
+		return true;
+	}
+	else
+	{
+		PyVtk_Error(PYVTK_E_NOT_REGISTERED, pVtkObject, NULL, "Cannot find node");
+		return false;
+	}
+}
+
+
+vtkAlgorithmOutput *PyVtk_GetOutputPort(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_GET_OUTPUT_PORT, pVtkObject);
+	PyVtk_CallRecord record(PYVTK_ENTRY_GET_OUTPUT_PORT);
+	record.Handle(pVtkObject);
+
+	/* Reads and executions see every write issued before them. */
+	PyVtk_FlushProperties(pIntrospector);
+
+	auto iNode = nodes.find(pVtkObject);
+	if (nodes.end() != iNode)
+	{
+		/* Getting Python node. */
+		PyObject *pNode = iNode->second;
+
+		/* Executing method call to get the port. Returns error if the port could not be accessed. */
+		PyObject *pPyPort = PyVtk_CallPythonFor(pVtkObject, pIntrospector, "getVtkObjectOutputPort", "O", pNode);
+		if (pPyPort == NULL)
+		{
+			PyVtk_Error(PYVTK_E_PYTHON, pVtkObject, "GetOutputPort", "Cannot access the VTK object output port");
+			return NULL;
+		}
+
+		/* Extracting the output port and connecting. */
+		return record.Result((vtkAlgorithmOutput *)vtkPythonUtil::GetPointerFromObject(pPyPort, "vtkAlgorithmOutput"));
+	}
+	else
+	{
+		PyVtk_Error(PYVTK_E_NOT_REGISTERED, pVtkObject, NULL, "Cannot find node");
+		return NULL;
+	}
+}
+
+
+bool PyVtk_ConnectVtkObject(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	vtkAlgorithm *pVtkTarget)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_CONNECT, pVtkObject);
+	PyVtk_CallRecord record(PYVTK_ENTRY_CONNECT);
+	record.Handle(pVtkObject).Handle(pVtkTarget);
+
+	/* Reads and executions see every write issued before them. */
+	PyVtk_FlushProperties(pIntrospector);
+
+	auto iNode = nodes.find(pVtkObject);
+	if (nodes.end() != iNode)
+	{
+		/* Getting Python node. */
+		PyObject *pNode = iNode->second;
+
+		/* Executing method call to get the port. Returns error if the port could not be accessed. */
+		PyObject *pPyPort = PyVtk_CallPythonFor(pVtkObject, pIntrospector, "getVtkObjectOutputPort", "O", pNode);
+		if (pPyPort == NULL)
+		{
+			PyVtk_Error(PYVTK_E_PYTHON, pVtkObject, "GetOutputPort", "Cannot access the VTK object output port");
+			return false;
+		}
+
+		/* Extracting the output port and connecting. */
+		vtkAlgorithmOutput *pPort = (vtkAlgorithmOutput *) vtkPythonUtil::GetPointerFromObject(pPyPort, "vtkAlgorithmOutput");
+		pVtkTarget->SetInputConnection(pPort);
+
+		return true;
+	}
+	else
+	{
+		PyVtk_Error(PYVTK_E_NOT_REGISTERED, pVtkObject, NULL, "Cannot find node");
+		return false;
+	}
+}
+
+
+/*
+ * Connects the given output port of a registered object to an input port of the
+ * target. The connection replaces those of that input port, unless add is set
+ * for inputs taking several connections, such as those of append filters.
+ */
+bool PyVtk_ConnectVtkObjectPorts(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	int outputPort,
+	vtkAlgorithm *pVtkTarget,
+	int inputPort,
+	bool add)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_CONNECT_PORTS, pVtkObject);
+	PyVtk_CallRecord record(PYVTK_ENTRY_CONNECT_PORTS);
+	record.Handle(pVtkObject).Number(outputPort).Handle(pVtkTarget).Number(inputPort).Number(add ? 1 : 0);
+
+	/* Reads and executions see every write issued before them. */
+	PyVtk_FlushProperties(pIntrospector);
+
+	auto iNode = nodes.find(pVtkObject);
+	if (nodes.end() == iNode)
+	{
+		PyVtk_Error(PYVTK_E_NOT_REGISTERED, pVtkObject, NULL, "Cannot find node");
+		return false;
+	}
+
+	if (pVtkTarget == NULL || inputPort < 0 || inputPort >= pVtkTarget->GetNumberOfInputPorts())
+	{
+		PyVtk_Error(PYVTK_E_ARGUMENT, pVtkTarget, "SetInputConnection", "No input port %d", inputPort);
+		return false;
+	}
+
+	/* Executing method call to get the port. Returns error if the port could not be accessed. */
+	PyObject *pPyPort = PyVtk_CallPythonFor(pVtkObject, pIntrospector, "getVtkObjectOutputPort", "Oi", iNode->second, outputPort);
+	if (pPyPort == NULL)
+	{
+		PyVtk_Error(PYVTK_E_PYTHON, pVtkObject, "GetOutputPort", "Cannot access the VTK object output port %d", outputPort);
+		return false;
+	}
+
+	vtkAlgorithmOutput *pPort = (vtkAlgorithmOutput *) vtkPythonUtil::GetPointerFromObject(pPyPort, "vtkAlgorithmOutput");
+	Py_DECREF(pPyPort);
+	if (pPort == NULL)
+	{
+		PyErr_Clear();
+		PyVtk_Error(PYVTK_E_ARGUMENT, pVtkObject, "GetOutputPort", "No output port %d", outputPort);
+		return false;
+	}
+
+	if (add)
+	{
+		pVtkTarget->AddInputConnection(inputPort, pPort);
+	}
+	else
+	{
+		pVtkTarget->SetInputConnection(inputPort, pPort);
+	}
+
+	return true;
+}
+
+
+/*
+ * Keeps up to size deleted objects of a class for reuse by later creations,
+ * reset to their defaults, and fills the pool right away. A size of 0, the
+ * default, disables pooling. Objects configured other than through their
+ * properties, for instance with input data, keep that across reuse.
+ */
+bool PyVtk_SetPoolSize(
+	PyObject *pIntrospector,
+	LPCSTR sVtkClassName,
+	size_t size)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_SET_POOL_SIZE);
+	PyVtk_CallRecord record(PYVTK_ENTRY_SET_POOL_SIZE);
+	record.String(sVtkClassName).Number(size);
+
+	PyObject *pCheck = PyVtk_CallPython(pIntrospector, "setPoolSize", "sn", sVtkClassName, (Py_ssize_t) size);
+	if (pCheck == NULL)
+	{
+		PyVtk_Error(PYVTK_E_PYTHON, NULL, "setPoolSize", "Cannot size the pool of \"%s\"", sVtkClassName);
+		return false;
+	}
+	Py_DECREF(pCheck);
+
+	return true;
+}
+
+
+/*
+ * Drops every registered object in one pass. The Introspector is not called
+ * per object, so the objects skip the pools and go away with their last
+ * reference.
+ */
+static void PyVtk_DropNodes(
+	PyObject *pIntrospector)
+{
+	PyVtk_DropPreviews(pIntrospector);
+
+	for (auto iNode = nodes.begin(); iNode != nodes.end();)
+	{
+		if (pIntrospector != NULL && !PyVtk_InSession(pIntrospector, iNode->first))
+		{
+			++iNode;
+			continue;
+		}
+
+		/* Pending writes would only target an object about to be dropped. */
+		PyVtk_DiscardPending(iNode->first);
+		nodeSessions.erase(iNode->first);
+		threadBudgets.erase(iNode->first);
+		Py_DECREF(iNode->second);
+		iNode = nodes.erase(iNode);
+	}
+
+	/* Dropping them all is the end of every session. */
+	if (pIntrospector == NULL)
+	{
+		threadBudgets.clear();
+	}
+}
+
+
+/*
+ * Deletes every object created through the layer by the Introspector, keeping
+ * the interpreter and the other sessions.
+ */
+void PyVtk_CloseSession(
+	PyObject *pIntrospector)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_CLOSE_SESSION);
+	PyVtk_CallRecord record(PYVTK_ENTRY_CLOSE_SESSION);
+	for (auto &session : nodeSessions)
+	{
+		if (record.Active() && session.second == pIntrospector)
+		{
+			record.Forget(session.first);
+		}
+	}
+
+	PyVtk_DropNodes(pIntrospector);
+}
+
+
+/*
+ * When enabled, PyVtk_FinalizeIntrospector leaves the objects and the
+ * interpreter to the end of the process, only flushing what would otherwise be
+ * lost. It is meant for hosts that exit right after finalizing.
+ */
+static bool fastExit = false;
+
+void PyVtk_SetFastExit(
+	bool enabled)
+{
+	fastExit = enabled;
+}
+
+
+void PyVtk_FinalizeIntrospector(
+	PyObject *pIntrospector)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_FINALIZE);
+
+	/* Closing the files written on the side before anything is torn down. */
+	PyVtk_StopRecording();
+	PyVtk_StopInstrumentationExport();
+	PyVtk_StopErrorLog();
+
+	if (fastExit)
+	{
+		PyRun_SimpleString("import sys\nsys.stdout.flush()\nsys.stderr.flush()");
+		PyVtk_DropPreviews(NULL);
+		return;
+	}
+
+	PyVtk_DropNodes(NULL);
+
+	Py_DECREF(pIntrospector);
+	Py_Finalize();
+	PyVtk_StopInstrumentation();
+
+	/* Nothing returned so far can be referenced by the host past this point. */
+	PyVtk_ResetScratch();
+}
+
+
+size_t argsize(LPCSTR str)
+{
+	size_t size = 0;
+	size_t maxsize = std::strlen(str);
+	for (int i = 0; i < maxsize; ++i)
+	{
+		if (isalpha(str[i]))
+		{
+			++size;
+		}
+	}
+
+	return size;
+}
+
+
+static PyObject *PyVtk_ArgvValue(
+	char def,
+	LPCSTR str)
+{
+	switch (def)
+	{
+	case 's':
+	case 'S':
+		return PyString_FromString(str);
+
+	case 'd':
+	case 'D':
+		return PyLong_FromLong(strtol(str, NULL, 10));
+
+	case 'f':
+	case 'F':
+		return PyFloat_FromDouble(strtod(str, NULL));
+
+	case 'b':
+	case 'B':
+		return PyBool_FromLong(strtol(str, NULL, 10));
+
+	default:
+		PyVtk_Error(PYVTK_E_FORMAT, NULL, NULL, "Format no recognised %c", def);
+		return NULL;
+	}
+}
+
+
+/*
+ * Builds a single argument from its format character and size specification,
+ * consuming references and values from the given arrays. Returns a new reference.
+ */
+static PyObject *PyVtk_ArgvItem(
+	char def,
+	int spec,
+	vtkObjectBase *const *pReferences,
+	size_t refc,
+	size_t *pObjects,
+	LPCSTR const *argv,
+	size_t valc,
+	size_t *pValues)
+{
+	PyObject *pVal = NULL;
+
+	if (def == 'o' || def == 'O')
+	{
+		if (*pObjects >= refc)
+		{
+			PyVtk_Error(PYVTK_E_ARGUMENT, NULL, NULL, "Reference out of bound %zu", *pObjects);
+			return NULL;
+		}
+
+		/* Getting the object's reference. */
+		vtkObjectBase *pReference = pReferences[(*pObjects)++];
+		auto iNodeRef = nodes.find(pReference);
+		if (nodes.end() != iNodeRef)
+		{
+			pVal = iNodeRef->second;
+			Py_INCREF(pVal);
+		}
+		else
+		{
+			/* The object may be wrappable as a VTK object. */
+			pVal = vtkPythonUtil::GetObjectFromPointer(pReference);
+
+			if (pVal == NULL)
+			{
+				PyVtk_Error(PYVTK_E_ARGUMENT, NULL, NULL, "Reference out of bound %zu", *pObjects - 1);
+				return NULL;
+			}
+		}
+	}
+	else
+	{
+		/* Getting the string. */
+		if (*pValues + (spec == 0 ? 1 : spec) > valc)
+		{
+			PyVtk_Error(PYVTK_E_ARGUMENT, NULL, NULL, "Value out of bound %zu", *pValues);
+			return NULL;
+		}
+
+		/* Unspec-ed argument */
+		if (spec == 0)
+		{
+			pVal = PyVtk_ArgvValue(def, argv[(*pValues)++]);
+		}
+		/* Spec-ed argument */
+		else
+		{
+			PyObject *pTuple = PyTuple_New(spec);
+			if (pTuple == NULL)
+			{
+				PyVtk_Error(PYVTK_E_PYTHON, NULL, NULL, "Unable to create a tuple of size %d", spec);
+				return NULL;
+			}
+
+			for (int j = 0; j < spec; ++j)
+			{
+				PyObject *pItem = PyVtk_ArgvValue(def, argv[(*pValues)++]);
+				if (pItem == NULL)
+				{
+					PyVtk_Error(PYVTK_E_FORMAT, NULL, NULL, "Item %d is not encodable with type \"%c\"", j, def);
+					Py_XDECREF(pTuple);
+					return NULL;
+				}
+				PyTuple_SET_ITEM(pTuple, j, pItem);
+			}
+
+			pVal = pTuple;
+		}
+	}
+
+	if (pVal == NULL)
+	{
+		PyVtk_Error(PYVTK_E_FORMAT, NULL, NULL, "Argument is not encodable with type \"%c\"", def);
+	}
+
+	return pVal;
+}
+
+
+/*
+ * Builds the argument tuple of a call from its format. References and values are
+ * taken as plain arrays, so that piped calls can hand over a window of their
+ * arguments without slicing them into new containers.
+ */
+PyObject *PyVtk_ArgvTuple(
+	LPCSTR format,
+	size_t argc,
+	vtkObjectBase *const *pReferences,
+	size_t refc,
+	LPCSTR const *argv,
+	size_t valc)
+{
+	PyObject *pArgs = PyTuple_New(argc);
+	if (pArgs == NULL)
+	{
+		PyVtk_Error(PYVTK_E_PYTHON, NULL, NULL, "Unable to create a tuple of size %zu", argc);
+		return NULL;
+	}
+
+	size_t objects = 0;
+	size_t values = 0;
+
+	/* Populating arguments. */
+	for (size_t i = 0, arg = 0; format[i] != '\0' && arg < argc; ++i)
+	{
+		char def = format[i];
+		if (!isalpha(def))
+		{
+			continue;
+		}
+
+		/* Checking for size specifications */
+		int spec = 0;
+		while (isdigit(format[i + 1]))
+		{
+			spec = spec * 10 + (format[i + 1] - '0');
+			++i;
+		}
+
+		PyObject *pVal = PyVtk_ArgvItem(def, spec, pReferences, refc, &objects, argv, valc, &values);
+		if (pVal == NULL)
+		{
+			Py_XDECREF(pArgs);
+			return NULL;
+		}
+		PyTuple_SET_ITEM(pArgs, arg++, pVal);
+	}
+
+	return pArgs;
+}
+
+
+PyObject *PyVtk_ObjectMethod(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	LPCSTR method,
+	LPCSTR format,
+	const std::vector<vtkObjectBase *> &pReferences,
+	const std::vector<LPCSTR> &argv)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_OBJECT_METHOD, pVtkObject);
+	PyVtk_CallRecord record(PYVTK_ENTRY_OBJECT_METHOD);
+	record.Handle(pVtkObject).String(method).String(format).Handles(pReferences).Strings(argv);
+
+	/* Reads and executions see every write issued before them. */
+	PyVtk_FlushProperties(pIntrospector);
+
+	/* Retrieving node from registry. Returns error if the VTK object has no node. */
+	auto iNode = nodes.find(pVtkObject);
+	if (nodes.end() != iNode)
+	{
+		/* Calling straight into VTK if the method has an accessor and is called without arguments. */
+		const PyVtk_FastMethod *pFast = format == NULL || format[0] == '\0' ? PyVtk_FindFastMethod(pVtkObject, method) : NULL;
+		if (pFast != NULL)
+		{
+			{
+				PyVtk_VtkScope vtk(pVtkObject);
+				pFast->call(pVtkObject);
+			}
+			Py_RETURN_NONE;
+		}
+
+		/* Getting Python node. */
+		PyObject *pNode = iNode->second;
+
+		/* Generating argument list. */
+		size_t argc = argsize(format);
+		PyObject *pArgs = PyVtk_ArgvTuple(format, argc, pReferences.data(), pReferences.size(), argv.data(), argv.size());
+		if (pArgs == NULL)
+		{
+			/* Escalating error. */
+			return NULL;
+		}
+
+		/* Calling the method. */
+		PyObject *pReturn = PyVtk_CallPythonFor(pVtkObject, pIntrospector, "vtkInstanceCall", "OsO", pNode, method, pArgs);
+		Py_XDECREF(pArgs);
+		if (pReturn == NULL)
+		{
+			PyVtk_Error(PYVTK_E_PYTHON, pVtkObject, method, "Method \"%s\" call resulted in error", method);
+			return NULL;
+		}
+
+		return pReturn;
+	}
+	else
+	{
+		PyVtk_Error(PYVTK_E_NOT_REGISTERED, pVtkObject, NULL, "Cannot find node");
+		return NULL;
+	}
+}
+
+
+vtkObjectBase *PyVtk_ObjectMethodAsVtkObject(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	LPCSTR method,
+	LPCSTR vtkClassname,
+	LPCSTR format,
+	const std::vector<vtkObjectBase *> &pReferences,
+	const std::vector<LPCSTR> &argv)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_OBJECT_METHOD_AS_VTK_OBJECT, pVtkObject);
+	PyVtk_CallRecord record(PYVTK_ENTRY_OBJECT_METHOD_AS_VTK_OBJECT);
+	record.Handle(pVtkObject).String(method).String(vtkClassname).String(format).Handles(pReferences).Strings(argv);
+
+	/* Calling the method and getting encoded result. */
+	PyObject *pVal = PyVtk_ObjectMethod(pIntrospector, pVtkObject, method, format, pReferences, argv);
+	if (pVal == NULL)
+	{
+		/* Escalating the error. */
+		return NULL;
+	}
+
+	/* Retrieving VTK Object. */
+	for (auto &node : nodes)
+	{
+		if (node.second == pVal)
+		{
+			Py_DECREF(pVal);
+			return record.Result(node.first);
+		}
+	}
+
+	/* The VTK object is not yet registered. Registering it now. */
+	PyObject *pNewNode = PyVtk_CallPython(pIntrospector, "createVtkObjectWithInstance", "sO", vtkClassname, pVal);
+	if (pNewNode == NULL)
+	{
+		Py_DECREF(pVal);
+		PyVtk_Error(PYVTK_E_PYTHON, pVtkObject, "createVtkObjectWithInstance", "Cannot create node for new object");
+		return NULL;
+	}
+
+	/* Retrieving C object from vtk instance */
+	vtkObjectBase *pReturnVtkObject = vtkPythonUtil::GetPointerFromObject(pVal, vtkClassname);
+	Py_DECREF(pVal);
+
+	/* Adding a node entry to the vtk objects - nodes map. */
+	PyVtk_RegisterNode(pIntrospector, pReturnVtkObject, pNewNode);
+
+	return record.Result(pReturnVtkObject);
+}
+
+
+static void argsize(LPCSTR str, size_t *pRefs, size_t *pVals)
+{
+	size_t maxsize = std::strlen(str);
+	for (int i = 0; i < maxsize; ++i)
+	{
+		if (str[i] == 'o' || str[i] == 'O')
+		{
+			++(*pRefs);
+		}
+		else if (isalpha(str[i]))
+		{
+			/* Spec-ed arguments consume as many values as their size. */
+			int spec = 0;
+			while (isdigit(str[i + 1]))
+			{
+				spec = spec * 10 + (str[i + 1] - '0');
+				++i;
+			}
+			*pVals += spec == 0 ? 1 : spec;
+		}
+	}
+}
+
+
+/*
+ * Intermediaries need to be VTK objects
+ */
+PyObject *PyVtk_PipedObjectMethod(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	const std::vector<LPCSTR> &methods,
+	const std::vector<LPCSTR> &formats,
+	const std::vector<vtkObjectBase *> &pReferences,
+	const std::vector<LPCSTR> &argv)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_PIPED_METHOD, pVtkObject);
+	PyVtk_CallRecord record(PYVTK_ENTRY_PIPED_METHOD);
+	record.Handle(pVtkObject).Strings(methods).Strings(formats).Handles(pReferences).Strings(argv);
+
+#ifdef PYTHON_EMBED_LOG
+	VtkIntrospection::log << "called VtkIntrospection::PipedObjectMethod with pVtkObject = " << pVtkObject << ", method = " << method << ", format = " << format << std::endl;
+	VtkIntrospection::log.flush();
+#endif
+
+	/* Reads and executions see every write issued before them. */
+	PyVtk_FlushProperties(pIntrospector);
+
+	/* Retrieving node from registry. Returns error if the VTK object has no node. */
+	auto iNode = nodes.find(pVtkObject);
+	if (nodes.end() == iNode)
+	{
+		PyVtk_Error(PYVTK_E_NOT_REGISTERED, pVtkObject, NULL, "Cannot find node");
+		return NULL;
+	}
+
+	/* Getting the first arguments. */
+	LPCSTR method = methods[0];
+	LPCSTR format = formats[0];
+	size_t refc = 0;
+	size_t valc = 0;
+	argsize(format, &refc, &valc);
+	if (refc > pReferences.size() || valc > argv.size())
+	{
+		PyVtk_Error(PYVTK_E_ARGUMENT, pVtkObject, method, "Not enough arguments for \"%s\"", method);
+		return NULL;
+	}
+
+	/* First call is on a node. Further calls are not. */
+	PyObject *pArgs = PyVtk_ArgvTuple(format, argsize(format), pReferences.data(), refc, argv.data(), valc);
+	if (pArgs == NULL)
+	{
+		/* Escalating error. */
+		return NULL;
+	}
+
+	PyObject *pPipedCaller = PyVtk_CallPythonFor(pVtkObject, pIntrospector, "vtkInstanceCall", "OsO", iNode->second, method, pArgs);
+	Py_DECREF(pArgs);
+	if (pPipedCaller == NULL)
+	{
+		PyVtk_Error(PYVTK_E_PYTHON, pVtkObject, method, "Method \"%s\" call resulted in error", method);
+		return NULL;
+	}
+
+	for (int i = 1; i < methods.size(); ++i)
+	{
+		/* Getting new arguments. */
+		method = methods[i];
+		format = formats[i];
+		size_t oldrefc = refc;
+		size_t oldvalc = valc;
+		argsize(format, &refc, &valc);
+		if (refc > pReferences.size() || valc > argv.size())
+		{
+			PyVtk_Error(PYVTK_E_ARGUMENT, pVtkObject, method, "Not enough arguments for \"%s\"", method);
+			Py_DECREF(pPipedCaller);
+			return NULL;
+		}
+
+		/* Call on next piped element, on the window of arguments belonging to it. */
+		pArgs = PyVtk_ArgvTuple(format, argsize(format),
+			pReferences.data() + oldrefc, refc - oldrefc,
+			argv.data() + oldvalc, valc - oldvalc);
+		if (pArgs == NULL)
+		{
+			/* Escalating error. */
+			Py_DECREF(pPipedCaller);
+			return NULL;
+		}
+
+		/* Getting the next pipe object. */
+		PyObject *pNextPipedCaller = PyVtk_CallPythonFor(pVtkObject, pIntrospector, "genericCall", "OsO", pPipedCaller, method, pArgs);
+		Py_DECREF(pArgs);
+		if (pNextPipedCaller == NULL)
+		{
+			PyVtk_Error(PYVTK_E_PYTHON, pVtkObject, method, "Could not call \"%s\"", method);
+			Py_DECREF(pPipedCaller);
+			return NULL;
+		}
+
+		/* Swapping to next caller. */
+		Py_DECREF(pPipedCaller);
+		pPipedCaller = pNextPipedCaller;
+	}
+
+	/* Returning the last return value. */
+	return pPipedCaller;
+}
+
+
+LPCSTR PyVtk_PipedObjectMethodAsString(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	const std::vector<LPCSTR> &methods,
+	const std::vector<LPCSTR> &formats,
+	const std::vector<vtkObjectBase *> &pReferences,
+	const std::vector<LPCSTR> &argv)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_PIPED_METHOD_AS_STRING, pVtkObject);
+	PyVtk_CallRecord record(PYVTK_ENTRY_PIPED_METHOD_AS_STRING);
+	record.Handle(pVtkObject).Strings(methods).Strings(formats).Handles(pReferences).Strings(argv);
+
+	/* Calling the method and getting encoded result. */
+	PyObject *pVal = PyVtk_PipedObjectMethod(pIntrospector, pVtkObject, methods, formats, pReferences, argv);
+	if (pVal == NULL)
+	{
+		/* Escalating the error. */
+		return NULL;
+	}
+
+	/* Printing return value as str() does, which decodeValue reads back. */
+	PyObject *pReturn = PyObject_Str(pVal);
+	Py_DECREF(pVal);
+	if (pReturn == NULL)
+	{
+		PyVtk_Error(PYVTK_E_PYTHON, pVtkObject, methods.back(), "Unable to print return value");
+		return NULL;
+	}
+
+	/* Extracting string value into the scratch arena. */
+	LPCSTR str = PyString_AsString(pReturn);
+	if (str != NULL)
+	{
+		str = scratch.CopyString(str);
+	}
+	Py_DECREF(pReturn);
+
+	return str;
+}
+
+
+/*
+ * Typed results. The value a call returns is written into the storage the
+ * caller points the result at, with no text in between, so that it can be
+ * handed to PyVtk_SetVtkObjectPropertyValue or used as it is.
+ */
+static void PyVtk_ClearResult(
+	PyVtk_Result *pResult)
+{
+	PyVtk_ArrayView none = { NULL, 0, 0, 0 };
+	pResult->arity = 0;
+	pResult->str = NULL;
+	pResult->pObject = NULL;
+	pResult->owned = false;
+	pResult->array = none;
+}
+
+
+/*
+ * Room the result has for numbers of its kind.
+ */
+static size_t PyVtk_ResultCapacity(
+	const PyVtk_Result *pResult)
+{
+	if (pResult->kind == PYVTK_RESULT_INT)
+	{
+		return pResult->pIntegers != NULL ? pResult->capacity : 0;
+	}
+	if (pResult->kind == PYVTK_RESULT_DOUBLE)
+	{
+		return pResult->pDoubles != NULL ? pResult->capacity : 0;
+	}
+	return 0;
+}
+
+
+/*
+ * Stores number i of a result. Integers are only taken from ints, as VTK
+ * returns them for integer values; doubles from ints and floats.
+ */
+static bool PyVtk_StoreResultNumber(
+	PyVtk_Result *pResult,
+	size_t i,
+	PyObject *pItem)
+{
+	if (pResult->kind == PYVTK_RESULT_INT)
+	{
+		if (!PyLong_Check(pItem))
+		{
+			return false;
+		}
+		long long value = PyLong_AsLongLong(pItem);
+		if (value == -1 && PyErr_Occurred())
+		{
+			PyErr_Clear();
+			return false;
+		}
+		pResult->pIntegers[i] = value;
+		return true;
+	}
+
+	if (!PyLong_Check(pItem) && !PyFloat_Check(pItem))
+	{
+		return false;
+	}
+	double value = PyFloat_AsDouble(pItem);
+	if (value == -1.0 && PyErr_Occurred())
+	{
+		PyErr_Clear();
+		return false;
+	}
+	pResult->pDoubles[i] = value;
+	return true;
+}
+
+
+/*
+ * Decodes the value returned by a call into a result of the kind asked for.
+ * Numbers come from a single value or from a tuple or list of them. VTK objects
+ * are returned as the pointer a VTK getter would return, which the object that
+ * returned it keeps alive; one only the Python wrapper held is registered for
+ * the caller, as the wrapper is released here.
+ */
+static bool PyVtk_DecodeResult(
+	vtkObjectBase *pVtkObject,
+	LPCSTR method,
+	PyObject *pVal,
+	PyVtk_Result *pResult)
+{
+	switch (pResult->kind)
+	{
+	case PYVTK_RESULT_NONE:
+		return true;
+
+	case PYVTK_RESULT_INT:
+	case PYVTK_RESULT_DOUBLE:
+	{
+		bool sequence = PyTuple_Check(pVal) || PyList_Check(pVal);
+		size_t count = sequence ? (size_t) PySequence_Fast_GET_SIZE(pVal) : 1;
+		if (count > PyVtk_ResultCapacity(pResult))
+		{
+			PyVtk_Error(PYVTK_E_ARGUMENT, pVtkObject, method, "Result of \"%s\" has %d values, more than the storage holds",
+				method, (int) count);
+			return false;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (!PyVtk_StoreResultNumber(pResult, i, sequence ? PySequence_Fast_GET_ITEM(pVal, i) : pVal))
+			{
+				PyVtk_Error(PYVTK_E_FORMAT, pVtkObject, method, "Result of \"%s\" is not %s", method,
+					pResult->kind == PYVTK_RESULT_INT ? "integer" : "numeric");
+				return false;
+			}
+		}
+		pResult->arity = sequence ? count : 0;
+		return true;
+	}
+
+	case PYVTK_RESULT_STRING:
+	{
+		if (pVal == Py_None)
+		{
+			return true;
+		}
+		LPCSTR str = PyUnicode_Check(pVal) ? PyString_AsString(pVal) : NULL;
+		if (str == NULL)
+		{
+			PyErr_Clear();
+			PyVtk_Error(PYVTK_E_FORMAT, pVtkObject, method, "Result of \"%s\" is not a string", method);
+			return false;
+		}
+		pResult->str = scratch.CopyString(str);
+		return true;
+	}
+
+	case PYVTK_RESULT_OBJECT:
+	case PYVTK_RESULT_ARRAY:
+	{
+		if (pVal == Py_None)
+		{
+			return true;
+		}
+		bool array = pResult->kind == PYVTK_RESULT_ARRAY;
+		LPCSTR vtkClassname = array ? "vtkDataArray" : "vtkObjectBase";
+		vtkObjectBase *pInstance = vtkPythonUtil::GetPointerFromObject(pVal, vtkClassname);
+		if (pInstance == NULL)
+		{
+			PyErr_Clear();
+			PyVtk_Error(PYVTK_E_FORMAT, pVtkObject, method, "Result of \"%s\" is not a %s", method, vtkClassname);
+			return false;
+		}
+
+		/* Arrays of another layout have no values to point at. */
+		vtkDataArray *pArray = array ? static_cast<vtkDataArray *>(pInstance) : NULL;
+		if (pArray != NULL && !pArray->HasStandardMemoryLayout())
+		{
+			PyVtk_Error(PYVTK_E_FORMAT, pVtkObject, method, "Result of \"%s\" is not a contiguous array", method);
+			return false;
+		}
+		if (pArray != NULL)
+		{
+			pResult->array.pData = pArray->GetVoidPointer(0);
+			pResult->array.dataType = pArray->GetDataType();
+			pResult->array.components = pArray->GetNumberOfComponents();
+			pResult->array.tuples = pArray->GetNumberOfTuples();
+		}
+
+		if (pInstance->GetReferenceCount() == 1)
+		{
+			pInstance->Register(NULL);
+			pResult->owned = true;
+		}
+		pResult->pObject = pInstance;
+		return true;
+	}
+
+	default:
+		PyVtk_Error(PYVTK_E_ARGUMENT, pVtkObject, method, "Unknown result kind %d", (int) pResult->kind);
+		return false;
+	}
+}
+
+
+/*
+ * Reads the property of a fast getter straight from VTK into the result, if its
+ * value is of the kind asked for and fits the storage.
+ */
+static bool PyVtk_FastResult(
+	const PyVtk_FastProperty *pProperty,
+	vtkObjectBase *pVtkObject,
+	PyVtk_Result *pResult)
+{
+	bool fits = pProperty->format == 's' ? pResult->kind == PYVTK_RESULT_STRING
+		: pResult->kind == PYVTK_RESULT_DOUBLE || (pResult->kind == PYVTK_RESULT_INT && pProperty->format == 'd');
+	if (!fits || (pProperty->format != 's' && std::max(pProperty->size, (size_t) 1) > PyVtk_ResultCapacity(pResult)))
+	{
+		return false;
+	}
+
+	double values[fastVectorSize];
+	LPCSTR str = NULL;
+	{
+		PyVtk_VtkScope vtk(pVtkObject);
+		pProperty->get(pVtkObject, values, &str);
+	}
+
+	if (pProperty->format == 's')
+	{
+		pResult->str = str != NULL ? scratch.CopyString(str) : NULL;
+		return true;
+	}
+	for (size_t i = 0; i < std::max(pProperty->size, (size_t) 1); ++i)
+	{
+		if (pResult->kind == PYVTK_RESULT_INT)
+		{
+			pResult->pIntegers[i] = (long long) values[i];
+		}
+		else
+		{
+			pResult->pDoubles[i] = values[i];
+		}
+	}
+	pResult->arity = pProperty->size;
+	return true;
+}
+
+
+bool PyVtk_ObjectMethodInto(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	LPCSTR method,
+	LPCSTR format,
+	const std::vector<vtkObjectBase *> &pReferences,
+	const std::vector<LPCSTR> &argv,
+	PyVtk_Result *pResult)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_OBJECT_METHOD_INTO, pVtkObject);
+	PyVtk_CallRecord record(PYVTK_ENTRY_OBJECT_METHOD_INTO);
+	record.Handle(pVtkObject).String(method).String(format).Handles(pReferences).Strings(argv);
+
+	if (pResult == NULL)
+	{
+		PyVtk_Error(PYVTK_E_ARGUMENT, pVtkObject, method, "No result for \"%s\"", method);
+		return false;
+	}
+	record.Number(pResult->kind).Number(pResult->capacity);
+	PyVtk_ClearResult(pResult);
+
+	/* Reads see every write issued before them. */
+	PyVtk_FlushProperties(pIntrospector);
+
+	/* Reading straight from VTK if the method is the getter of a fast property. */
+	bool getter = method != NULL && strncmp(method, "Get", 3) == 0 && (format == NULL || format[0] == '\0');
+	const PyVtk_FastProperty *pFast = getter && nodes.end() != nodes.find(pVtkObject) ? PyVtk_FindFastProperty(pVtkObject, method + 3) : NULL;
+	if (pFast != NULL && PyVtk_FastResult(pFast, pVtkObject, pResult))
+	{
+		return true;
+	}
+
+	/* Calling the method and decoding its result. */
+	PyObject *pVal = PyVtk_ObjectMethod(pIntrospector, pVtkObject, method, format, pReferences, argv);
+	if (pVal == NULL)
+	{
+		/* Escalating the error. */
+		return false;
+	}
+
+	bool decoded = PyVtk_DecodeResult(pVtkObject, method, pVal, pResult);
+	Py_DECREF(pVal);
+	record.Result(pResult->pObject);
+
+	return decoded;
+}
+
+
+bool PyVtk_PipedObjectMethodInto(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	const std::vector<LPCSTR> &methods,
+	const std::vector<LPCSTR> &formats,
+	const std::vector<vtkObjectBase *> &pReferences,
+	const std::vector<LPCSTR> &argv,
+	PyVtk_Result *pResult)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_PIPED_METHOD_INTO, pVtkObject);
+	PyVtk_CallRecord record(PYVTK_ENTRY_PIPED_METHOD_INTO);
+	record.Handle(pVtkObject).Strings(methods).Strings(formats).Handles(pReferences).Strings(argv);
+
+	if (pResult == NULL || methods.empty())
+	{
+		PyVtk_Error(PYVTK_E_ARGUMENT, pVtkObject, NULL, "%s", pResult == NULL ? "No result" : "No method");
+		return false;
+	}
+	record.Number(pResult->kind).Number(pResult->capacity);
+	PyVtk_ClearResult(pResult);
+
+	/* Calling the methods and decoding the last result. */
+	PyObject *pVal = PyVtk_PipedObjectMethod(pIntrospector, pVtkObject, methods, formats, pReferences, argv);
+	if (pVal == NULL)
+	{
+		/* Escalating the error. */
+		return false;
+	}
+
+	bool decoded = PyVtk_DecodeResult(pVtkObject, methods.back(), pVal, pResult);
+	Py_DECREF(pVal);
+	record.Result(pResult->pObject);
+
+	return decoded;
+}
+
+
+/*
+ * Piped call chain compiled once by PyVtk_PrepareChain. Formats are parsed into
+ * argument specifications and method names are interned, so that executing the
+ * chain only has to bind the argument values. Each link also caches the method
+ * object resolved on the type of the last object it was called on, which skips
+ * the attribute lookup and the Introspector trampoline while the types along the
+ * chain stay the same, as they do when polling e.g. GetOutput().GetCenter().
+ */
+struct PyVtk_ArgSpec
+{
+	char def;
+	int spec;
+};
+
+struct PyVtk_ChainLink
+{
+	PyObject *pMethodName;
+	std::vector<PyVtk_ArgSpec> args;
+	size_t refc;
+	size_t valc;
+	PyTypeObject *pResolvedType;
+	PyObject *pResolvedMethod;
+};
+
+struct PyVtk_Chain
+{
+	std::vector<PyVtk_ChainLink> links;
+	size_t refc;
+	size_t valc;
+};
+
+
+void PyVtk_ReleaseChain(
+	PyVtk_Chain *pChain)
+{
+	if (pChain == NULL)
+	{
+		return;
+	}
+
+	for (auto &link : pChain->links)
+	{
+		Py_XDECREF(link.pMethodName);
+		Py_XDECREF(link.pResolvedMethod);
+		Py_XDECREF((PyObject *) link.pResolvedType);
+	}
+
+	delete pChain;
+}
+
+
+PyVtk_Chain *PyVtk_PrepareChain(
+	PyObject *pIntrospector,
+	const std::vector<LPCSTR> &methods,
+	const std::vector<LPCSTR> &formats)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_PREPARE_CHAIN);
+	PyVtk_CallRecord record(PYVTK_ENTRY_PREPARE_CHAIN);
+	record.Strings(methods).Strings(formats);
+
+	if (methods.empty() || methods.size() != formats.size())
+	{
+		PyVtk_Error(PYVTK_E_ARGUMENT, NULL, NULL, "A chain needs one format per method");
+		return NULL;
+	}
+
+	PyVtk_Chain *pChain = new PyVtk_Chain();
+	pChain->refc = 0;
+	pChain->valc = 0;
+	pChain->links.reserve(methods.size());
+
+	for (size_t i = 0; i < methods.size(); ++i)
+	{
+		PyVtk_ChainLink link;
+		link.pMethodName = PyUnicode_InternFromString(methods[i]);
+		link.refc = 0;
+		link.valc = 0;
+		link.pResolvedType = NULL;
+		link.pResolvedMethod = NULL;
+		pChain->links.push_back(link);
+
+		if (link.pMethodName == NULL)
+		{
+			PyVtk_Error(PYVTK_E_PYTHON, NULL, methods[i], "Cannot decode method name \"%s\"", methods[i]);
+			PyVtk_ReleaseChain(pChain);
+			return NULL;
+		}
+
+		/* Parsing the format once. */
+		PyVtk_ChainLink &prepared = pChain->links.back();
+		LPCSTR format = formats[i];
+		for (size_t j = 0; format[j] != '\0'; ++j)
+		{
+			PyVtk_ArgSpec arg = { format[j], 0 };
+			if (!isalpha(arg.def))
+			{
+				continue;
+			}
+
+			while (isdigit(format[j + 1]))
+			{
+				arg.spec = arg.spec * 10 + (format[j + 1] - '0');
+				++j;
+			}
+
+			if (arg.def == 'o' || arg.def == 'O')
+			{
+				++prepared.refc;
+			}
+			else
+			{
+				prepared.valc += arg.spec == 0 ? 1 : arg.spec;
+			}
+			prepared.args.push_back(arg);
+		}
+
+		pChain->refc += prepared.refc;
+		pChain->valc += prepared.valc;
+	}
+
+	return record.Result(pChain);
+}
+
+
+/*
+ * Calls one link of a prepared chain on pSelf, made for the node of pVtkObject.
+ * Returns a new reference.
+ */
+static PyObject *PyVtk_ChainLinkCall(
+	PyVtk_ChainLink &link,
+	PyObject *pSelf,
+	vtkObjectBase *const *pReferences,
+	LPCSTR const *argv,
+	const vtkObjectBase *pVtkObject)
+{
+	/* Resolving the method on the type of the caller, unless it is already known. */
+	PyTypeObject *pType = Py_TYPE(pSelf);
+	if (link.pResolvedType != pType)
+	{
+		PyObject *pMethod = PyObject_GetAttr((PyObject *) pType, link.pMethodName);
+		if (pMethod == NULL)
+		{
+			PyVtk_Error(PYVTK_E_PYTHON, NULL, PyUnicode_AsUTF8(link.pMethodName), "Cannot resolve \"%s\" on \"%s\"", PyUnicode_AsUTF8(link.pMethodName), pType->tp_name);
+			return NULL;
+		}
+
+		Py_XDECREF(link.pResolvedMethod);
+		Py_XDECREF((PyObject *) link.pResolvedType);
+		Py_INCREF((PyObject *) pType);
+		link.pResolvedType = pType;
+		link.pResolvedMethod = pMethod;
+	}
+
+	/* The unbound method takes the caller as first argument. */
+	PyObject *pArgs = PyTuple_New(link.args.size() + 1);
+	if (pArgs == NULL)
+	{
+		PyVtk_Error(PYVTK_E_PYTHON, NULL, NULL, "Unable to create a tuple of size %zu", link.args.size() + 1);
+		return NULL;
+	}
+
+	Py_INCREF(pSelf);
+	PyTuple_SET_ITEM(pArgs, 0, pSelf);
+
+	size_t objects = 0;
+	size_t values = 0;
+	for (size_t i = 0; i < link.args.size(); ++i)
+	{
+		PyObject *pVal = PyVtk_ArgvItem(link.args[i].def, link.args[i].spec,
+			pReferences, link.refc, &objects, argv, link.valc, &values);
+		if (pVal == NULL)
+		{
+			Py_DECREF(pArgs);
+			return NULL;
+		}
+		PyTuple_SET_ITEM(pArgs, i + 1, pVal);
+	}
+
+	PyObject *pReturn;
+	{
+		PyVtk_PythonScope python(PyUnicode_AsUTF8(link.pMethodName), pVtkObject);
+		pReturn = PyObject_Call(link.pResolvedMethod, pArgs, NULL);
+	}
+	Py_DECREF(pArgs);
+	if (pReturn == NULL)
+	{
+		PyVtk_Error(PYVTK_E_PYTHON, NULL, PyUnicode_AsUTF8(link.pMethodName), "Method \"%s\" call resulted in error", PyUnicode_AsUTF8(link.pMethodName));
+	}
+
+	return pReturn;
+}
+
+
+/*
+ * Executes a prepared chain on a registered VTK object, binding the given
+ * references and values to the links in order. Returns the last return value.
+ */
+PyObject *PyVtk_ExecuteChain(
+	PyObject *pIntrospector,
+	PyVtk_Chain *pChain,
+	vtkObjectBase *pVtkObject,
+	const std::vector<vtkObjectBase *> &pReferences,
+	const std::vector<LPCSTR> &argv)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_EXECUTE_CHAIN, pVtkObject);
+	PyVtk_CallRecord record(PYVTK_ENTRY_EXECUTE_CHAIN);
+	record.Handle(pChain).Handle(pVtkObject).Handles(pReferences).Strings(argv);
+
+	/* Reads and executions see every write issued before them. */
+	PyVtk_FlushProperties(pIntrospector);
+
+	if (nodes.end() == nodes.find(pVtkObject))
+	{
+		PyVtk_Error(PYVTK_E_NOT_REGISTERED, pVtkObject, NULL, "Cannot find node");
+		return NULL;
+	}
+
+	if (pReferences.size() < pChain->refc || argv.size() < pChain->valc)
+	{
+		PyVtk_Error(PYVTK_E_ARGUMENT, pVtkObject, NULL, "Not enough arguments for the chain");
+		return NULL;
+	}
+
+	/* The first link is called on the wrapped VTK instance of the node. */
+	PyObject *pPipedCaller = vtkPythonUtil::GetObjectFromPointer(pVtkObject);
+	if (pPipedCaller == NULL)
+	{
+		PyVtk_Error(PYVTK_E_PYTHON, pVtkObject, NULL, "Cannot wrap the VTK object");
+		return NULL;
+	}
+
+	size_t refc = 0;
+	size_t valc = 0;
+	for (auto &link : pChain->links)
+	{
+		PyObject *pNextPipedCaller = PyVtk_ChainLinkCall(link, pPipedCaller, pReferences.data() + refc, argv.data() + valc, pVtkObject);
+		Py_DECREF(pPipedCaller);
+		if (pNextPipedCaller == NULL)
+		{
+			/* Escalating error. */
+			return NULL;
+		}
+
+		refc += link.refc;
+		valc += link.valc;
+		pPipedCaller = pNextPipedCaller;
+	}
+
+	return pPipedCaller;
+}
+
+
+/*
+ * Threading of VTK. Filters parallelized with vtkSMPTools use the backend and
+ * thread count configured here, which VTK keeps process-wide; the backend can
+ * only be changed at run time from VTK 9.1 on, earlier versions keeping the one
+ * they were built with.
+ */
+#if VTK_MAJOR_VERSION > 9 || (VTK_MAJOR_VERSION == 9 && VTK_MINOR_VERSION >= 1)
+#define PYVTK_SMP_BACKENDS
+#endif
+
+static size_t smpThreads = 1;
+
+bool PyVtk_ConfigureSmp(
+	LPCSTR backend,
+	size_t threads)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_CONFIGURE_SMP);
+	PyVtk_CallRecord record(PYVTK_ENTRY_CONFIGURE_SMP);
+	record.String(backend).Number(threads);
+
+	if (backend != NULL)
+	{
+#ifdef PYVTK_SMP_BACKENDS
+		if (!vtkSMPTools::SetBackend(backend))
+		{
+			PyVtk_PushError(PYVTK_E_ARGUMENT, NULL, "PyVtk_ConfigureSmp", backend);
+			return false;
+		}
+#else
+		PyVtk_PushError(PYVTK_E_ARGUMENT, NULL, "PyVtk_ConfigureSmp", "The SMP backend is fixed when VTK is built");
+		return false;
+#endif
+	}
+
+	vtkSMPTools::Initialize((int) threads);
+	smpThreads = threads != 0 ? threads : std::max<size_t>(1, std::thread::hardware_concurrency());
+	return true;
+}
+
+
+/*
+ * Name of the SMP backend in use, or NULL if VTK cannot tell.
+ */
+LPCSTR PyVtk_GetSmpBackend()
+{
+#ifdef PYVTK_SMP_BACKENDS
+	return vtkSMPTools::GetBackend();
+#else
+	return NULL;
+#endif
+}
+
+
+/*
+ * Thread budgets. A session, keyed by its Introspector, or a pipeline, keyed by
+ * its sink, may be limited to a number of threads; the scheduler, sweeps and
+ * progressive updates run no more threads for it than the smallest budget that
+ * applies. Every thread of every session is also taken from the cores of the
+ * machine, so concurrent sessions queue for cores instead of oversubscribing
+ * them. Such a thread counts as many cores as vtkSMPTools may use below it, as
+ * configured with PyVtk_ConfigureSmp, and as one core until that is called.
+ */
+class PyVtk_CoreTokens
+{
+public:
+	PyVtk_CoreTokens()
+		: available(std::max<size_t>(1, std::thread::hardware_concurrency())), total(available)
+	{
+	}
+
+	/* Waits for count cores, at most all of them, and returns how many were taken. */
+	size_t Acquire(size_t count)
+	{
+		count = std::max<size_t>(1, std::min(count, total));
+		std::unique_lock<std::mutex> lock(mutex);
+		released.wait(lock, [&]() { return available >= count; });
+		available -= count;
+		return count;
+	}
+
+	void Release(size_t count)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			available += count;
+		}
+		released.notify_all();
+	}
+
+private:
+	std::mutex mutex;
+	std::condition_variable released;
+	size_t available;
+	size_t total;
+};
+
+static PyVtk_CoreTokens coreTokens;
+
+
+/*
+ * Sets the budget of a session, or of the pipeline ending in pVtkSink if given.
+ * A budget of 0 removes it.
+ */
+void PyVtk_SetThreadBudget(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkSink,
+	size_t threads)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_SET_THREAD_BUDGET, pVtkSink);
+	PyVtk_CallRecord record(PYVTK_ENTRY_SET_THREAD_BUDGET);
+	record.Handle(pVtkSink).Number(threads);
+
+	const void *pOwner = pVtkSink != NULL ? (const void *) pVtkSink : (const void *) pIntrospector;
+	if (threads == 0)
+	{
+		threadBudgets.erase(pOwner);
+	}
+	else
+	{
+		threadBudgets[pOwner] = threads;
+	}
+}
+
+
+static size_t PyVtk_GetThreadBudget(
+	PyObject *pIntrospector,
+	const std::vector<vtkObjectBase *> &sinks)
+{
+	size_t budget = std::max<size_t>(1, std::thread::hardware_concurrency());
+	if (threadBudgets.empty())
+	{
+		return budget;
+	}
+
+	auto iSession = threadBudgets.find(pIntrospector);
+	if (threadBudgets.end() != iSession)
+	{
+		budget = std::min(budget, iSession->second);
+	}
+	for (vtkObjectBase *pVtkSink : sinks)
+	{
+		auto iPipeline = threadBudgets.find(pVtkSink);
+		if (threadBudgets.end() != iPipeline)
+		{
+			budget = std::min(budget, iPipeline->second);
+		}
+	}
+	return budget;
+}
+
+
+/*
+ * Collects the algorithms feeding pAlgorithm into the sweep graph. An algorithm
+ * is downstream of the varied one if it is the varied one or if any of its
+ * producers is; only downstream algorithms need to be cloned per worker.
+ */
+static bool PyVtk_SweepCollect(
+	vtkAlgorithm *pAlgorithm,
+	vtkAlgorithm *pVaried,
+	std::unordered_map<vtkAlgorithm *, bool> &downstream)
+{
+	auto iVisited = downstream.find(pAlgorithm);
+	if (downstream.end() != iVisited)
+	{
+		return iVisited->second;
+	}
+
+	bool isDownstream = pAlgorithm == pVaried;
+	for (int port = 0; port < pAlgorithm->GetNumberOfInputPorts(); ++port)
+	{
+		for (int i = 0; i < pAlgorithm->GetNumberOfInputConnections(port); ++i)
+		{
+			vtkAlgorithmOutput *pConnection = pAlgorithm->GetInputConnection(port, i);
+			if (pConnection != NULL && PyVtk_SweepCollect(pConnection->GetProducer(), pVaried, downstream))
+			{
+				isDownstream = true;
+			}
+		}
+	}
+
+	downstream[pAlgorithm] = isDownstream;
+	return isDownstream;
+}
+
+
+/*
+ * Computes the cached ranges of the arrays of a shared data set up front, so
+ * that workers reading it concurrently only ever hit the cache.
+ */
+static void PyVtk_SweepPrewarm(
+	vtkDataObject *pData)
+{
+	vtkDataSet *pDataSet = vtkDataSet::SafeDownCast(pData);
+	if (pDataSet == NULL)
+	{
+		return;
+	}
+
+	pDataSet->GetBounds();
+	vtkDataSetAttributes *attributes[] = { pDataSet->GetPointData(), pDataSet->GetCellData() };
+	for (vtkDataSetAttributes *pAttributes : attributes)
+	{
+		for (int i = 0; i < pAttributes->GetNumberOfArrays(); ++i)
+		{
+			vtkDataArray *pArray = pAttributes->GetArray(i);
+			if (pArray == NULL)
+			{
+				continue;
+			}
+
+			for (int c = -1; c < pArray->GetNumberOfComponents(); ++c)
+			{
+				pArray->GetRange(c);
+			}
+		}
+	}
+}
+
+
+/*
+ * Asks the Introspector for an unregistered copy of a registered algorithm with
+ * the same attribute values. Returns the copy, its node being handed over in
+ * ppCloneNode, or NULL after an error.
+ */
+static vtkAlgorithm *PyVtk_CloneAlgorithm(
+	PyObject *pIntrospector,
+	vtkAlgorithm *pAlgorithm,
+	PyObject **ppCloneNode)
+{
+	PyObject *pCloneNode = PyVtk_CallPythonFor(pAlgorithm, pIntrospector, "cloneVtkObject", "O", nodes[pAlgorithm]);
+	PyObject *pCloneInstance = pCloneNode != NULL ? PyObject_GetAttrString(pCloneNode, "vtkInstance") : NULL;
+	if (pCloneInstance == NULL)
+	{
+		PyVtk_Error(PYVTK_E_PYTHON, pAlgorithm, "cloneVtkObject", "Cannot clone \"%s\"", pAlgorithm->GetClassName());
+		Py_XDECREF(pCloneNode);
+		return NULL;
+	}
+
+	vtkAlgorithm *pClone = (vtkAlgorithm *) vtkPythonUtil::GetPointerFromObject(pCloneInstance, "vtkAlgorithm");
+	Py_DECREF(pCloneInstance);
+	*ppCloneNode = pCloneNode;
+	return pClone;
+}
+
+
+/*
+ * Private copy of the downstream part of a pipeline, owned by one sweep worker.
+ */
+struct PyVtk_SweepWorker
+{
+	std::unordered_map<vtkAlgorithm *, vtkAlgorithm *> clones;
+	std::vector<PyObject *> pCloneNodes;
+	std::vector<vtkObjectBase *> pOwned;
+	PyObject *pVariedNode;
+	vtkAlgorithm *pSink;
+};
+
+
+/*
+ * Evaluates a parameter sweep of one property over a registered pipeline. The
+ * part of the pipeline between the varied object and the sink is cloned once per
+ * worker, while everything upstream of it is updated once and handed to the
+ * clones as shallow copies of its outputs, so the data is shared read-only. The
+ * sweep points are then evaluated in parallel; the GIL is only held to set the
+ * property on the clone, never during VTK execution. The outputs of the sink are
+ * returned in the order of the values, and are owned by the caller.
+ */
+bool PyVtk_SweepVtkObjectProperty(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	LPCSTR propertyName,
+	LPCSTR format,
+	const std::vector<LPCSTR> &values,
+	vtkObjectBase *pVtkSink,
+	size_t threads,
+	std::vector<vtkDataObject *> *pResults)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_SWEEP, pVtkObject);
+	PyVtk_CallRecord record(PYVTK_ENTRY_SWEEP);
+	record.Handle(pVtkObject).String(propertyName).String(format).Strings(values).Handle(pVtkSink).Number(threads);
+
+	/* Reads and executions see every write issued before them. */
+	PyVtk_FlushProperties(pIntrospector);
+
+	vtkAlgorithm *pVaried = vtkAlgorithm::SafeDownCast(pVtkObject);
+	vtkAlgorithm *pSink = vtkAlgorithm::SafeDownCast(pVtkSink);
+	if (pVaried == NULL || pSink == NULL || nodes.end() == nodes.find(pVtkObject))
+	{
+		PyVtk_Error(PYVTK_E_NOT_REGISTERED, pVtkObject, propertyName, "Sweeps need registered algorithms");
+		return false;
+	}
+
+	/* Splitting the pipeline into the shared and the cloned part. */
+	std::unordered_map<vtkAlgorithm *, bool> downstream;
+	if (!PyVtk_SweepCollect(pSink, pVaried, downstream))
+	{
+		PyVtk_Error(PYVTK_E_ARGUMENT, pVtkSink, propertyName, "The sink does not depend on the swept object");
+		return false;
+	}
+
+	/* Bringing the shared producers up to date, once. */
+	std::unordered_map<vtkAlgorithmOutput *, vtkDataObject *> shared;
+	for (auto &entry : downstream)
+	{
+		if (!entry.second)
+		{
+			continue;
+		}
+
+		if (nodes.end() == nodes.find(entry.first))
+		{
+			PyVtk_Error(PYVTK_E_NOT_REGISTERED, entry.first, "cloneVtkObject", "Cannot clone unregistered \"%s\"", entry.first->GetClassName());
+			return false;
+		}
+
+		for (int port = 0; port < entry.first->GetNumberOfInputPorts(); ++port)
+		{
+			for (int i = 0; i < entry.first->GetNumberOfInputConnections(port); ++i)
+			{
+				vtkAlgorithmOutput *pConnection = entry.first->GetInputConnection(port, i);
+				vtkAlgorithm *pProducer = pConnection->GetProducer();
+				if (!downstream[pProducer] && shared.end() == shared.find(pConnection))
+				{
+					pProducer->Update(pConnection->GetIndex());
+					vtkDataObject *pData = pProducer->GetOutputDataObject(pConnection->GetIndex());
+					PyVtk_SweepPrewarm(pData);
+					shared[pConnection] = pData;
+				}
+			}
+		}
+	}
+
+	/* Workers within the thread budget, each counting the cores vtkSMPTools may use under it. */
+	size_t budget = std::max<size_t>(1, PyVtk_GetThreadBudget(pIntrospector, std::vector<vtkObjectBase *>(1, pVtkSink)) / smpThreads);
+	threads = threads == 0 ? budget : std::min(threads, budget);
+	threads = std::max<size_t>(1, std::min(threads, values.size()));
+
+	/* Cloning the downstream part per worker. */
+	std::vector<PyVtk_SweepWorker> workers(threads);
+	bool cloned = true;
+	for (auto &worker : workers)
+	{
+		for (auto &entry : downstream)
+		{
+			if (!entry.second)
+			{
+				continue;
+			}
+
+			PyObject *pCloneNode;
+			vtkAlgorithm *pClone = PyVtk_CloneAlgorithm(pIntrospector, entry.first, &pCloneNode);
+			if (pClone == NULL)
+			{
+				cloned = false;
+				break;
+			}
+
+			worker.pCloneNodes.push_back(pCloneNode);
+			worker.clones[entry.first] = pClone;
+			if (entry.first == pVaried)
+			{
+				worker.pVariedNode = pCloneNode;
+			}
+		}
+
+		if (!cloned)
+		{
+			break;
+		}
+
+		/* Wiring the clones to each other and to the shared data. */
+		for (auto &clone : worker.clones)
+		{
+			vtkAlgorithm *pOriginal = clone.first;
+			for (int port = 0; port < pOriginal->GetNumberOfInputPorts(); ++port)
+			{
+				clone.second->RemoveAllInputConnections(port);
+				for (int i = 0; i < pOriginal->GetNumberOfInputConnections(port); ++i)
+				{
+					vtkAlgorithmOutput *pConnection = pOriginal->GetInputConnection(port, i);
+					auto iClonedProducer = worker.clones.find(pConnection->GetProducer());
+					if (worker.clones.end() != iClonedProducer)
+					{
+						clone.second->AddInputConnection(port, iClonedProducer->second->GetOutputPort(pConnection->GetIndex()));
+					}
+					else
+					{
+						vtkDataObject *pData = shared[pConnection];
+						vtkDataObject *pCopy = pData->NewInstance();
+						pCopy->ShallowCopy(pData);
+
+						vtkTrivialProducer *pProducer = vtkTrivialProducer::New();
+						pProducer->SetOutput(pCopy);
+						pCopy->Delete();
+
+						clone.second->AddInputConnection(port, pProducer->GetOutputPort());
+						worker.pOwned.push_back(pProducer);
+					}
+				}
+			}
+		}
+
+		worker.pSink = worker.clones[pSink];
+	}
+
+	pResults->assign(values.size(), NULL);
+	std::atomic<size_t> next(0);
+	std::atomic<bool> failed(false);
+
+	if (cloned)
+	{
+		/* Evaluating the points on the cores the other sessions leave. The workers
+		   take the GIL only to set the property. */
+		PyThreadState *pThreadState = PyVtk_ReleaseGil();
+		size_t cores = coreTokens.Acquire(threads * smpThreads);
+		size_t workerCount = std::min(threads, std::max<size_t>(1, cores / smpThreads));
+
+		std::vector<std::thread> pool;
+		for (size_t t = 0; t < workerCount; ++t)
+		{
+			pool.emplace_back([&, propertyName, format](PyVtk_SweepWorker *pWorker)
+			{
+				for (size_t i = next++; i < values.size() && !failed; i = next++)
+				{
+					PyVtk_CallScope scope(PYVTK_ENTRY_SWEEP_POINT);
+
+					PyGILState_STATE gil = PyVtk_EnsureGil();
+					PyObject *pCheck = PyVtk_CallPythonFor(pWorker->clones.at(pVaried), pIntrospector, "setVtkObjectAttribute", "Osss", pWorker->pVariedNode, propertyName, format, values[i]);
+					if (pCheck == NULL)
+					{
+						PyVtk_Error(PYVTK_E_PYTHON, pVtkObject, propertyName, "Cannot set the VTK object's attribute \"%s\"", propertyName);
+						failed = true;
+					}
+					Py_XDECREF(pCheck);
+					PyGILState_Release(gil);
+
+					if (failed)
+					{
+						break;
+					}
+
+					{
+						PyVtk_VtkScope vtk(pWorker->pSink, true);
+						pWorker->pSink->Update();
+					}
+
+					vtkDataObject *pOutput = pWorker->pSink->GetOutputDataObject(0);
+					vtkDataObject *pResult = pOutput->NewInstance();
+					pResult->ShallowCopy(pOutput);
+					(*pResults)[i] = pResult;
+				}
+			}, &workers[t]);
+		}
+
+		for (auto &thread : pool)
+		{
+			thread.join();
+		}
+		coreTokens.Release(cores);
+
+		PyVtk_RestoreGil(pThreadState);
+	}
+
+	/* Dropping the clones. */
+	for (auto &worker : workers)
+	{
+		for (vtkObjectBase *pOwned : worker.pOwned)
+		{
+			pOwned->Delete();
+		}
+		for (PyObject *pCloneNode : worker.pCloneNodes)
+		{
+			Py_DECREF(pCloneNode);
+		}
+	}
+
+	return cloned && !failed;
+}
+
+
+/*
+ * Node of the graph handled by the scheduler. An algorithm is dirty if it has no
+ * output yet, was modified since its output was generated, reads an input newer
+ * than its output, or is fed by a dirty algorithm. Its level is the length of
+ * the longest chain of dirty producers above it.
+ */
+struct PyVtk_ScheduleNode
+{
+	bool dirty;
+	size_t level;
+};
+
+
+static const PyVtk_ScheduleNode &PyVtk_ScheduleCollect(
+	vtkAlgorithm *pAlgorithm,
+	std::unordered_map<vtkAlgorithm *, PyVtk_ScheduleNode> &graph)
+{
+	auto iVisited = graph.find(pAlgorithm);
+	if (graph.end() != iVisited)
+	{
+		return iVisited->second;
+	}
+
+	/* Algorithms without outputs, such as writers, are always run. */
+	PyVtk_ScheduleNode node = { pAlgorithm->GetNumberOfOutputPorts() == 0, 0 };
+	vtkMTimeType updateTime = 0;
+	for (int port = 0; port < pAlgorithm->GetNumberOfOutputPorts(); ++port)
+	{
+		vtkDataObject *pData = pAlgorithm->GetOutputDataObject(port);
+		if (pData == NULL || pData->GetUpdateTime() < pAlgorithm->GetMTime())
+		{
+			node.dirty = true;
+		}
+		else if (port == 0 || pData->GetUpdateTime() < updateTime)
+		{
+			updateTime = pData->GetUpdateTime();
+		}
+	}
+
+	for (int port = 0; port < pAlgorithm->GetNumberOfInputPorts(); ++port)
+	{
+		for (int i = 0; i < pAlgorithm->GetNumberOfInputConnections(port); ++i)
+		{
+			vtkAlgorithmOutput *pConnection = pAlgorithm->GetInputConnection(port, i);
+			if (pConnection == NULL)
+			{
+				continue;
+			}
+
+			vtkAlgorithm *pProducer = pConnection->GetProducer();
+			const PyVtk_ScheduleNode &producer = PyVtk_ScheduleCollect(pProducer, graph);
+			if (producer.dirty)
+			{
+				node.dirty = true;
+				node.level = std::max(node.level, producer.level + 1);
+			}
+			else
+			{
+				vtkDataObject *pInput = pProducer->GetOutputDataObject(pConnection->GetIndex());
+				if (pInput != NULL && pInput->GetMTime() > updateTime)
+				{
+					node.dirty = true;
+				}
+			}
+		}
+	}
+
+	return graph[pAlgorithm] = node;
+}
+
+
+/*
+ * Brings the pipelines ending in the given sinks up to date, running branches
+ * that do not depend on each other concurrently. The dirty algorithms are
+ * executed in waves of increasing level, a wave only holding algorithms whose
+ * dirty producers all ran in earlier waves. Within a wave the pipeline requests
+ * are first propagated one algorithm at a time, since they write the
+ * information of shared upstream algorithms; the algorithms then execute in
+ * parallel with the GIL released, each finding everything upstream of it up to
+ * date, and the caches of the shared inputs filled beforehand as for sweeps.
+ * The threads, at most the given number if not 0, are bounded by the thread
+ * budgets and taken from the cores left by the other sessions.
+ * Algorithms whose executive is not a streaming demand driven pipeline are
+ * updated serially. Pipelines requesting different pieces of a shared producer
+ * from one wave are not supported.
+ */
+bool PyVtk_UpdatePipeline(
+	PyObject *pIntrospector,
+	const std::vector<vtkObjectBase *> &sinks,
+	size_t threads)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_UPDATE_PIPELINE);
+	PyVtk_CallRecord record(PYVTK_ENTRY_UPDATE_PIPELINE);
+	record.Handles(sinks).Number(threads);
+
+	/* Reads and executions see every write issued before them, and previewed
+	   sinks that settled are brought to full resolution. */
+	PyVtk_FlushProperties(pIntrospector);
+	PyVtk_SettlePreviews(pIntrospector, &sinks);
+
+	std::unordered_map<vtkAlgorithm *, PyVtk_ScheduleNode> graph;
+	for (vtkObjectBase *pVtkSink : sinks)
+	{
+		vtkAlgorithm *pSink = vtkAlgorithm::SafeDownCast(pVtkSink);
+		if (pSink == NULL)
+		{
+			PyVtk_Error(PYVTK_E_ARGUMENT, pVtkSink, "Update", "Only algorithms can be updated");
+			return false;
+		}
+		PyVtk_ScheduleCollect(pSink, graph);
+	}
+
+	/* Ordering the dirty algorithms topologically, by level. */
+	std::vector<std::vector<vtkAlgorithm *> > waves;
+	for (auto &entry : graph)
+	{
+		if (entry.second.dirty)
+		{
+			if (waves.size() <= entry.second.level)
+			{
+				waves.resize(entry.second.level + 1);
+			}
+			waves[entry.second.level].push_back(entry.first);
+		}
+	}
+
+	/* Threads of the scheduler, each counting the cores vtkSMPTools may use under it. */
+	size_t budget = std::max<size_t>(1, PyVtk_GetThreadBudget(pIntrospector, sinks) / smpThreads);
+	threads = threads == 0 ? budget : std::min(threads, budget);
+
+	std::atomic<bool> failed(false);
+	for (auto &wave : waves)
+	{
+		/* Propagating the requests of the wave. */
+		std::vector<vtkAlgorithm *> ready;
+		for (vtkAlgorithm *pAlgorithm : wave)
+		{
+			int port = pAlgorithm->GetNumberOfOutputPorts() > 0 ? 0 : -1;
+			vtkStreamingDemandDrivenPipeline *pExecutive = vtkStreamingDemandDrivenPipeline::SafeDownCast(pAlgorithm->GetExecutive());
+
+			PyVtk_VtkScope vtk(pAlgorithm);
+			if (pExecutive == NULL)
+			{
+				pAlgorithm->Update();
+			}
+			else if (!pExecutive->UpdateInformation() || !pExecutive->PropagateUpdateExtent(port))
+			{
+				PyVtk_Error(PYVTK_E_VTK_ERROR, pAlgorithm, "Update", "Cannot propagate the request of \"%s\"", pAlgorithm->GetClassName());
+				failed = true;
+			}
+			else
+			{
+				ready.push_back(pAlgorithm);
+			}
+		}
+
+		/* Filling the caches of the inputs the wave reads concurrently. */
+		for (vtkAlgorithm *pAlgorithm : ready)
+		{
+			for (int port = 0; port < pAlgorithm->GetNumberOfInputPorts(); ++port)
+			{
+				for (int i = 0; i < pAlgorithm->GetNumberOfInputConnections(port); ++i)
+				{
+					PyVtk_SweepPrewarm(pAlgorithm->GetInputDataObject(port, i));
+				}
+			}
+		}
+
+		if (failed)
+		{
+			break;
+		}
+
+		/* Executing the wave on the cores the other sessions leave. */
+		PyThreadState *pThreadState = PyVtk_ReleaseGil();
+		size_t cores = coreTokens.Acquire(std::min(threads, ready.size()) * smpThreads);
+
+		std::atomic<size_t> next(0);
+		std::vector<std::thread> pool;
+		for (size_t t = 0; t < std::max<size_t>(1, cores / smpThreads); ++t)
+		{
+			pool.emplace_back([&]()
+			{
+				for (size_t i = next++; i < ready.size(); i = next++)
+				{
+					PyVtk_CallScope scope(PYVTK_ENTRY_UPDATE_PIPELINE_NODE, ready[i]);
+					PyVtk_VtkScope vtk(ready[i], true);
+
+					int port = ready[i]->GetNumberOfOutputPorts() > 0 ? 0 : -1;
+					vtkStreamingDemandDrivenPipeline *pExecutive = static_cast<vtkStreamingDemandDrivenPipeline *>(ready[i]->GetExecutive());
+					if (!pExecutive->UpdateData(port))
+					{
+						PyVtk_PushError(PYVTK_E_VTK_ERROR, ready[i], "Update", "Execution failed");
+						failed = true;
+					}
+				}
+			});
+		}
+
+		for (auto &thread : pool)
+		{
+			thread.join();
+		}
+
+		coreTokens.Release(cores);
+		PyVtk_RestoreGil(pThreadState);
+
+		if (failed)
+		{
+			break;
+		}
+	}
+
+	return !failed;
+}
+
+
+/*
+ * Progressive execution of seeded filters. The seeds of the filter, on its
+ * input port 1 as for vtkStreamTracer, are split into chunks integrated by
+ * per-worker clones of the filter, each reading the field through a shallow
+ * copy of its producer's output, as for sweeps. The output of every chunk is
+ * handed to the callback as soon as it is done, on the calling thread and
+ * without the GIL, in the order the chunks complete. A modification of the
+ * filter or of its producers, or the callback returning false, abandons the
+ * remaining chunks; the call then returns false without raising an error.
+ * Otherwise the outputs of the chunks are appended in the order of the seeds,
+ * and returned in ppResult if given, owned by the caller. The output of the
+ * filter itself is left untouched.
+ */
+static const size_t progressiveChunks = 16;
+
+static void PyVtk_ProgressiveEvent(
+	vtkObject *pCaller,
+	unsigned long eventId,
+	void *pClientData,
+	void *pCallData)
+{
+	*(std::atomic<bool> *) pClientData = true;
+}
+
+
+bool PyVtk_ProgressiveUpdate(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkFilter,
+	size_t chunkSize,
+	size_t threads,
+	PyVtk_ChunkCallback callback,
+	void *pContext,
+	vtkDataObject **ppResult)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_PROGRESSIVE_UPDATE, pVtkFilter);
+	PyVtk_CallRecord record(PYVTK_ENTRY_PROGRESSIVE_UPDATE);
+	record.Handle(pVtkFilter).Number(chunkSize).Number(threads);
+
+	if (ppResult != NULL)
+	{
+		*ppResult = NULL;
+	}
+
+	/* Reads and executions see every write issued before them. */
+	PyVtk_FlushProperties(pIntrospector);
+
+	vtkAlgorithm *pFilter = vtkAlgorithm::SafeDownCast(pVtkFilter);
+	if (pFilter == NULL || nodes.end() == nodes.find(pVtkFilter))
+	{
+		PyVtk_Error(PYVTK_E_NOT_REGISTERED, pVtkFilter, "Update", "Progressive execution needs a registered algorithm");
+		return false;
+	}
+	if (pFilter->GetNumberOfInputPorts() < 2 || pFilter->GetNumberOfInputConnections(1) != 1
+		|| vtkPolyData::SafeDownCast(pFilter->GetOutputDataObject(0)) == NULL)
+	{
+		PyVtk_Error(PYVTK_E_ARGUMENT, pVtkFilter, "Update", "\"%s\" does not produce polygonal data from seeds on port 1", pFilter->GetClassName());
+		return false;
+	}
+
+	/* Bringing the producers up to date, once, and watching them for changes. */
+	std::atomic<bool> changed(false);
+	vtkCallbackCommand *pObserver = vtkCallbackCommand::New();
+	pObserver->SetCallback(PyVtk_ProgressiveEvent);
+	pObserver->SetClientData(&changed);
+
+	std::vector<vtkObject *> pWatched(1, pFilter);
+	std::unordered_map<vtkAlgorithmOutput *, vtkDataObject *> shared;
+	for (int port = 0; port < pFilter->GetNumberOfInputPorts(); ++port)
+	{
+		for (int i = 0; i < pFilter->GetNumberOfInputConnections(port); ++i)
+		{
+			vtkAlgorithmOutput *pConnection = pFilter->GetInputConnection(port, i);
+			vtkAlgorithm *pProducer = pConnection->GetProducer();
+			{
+				PyVtk_VtkScope vtk(pProducer);
+				pProducer->Update(pConnection->GetIndex());
+			}
+
+			vtkDataObject *pData = pProducer->GetOutputDataObject(pConnection->GetIndex());
+			PyVtk_SweepPrewarm(pData);
+			shared[pConnection] = pData;
+			pWatched.push_back(pProducer);
+		}
+	}
+
+	std::vector<unsigned long> observerTags;
+	for (vtkObject *pObject : pWatched)
+	{
+		observerTags.push_back(pObject->AddObserver(vtkCommand::ModifiedEvent, pObserver));
+	}
+
+	/* Splitting the seeds into chunks of points. */
+	vtkAlgorithmOutput *pSeedConnection = pFilter->GetInputConnection(1, 0);
+	vtkDataSet *pSeeds = vtkDataSet::SafeDownCast(shared[pSeedConnection]);
+	vtkIdType seeds = pSeeds != NULL ? pSeeds->GetNumberOfPoints() : 0;
+	if (chunkSize == 0)
+	{
+		chunkSize = std::max<size_t>(1, ((size_t) seeds + progressiveChunks - 1) / progressiveChunks);
+	}
+
+	std::vector<vtkPolyData *> chunks;
+	for (vtkIdType first = 0; first < seeds; first += (vtkIdType) chunkSize)
+	{
+		vtkIdType count = std::min<vtkIdType>((vtkIdType) chunkSize, seeds - first);
+		vtkPoints *pPoints = vtkPoints::New();
+		pPoints->SetNumberOfPoints(count);
+		for (vtkIdType i = 0; i < count; ++i)
+		{
+			double point[3];
+			pSeeds->GetPoint(first + i, point);
+			pPoints->SetPoint(i, point);
+		}
+
+		vtkPolyData *pChunk = vtkPolyData::New();
+		pChunk->SetPoints(pPoints);
+		pPoints->Delete();
+		chunks.push_back(pChunk);
+	}
+
+	/* Workers within the thread budget, each counting the cores vtkSMPTools may use under it. */
+	size_t budget = std::max<size_t>(1, PyVtk_GetThreadBudget(pIntrospector, std::vector<vtkObjectBase *>(1, pVtkFilter)) / smpThreads);
+	threads = threads == 0 ? budget : std::min(threads, budget);
+	threads = std::max<size_t>(1, std::min(threads, chunks.size()));
+
+	/* Cloning the filter per worker, wired to the shared field and to its own seeds. */
+	std::vector<PyVtk_SweepWorker> workers(threads);
+	std::vector<vtkTrivialProducer *> seedProducers;
+	bool cloned = true;
+	for (auto &worker : workers)
+	{
+		PyObject *pCloneNode;
+		vtkAlgorithm *pClone = PyVtk_CloneAlgorithm(pIntrospector, pFilter, &pCloneNode);
+		if (pClone == NULL)
+		{
+			cloned = false;
+			break;
+		}
+
+		worker.pCloneNodes.push_back(pCloneNode);
+		worker.pVariedNode = pCloneNode;
+		worker.pSink = pClone;
+		for (int port = 0; port < pFilter->GetNumberOfInputPorts(); ++port)
+		{
+			pClone->RemoveAllInputConnections(port);
+			for (int i = 0; i < pFilter->GetNumberOfInputConnections(port); ++i)
+			{
+				vtkTrivialProducer *pProducer = vtkTrivialProducer::New();
+				if (port == 1)
+				{
+					seedProducers.push_back(pProducer);
+				}
+				else
+				{
+					vtkDataObject *pData = shared[pFilter->GetInputConnection(port, i)];
+					vtkDataObject *pCopy = pData->NewInstance();
+					pCopy->ShallowCopy(pData);
+					pProducer->SetOutput(pCopy);
+					pCopy->Delete();
+				}
+
+				pClone->AddInputConnection(port, pProducer->GetOutputPort());
+				worker.pOwned.push_back(pProducer);
+			}
+		}
+	}
+
+	std::vector<vtkPolyData *> outputs(chunks.size(), NULL);
+	bool abandoned = changed;
+	if (cloned && !abandoned)
+	{
+		/* Integrating the chunks on the cores the other sessions leave. */
+		PyThreadState *pThreadState = PyVtk_ReleaseGil();
+		size_t cores = coreTokens.Acquire(threads * smpThreads);
+		size_t workerCount = std::min(threads, std::max<size_t>(1, cores / smpThreads));
+		size_t running = workerCount;
+
+		std::atomic<size_t> next(0);
+		std::atomic<bool> stop(false);
+		std::mutex doneMutex;
+		std::condition_variable doneChanged;
+		std::deque<size_t> done;
+
+		std::vector<std::thread> pool;
+		for (size_t t = 0; t < workerCount; ++t)
+		{
+			pool.emplace_back([&](size_t worker)
+			{
+				vtkAlgorithm *pClone = workers[worker].pSink;
+				for (size_t i = next++; i < chunks.size() && !stop; i = next++)
+				{
+					PyVtk_CallScope scope(PYVTK_ENTRY_PROGRESSIVE_CHUNK, pFilter);
+					seedProducers[worker]->SetOutput(chunks[i]);
+					{
+						PyVtk_VtkScope vtk(pClone, true);
+						pClone->Update();
+					}
+
+					vtkPolyData *pOutput = vtkPolyData::New();
+					pOutput->ShallowCopy(pClone->GetOutputDataObject(0));
+					outputs[i] = pOutput;
+
+					std::lock_guard<std::mutex> lock(doneMutex);
+					done.push_back(i);
+					doneChanged.notify_one();
+				}
+
+				std::lock_guard<std::mutex> lock(doneMutex);
+				--running;
+				doneChanged.notify_one();
+			}, t);
+		}
+
+		/* Announcing the chunks as they complete, until all are in or the run is abandoned. */
+		size_t announced = 0;
+		std::unique_lock<std::mutex> lock(doneMutex);
+		while (announced < chunks.size() && !abandoned)
+		{
+			doneChanged.wait_for(lock, std::chrono::milliseconds(10), [&]() { return !done.empty() || running == 0 || changed; });
+			if (changed || (done.empty() && running == 0))
+			{
+				abandoned = true;
+				break;
+			}
+			if (done.empty())
+			{
+				continue;
+			}
+
+			size_t i = done.front();
+			done.pop_front();
+			lock.unlock();
+			++announced;
+			if (callback != NULL && !callback(pContext, outputs[i], announced, chunks.size()))
+			{
+				abandoned = true;
+			}
+			lock.lock();
+		}
+		lock.unlock();
+
+		stop = true;
+		for (auto &thread : pool)
+		{
+			thread.join();
+		}
+		coreTokens.Release(cores);
+
+		/* Joining the chunks in the order of the seeds. */
+		if (!abandoned && ppResult != NULL)
+		{
+			vtkAppendPolyData *pAppend = vtkAppendPolyData::New();
+			for (vtkPolyData *pOutput : outputs)
+			{
+				pAppend->AddInputData(pOutput);
+			}
+			{
+				PyVtk_VtkScope vtk(pAppend, true);
+				pAppend->Update();
+			}
+
+			vtkPolyData *pResult = vtkPolyData::New();
+			pResult->ShallowCopy(pAppend->GetOutput());
+			pAppend->Delete();
+			*ppResult = pResult;
+		}
+
+		PyVtk_RestoreGil(pThreadState);
+	}
+
+	/* Dropping the observers, chunks and clones. */
+	for (size_t i = 0; i < pWatched.size(); ++i)
+	{
+		pWatched[i]->RemoveObserver(observerTags[i]);
+	}
+	pObserver->Delete();
+
+	for (vtkPolyData *pChunk : chunks)
+	{
+		pChunk->Delete();
+	}
+	for (vtkPolyData *pOutput : outputs)
+	{
+		if (pOutput != NULL)
+		{
+			pOutput->Delete();
+		}
+	}
+	for (auto &worker : workers)
+	{
+		for (vtkObjectBase *pOwned : worker.pOwned)
+		{
+			pOwned->Delete();
+		}
+		for (PyObject *pCloneNode : worker.pCloneNodes)
+		{
+			Py_DECREF(pCloneNode);
+		}
+	}
+
+	return cloned && !abandoned;
+}
+
+
+/*
+ * Replay of a recording. Calls are re-executed in order against the given
+ * Introspector, mapping the recorded ids to the objects the replay creates.
+ * Objects that were passed in without having been created through the API, such
+ * as mappers owned by the host, are stood in for by new objects of the same
+ * class. The latency of each call is reported next to the recorded one.
+ */
+static bool PyVtk_GetVarint(
+	FILE *pFile,
+	unsigned long long *pValue)
+{
+	unsigned long long value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		int byte = fgetc(pFile);
+		if (byte == EOF)
+		{
+			return false;
+		}
+		value |= (unsigned long long) (byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			*pValue = value;
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool PyVtk_GetString(
+	FILE *pFile,
+	std::string *pStr,
+	bool *pNull)
+{
+	unsigned long long len;
+	if (!PyVtk_GetVarint(pFile, &len))
+	{
+		return false;
+	}
+
+	*pNull = len == 0;
+	pStr->resize(len > 0 ? (size_t) len - 1 : 0);
+	return pStr->empty() || fread(&(*pStr)[0], 1, pStr->size(), pFile) == pStr->size();
+}
+
+
+class PyVtk_Replayer
+{
+public:
+	PyVtk_Replayer(PyObject *pIntrospector, FILE *pFile)
+		: valid(true), pIntrospector(pIntrospector), pFile(pFile), resultId(0)
+	{
+	}
+
+	~PyVtk_Replayer()
+	{
+		for (PyVtk_Chain *pChain : chains)
+		{
+			PyVtk_ReleaseChain(pChain);
+		}
+	}
+
+	/* Reads the items of the next record, up to its end. */
+	bool Read()
+	{
+		items.clear();
+		resultId = 0;
+
+		for (;;)
+		{
+			unsigned long long kind;
+			if (!PyVtk_GetVarint(pFile, &kind))
+			{
+				return false;
+			}
+			if (kind == PYVTK_ITEM_END)
+			{
+				return true;
+			}
+			if (kind == PYVTK_ITEM_RESULT)
+			{
+				if (!ReadHandle(&resultId))
+				{
+					return false;
+				}
+				continue;
+			}
+
+			items.push_back(Item());
+			Item &item = items.back();
+			item.kind = (int) kind;
+			bool ok = true;
+			unsigned long long count = 0;
+			switch (kind)
+			{
+			case PYVTK_ITEM_STRING:
+			{
+				bool null;
+				item.strings.resize(1);
+				ok = ReadString(&item.strings[0], &null);
+				item.nulls.assign(1, null);
+				break;
+			}
+			case PYVTK_ITEM_NUMBER:
+				ok = PyVtk_GetVarint(pFile, &item.number);
+				break;
+			case PYVTK_ITEM_HANDLE:
+				item.handles.resize(1);
+				ok = ReadHandle(&item.handles[0]);
+				break;
+			case PYVTK_ITEM_STRINGS:
+				ok = PyVtk_GetVarint(pFile, &count);
+				item.strings.resize(ok ? (size_t) count : 0);
+				item.nulls.resize(item.strings.size());
+				for (size_t i = 0; ok && i < item.strings.size(); ++i)
+				{
+					bool null;
+					ok = ReadString(&item.strings[i], &null);
+					item.nulls[i] = null;
+				}
+				break;
+			case PYVTK_ITEM_HANDLES:
+				ok = PyVtk_GetVarint(pFile, &count);
+				item.handles.resize(ok ? (size_t) count : 0);
+				for (size_t i = 0; ok && i < item.handles.size(); ++i)
+				{
+					ok = ReadHandle(&item.handles[i]);
+				}
+				break;
+			default:
+				ok = false;
+			}
+
+			if (!ok)
+			{
+				return false;
+			}
+		}
+	}
+
+	LPCSTR String(size_t i)
+	{
+		if (i >= items.size() || items[i].kind != PYVTK_ITEM_STRING)
+		{
+			valid = false;
+			return NULL;
+		}
+		return items[i].nulls[0] ? NULL : items[i].strings[0].c_str();
+	}
+
+	unsigned long long Number(size_t i)
+	{
+		if (i >= items.size() || items[i].kind != PYVTK_ITEM_NUMBER)
+		{
+			valid = false;
+			return 0;
+		}
+		return items[i].number;
+	}
+
+	void *Handle(size_t i)
+	{
+		if (i >= items.size() || items[i].kind != PYVTK_ITEM_HANDLE)
+		{
+			valid = false;
+			return NULL;
+		}
+		return Resolve(items[i].handles[0]);
+	}
+
+	unsigned long long HandleId(size_t i)
+	{
+		return i < items.size() && items[i].kind == PYVTK_ITEM_HANDLE ? items[i].handles[0] : 0;
+	}
+
+	vtkObjectBase *Object(size_t i)
+	{
+		void *pHandle = Handle(i);
+		auto iClass = classes.find(HandleId(i));
+		if (pHandle != NULL && iClass != classes.end() && iClass->second == "PyVtk_Chain")
+		{
+			valid = false;
+			return NULL;
+		}
+		return (vtkObjectBase *) pHandle;
+	}
+
+	std::vector<LPCSTR> Strings(size_t i)
+	{
+		std::vector<LPCSTR> strings;
+		if (i >= items.size() || items[i].kind != PYVTK_ITEM_STRINGS)
+		{
+			valid = false;
+			return strings;
+		}
+		for (size_t j = 0; j < items[i].strings.size(); ++j)
+		{
+			strings.push_back(items[i].nulls[j] ? NULL : items[i].strings[j].c_str());
+		}
+		return strings;
+	}
+
+	std::vector<vtkObjectBase *> Handles(size_t i)
+	{
+		std::vector<vtkObjectBase *> handles;
+		if (i >= items.size() || items[i].kind != PYVTK_ITEM_HANDLES)
+		{
+			valid = false;
+			return handles;
+		}
+		for (unsigned long long id : items[i].handles)
+		{
+			handles.push_back((vtkObjectBase *) Resolve(id));
+		}
+		return handles;
+	}
+
+	void SetResult(void *pResult)
+	{
+		if (resultId != 0 && pResult != NULL)
+		{
+			objects[resultId] = pResult;
+		}
+	}
+
+	/* Binds a list of handles to the objects the replayed call returned for them. */
+	void SetResults(size_t i, const std::vector<vtkObjectBase *> &results)
+	{
+		if (i >= items.size() || items[i].kind != PYVTK_ITEM_HANDLES)
+		{
+			valid = false;
+			return;
+		}
+		for (size_t j = 0; j < items[i].handles.size() && j < results.size(); ++j)
+		{
+			if (items[i].handles[j] != 0 && results[j] != NULL)
+			{
+				objects[items[i].handles[j]] = results[j];
+			}
+		}
+	}
+
+	void Forget(unsigned long long id)
+	{
+		objects.erase(id);
+	}
+
+	void KeepChain(PyVtk_Chain *pChain)
+	{
+		if (pChain != NULL)
+		{
+			chains.push_back(pChain);
+		}
+	}
+
+	bool valid;
+
+private:
+	struct Item
+	{
+		int kind;
+		unsigned long long number;
+		std::vector<std::string> strings;
+		std::vector<bool> nulls;
+		std::vector<unsigned long long> handles;
+	};
+
+	bool ReadString(std::string *pStr, bool *pNull)
+	{
+		return PyVtk_GetString(pFile, pStr, pNull);
+	}
+
+	/* A new id carries its class and invalidates whatever the id stood for. */
+	bool ReadHandle(unsigned long long *pId)
+	{
+		unsigned long long value;
+		if (!PyVtk_GetVarint(pFile, &value))
+		{
+			return false;
+		}
+
+		*pId = value >> 1;
+		if (value & 1)
+		{
+			bool null;
+			std::string className;
+			if (!ReadString(&className, &null))
+			{
+				return false;
+			}
+			classes[*pId] = className;
+			objects.erase(*pId);
+		}
+		return true;
+	}
+
+	void *Resolve(unsigned long long id)
+	{
+		if (id == 0)
+		{
+			return NULL;
+		}
+
+		auto iObject = objects.find(id);
+		if (iObject != objects.end())
+		{
+			return iObject->second;
+		}
+
+		/* Standing in for an object the host created on its own. */
+		auto iClass = classes.find(id);
+		if (iClass == classes.end() || iClass->second.empty()
+			|| iClass->second == "PyVtk_Chain" || iClass->second == "vtkAlgorithmOutput")
+		{
+			return NULL;
+		}
+
+		vtkObjectBase *pStandIn = PyVtk_CreateVtkObject(pIntrospector, iClass->second.c_str());
+		if (pStandIn != NULL)
+		{
+			objects[id] = pStandIn;
+		}
+		return pStandIn;
+	}
+
+	PyObject *pIntrospector;
+	FILE *pFile;
+	std::vector<Item> items;
+	unsigned long long resultId;
+	std::unordered_map<unsigned long long, void *> objects;
+	std::unordered_map<unsigned long long, std::string> classes;
+	std::vector<PyVtk_Chain *> chains;
+};
+
+
+bool PyVtk_ReplayRecording(
+	PyObject *pIntrospector,
+	LPCSTR path,
+	bool originalTiming,
+	PyVtk_ReplayCallback callback,
+	void *pContext)
+{
+	FILE *pFile = fopen(path, "rb");
+	if (pFile == NULL)
+	{
+		PyVtk_PushError(PYVTK_E_ARGUMENT, NULL, "PyVtk_ReplayRecording", path);
+		return false;
+	}
+
+	char magic[sizeof(recordingMagic)];
+	unsigned long long version = 0;
+	if (fread(magic, 1, sizeof(magic), pFile) != sizeof(magic) || memcmp(magic, recordingMagic, sizeof(magic)) != 0
+		|| !PyVtk_GetVarint(pFile, &version) || version != recordingVersion)
+	{
+		PyVtk_PushError(PYVTK_E_FORMAT, NULL, "PyVtk_ReplayRecording", path);
+		fclose(pFile);
+		return false;
+	}
+
+	PyVtk_Replayer replay(pIntrospector, pFile);
+	std::chrono::steady_clock::time_point replayStart = std::chrono::steady_clock::now();
+	bool complete = true;
+
+	for (size_t index = 0;; ++index)
+	{
+		unsigned long long entry, timestamp, duration;
+		if (!PyVtk_GetVarint(pFile, &entry))
+		{
+			break;
+		}
+		if (!PyVtk_GetVarint(pFile, &timestamp) || !PyVtk_GetVarint(pFile, &duration) || !replay.Read()
+			|| entry >= PYVTK_ENTRY_COUNT)
+		{
+			PyVtk_PushError(PYVTK_E_FORMAT, NULL, "PyVtk_ReplayRecording", "Truncated or corrupt record");
+			complete = false;
+			break;
+		}
+
+		if (originalTiming)
+		{
+			std::this_thread::sleep_until(replayStart + std::chrono::nanoseconds(timestamp));
+		}
+
+		/* Arguments are resolved before the clock starts, as stand-ins are created then. */
+		replay.valid = true;
+		bool succeeded = false;
+		unsigned long long start = 0, replayed = 0;
+		switch (entry)
+		{
+		case PYVTK_ENTRY_CREATE:
+		{
+			LPCSTR className = replay.String(0);
+			if (replay.valid)
+			{
+				start = PyVtk_Now();
+				vtkObjectBase *pVtkObject = PyVtk_CreateVtkObject(pIntrospector, className);
+				replayed = PyVtk_Now() - start;
+				replay.SetResult(pVtkObject);
+				succeeded = pVtkObject != NULL;
+			}
+			break;
+		}
+		case PYVTK_ENTRY_GET_PROPERTY:
+		{
+			vtkObjectBase *pVtkObject = replay.Object(0);
+			LPCSTR propertyName = replay.String(1), expectedType = replay.String(2);
+			if (replay.valid)
+			{
+				start = PyVtk_Now();
+				succeeded = PyVtk_GetVtkObjectProperty(pIntrospector, pVtkObject, propertyName, expectedType) != NULL;
+				replayed = PyVtk_Now() - start;
+			}
+			break;
+		}
+		case PYVTK_ENTRY_SET_PROPERTY:
+		{
+			vtkObjectBase *pVtkObject = replay.Object(0);
+			LPCSTR propertyName = replay.String(1), format = replay.String(2), newValue = replay.String(3);
+			if (replay.valid)
+			{
+				start = PyVtk_Now();
+				succeeded = PyVtk_SetVtkObjectProperty(pIntrospector, pVtkObject, propertyName, format, newValue) == PYVTK_OK;
+				replayed = PyVtk_Now() - start;
+			}
+			break;
+		}
+		case PYVTK_ENTRY_GET_DESCRIPTOR:
+		{
+			vtkObjectBase *pVtkObject = replay.Object(0);
+			if (replay.valid)
+			{
+				start = PyVtk_Now();
+				succeeded = PyVtk_GetVtkObjectDescriptor(pIntrospector, pVtkObject) != NULL;
+				replayed = PyVtk_Now() - start;
+			}
+			break;
+		}
+		case PYVTK_ENTRY_DELETE:
+		{
+			vtkObjectBase *pVtkObject = replay.Object(0);
+			if (replay.valid)
+			{
+				start = PyVtk_Now();
+				succeeded = PyVtk_DeleteVtkObject(pIntrospector, pVtkObject);
+				replayed = PyVtk_Now() - start;
+				replay.Forget(replay.HandleId(0));
+			}
+			break;
+		}
+		case PYVTK_ENTRY_GET_OUTPUT_PORT:
+		{
+			vtkObjectBase *pVtkObject = replay.Object(0);
+			if (replay.valid)
+			{
+				start = PyVtk_Now();
+				vtkAlgorithmOutput *pPort = PyVtk_GetOutputPort(pIntrospector, pVtkObject);
+				replayed = PyVtk_Now() - start;
+				replay.SetResult(pPort);
+				succeeded = pPort != NULL;
+			}
+			break;
+		}
+		case PYVTK_ENTRY_CONNECT:
+		{
+			vtkObjectBase *pVtkObject = replay.Object(0);
+			vtkAlgorithm *pVtkTarget = vtkAlgorithm::SafeDownCast(replay.Object(1));
+			if (replay.valid)
+			{
+				start = PyVtk_Now();
+				succeeded = PyVtk_ConnectVtkObject(pIntrospector, pVtkObject, pVtkTarget);
+				replayed = PyVtk_Now() - start;
+			}
+			break;
+		}
+		case PYVTK_ENTRY_OBJECT_METHOD:
+		{
+			vtkObjectBase *pVtkObject = replay.Object(0);
+			LPCSTR method = replay.String(1), format = replay.String(2);
+			std::vector<vtkObjectBase *> references = replay.Handles(3);
+			std::vector<LPCSTR> argv = replay.Strings(4);
+			if (replay.valid)
+			{
+				start = PyVtk_Now();
+				PyObject *pReturn = PyVtk_ObjectMethod(pIntrospector, pVtkObject, method, format, references, argv);
+				replayed = PyVtk_Now() - start;
+				succeeded = pReturn != NULL;
+				Py_XDECREF(pReturn);
+			}
+			break;
+		}
+		case PYVTK_ENTRY_OBJECT_METHOD_AS_VTK_OBJECT:
+		{
+			vtkObjectBase *pVtkObject = replay.Object(0);
+			LPCSTR method = replay.String(1), vtkClassname = replay.String(2), format = replay.String(3);
+			std::vector<vtkObjectBase *> references = replay.Handles(4);
+			std::vector<LPCSTR> argv = replay.Strings(5);
+			if (replay.valid)
+			{
+				start = PyVtk_Now();
+				vtkObjectBase *pReturn = PyVtk_ObjectMethodAsVtkObject(pIntrospector, pVtkObject, method, vtkClassname, format, references, argv);
+				replayed = PyVtk_Now() - start;
+				replay.SetResult(pReturn);
+				succeeded = pReturn != NULL;
+			}
+			break;
+		}
+		case PYVTK_ENTRY_PIPED_METHOD:
+		case PYVTK_ENTRY_PIPED_METHOD_AS_STRING:
+		{
+			vtkObjectBase *pVtkObject = replay.Object(0);
+			std::vector<LPCSTR> methods = replay.Strings(1), formats = replay.Strings(2);
+			std::vector<vtkObjectBase *> references = replay.Handles(3);
+			std::vector<LPCSTR> argv = replay.Strings(4);
+			if (replay.valid && entry == PYVTK_ENTRY_PIPED_METHOD)
+			{
+				start = PyVtk_Now();
+				PyObject *pReturn = PyVtk_PipedObjectMethod(pIntrospector, pVtkObject, methods, formats, references, argv);
+				replayed = PyVtk_Now() - start;
+				succeeded = pReturn != NULL;
+				Py_XDECREF(pReturn);
+			}
+			else if (replay.valid)
+			{
+				start = PyVtk_Now();
+				succeeded = PyVtk_PipedObjectMethodAsString(pIntrospector, pVtkObject, methods, formats, references, argv) != NULL;
+				replayed = PyVtk_Now() - start;
+			}
+			break;
+		}
+		case PYVTK_ENTRY_FLUSH_PROPERTIES:
+			start = PyVtk_Now();
+			succeeded = PyVtk_FlushProperties(pIntrospector);
+			replayed = PyVtk_Now() - start;
+			break;
+		case PYVTK_ENTRY_SET_COALESCING:
+		{
+			bool enabled = replay.Number(0) != 0;
+			unsigned int tickMilliseconds = (unsigned int) replay.Number(1);
+			if (replay.valid)
+			{
+				start = PyVtk_Now();
+				PyVtk_SetCoalescing(pIntrospector, enabled, tickMilliseconds);
+				replayed = PyVtk_Now() - start;
+				succeeded = true;
+			}
+			break;
+		}
+		case PYVTK_ENTRY_PREPARE_CHAIN:
+		{
+			std::vector<LPCSTR> methods = replay.Strings(0), formats = replay.Strings(1);
+			if (replay.valid)
+			{
+				start = PyVtk_Now();
+				PyVtk_Chain *pChain = PyVtk_PrepareChain(pIntrospector, methods, formats);
+				replayed = PyVtk_Now() - start;
+				replay.SetResult(pChain);
+				replay.KeepChain(pChain);
+				succeeded = pChain != NULL;
+			}
+			break;
+		}
+		case PYVTK_ENTRY_EXECUTE_CHAIN:
+		{
+			PyVtk_Chain *pChain = (PyVtk_Chain *) replay.Handle(0);
+			vtkObjectBase *pVtkObject = replay.Object(1);
+			std::vector<vtkObjectBase *> references = replay.Handles(2);
+			std::vector<LPCSTR> argv = replay.Strings(3);
+			if (replay.valid && pChain != NULL)
+			{
+				start = PyVtk_Now();
+				PyObject *pReturn = PyVtk_ExecuteChain(pIntrospector, pChain, pVtkObject, references, argv);
+				replayed = PyVtk_Now() - start;
+				succeeded = pReturn != NULL;
+				Py_XDECREF(pReturn);
+			}
+			break;
+		}
+		case PYVTK_ENTRY_SWEEP:
+		{
+			vtkObjectBase *pVtkObject = replay.Object(0);
+			LPCSTR propertyName = replay.String(1), format = replay.String(2);
+			std::vector<LPCSTR> values = replay.Strings(3);
+			vtkObjectBase *pVtkSink = replay.Object(4);
+			size_t threads = (size_t) replay.Number(5);
+			if (replay.valid)
+			{
+				std::vector<vtkDataObject *> results;
+				start = PyVtk_Now();
+				succeeded = PyVtk_SweepVtkObjectProperty(pIntrospector, pVtkObject, propertyName, format, values, pVtkSink, threads, &results);
+				replayed = PyVtk_Now() - start;
+				for (vtkDataObject *pResult : results)
+				{
+					if (pResult != NULL)
+					{
+						pResult->Delete();
+					}
+				}
+			}
+			break;
+		}
+		case PYVTK_ENTRY_CONNECT_PORTS:
+		{
+			vtkObjectBase *pVtkObject = replay.Object(0);
+			int outputPort = (int) replay.Number(1);
+			vtkAlgorithm *pVtkTarget = vtkAlgorithm::SafeDownCast(replay.Object(2));
+			int inputPort = (int) replay.Number(3);
+			bool add = replay.Number(4) != 0;
+			if (replay.valid)
+			{
+				start = PyVtk_Now();
+				succeeded = PyVtk_ConnectVtkObjectPorts(pIntrospector, pVtkObject, outputPort, pVtkTarget, inputPort, add);
+				replayed = PyVtk_Now() - start;
+			}
+			break;
+		}
+		case PYVTK_ENTRY_UPDATE_PIPELINE:
+		{
+			std::vector<vtkObjectBase *> sinks = replay.Handles(0);
+			size_t threads = (size_t) replay.Number(1);
+			if (replay.valid)
+			{
+				start = PyVtk_Now();
+				succeeded = PyVtk_UpdatePipeline(pIntrospector, sinks, threads);
+				replayed = PyVtk_Now() - start;
+			}
+			break;
+		}
+		case PYVTK_ENTRY_CONFIGURE_SMP:
+		{
+			LPCSTR backend = replay.String(0);
+			size_t threads = (size_t) replay.Number(1);
+			if (replay.valid)
+			{
+				start = PyVtk_Now();
+				succeeded = PyVtk_ConfigureSmp(backend, threads);
+				replayed = PyVtk_Now() - start;
+			}
+			break;
+		}
+		case PYVTK_ENTRY_SET_THREAD_BUDGET:
+		{
+			vtkObjectBase *pVtkSink = replay.Object(0);
+			size_t threads = (size_t) replay.Number(1);
+			if (replay.valid)
+			{
+				start = PyVtk_Now();
+				PyVtk_SetThreadBudget(pIntrospector, pVtkSink, threads);
+				replayed = PyVtk_Now() - start;
+				succeeded = true;
+			}
+			break;
+		}
+		case PYVTK_ENTRY_SNAPSHOT_PROPERTIES:
+		{
+			std::vector<vtkObjectBase *> objects = replay.Handles(0);
+			std::vector<LPCSTR> properties = replay.Strings(1);
+			if (replay.valid)
+			{
+				start = PyVtk_Now();
+				PyVtk_Snapshot *pSnapshot = PyVtk_SnapshotProperties(pIntrospector, objects, properties);
+				replayed = PyVtk_Now() - start;
+				succeeded = pSnapshot != NULL;
+				PyVtk_ReleaseSnapshot(pSnapshot);
+			}
+			break;
+		}
+		case PYVTK_ENTRY_PROGRESSIVE_UPDATE:
+		{
+			vtkObjectBase *pVtkFilter = replay.Object(0);
+			size_t chunkSize = (size_t) replay.Number(1);
+			size_t threads = (size_t) replay.Number(2);
+			if (replay.valid)
+			{
+				vtkDataObject *pResult = NULL;
+				start = PyVtk_Now();
+				succeeded = PyVtk_ProgressiveUpdate(pIntrospector, pVtkFilter, chunkSize, threads, NULL, NULL, &pResult);
+				replayed = PyVtk_Now() - start;
+				if (pResult != NULL)
+				{
+					pResult->Delete();
+				}
+			}
+			break;
+		}
+		case PYVTK_ENTRY_SET_PREVIEW:
+		{
+			vtkObjectBase *pVtkSink = replay.Object(0);
+			bool enabled = replay.Number(1) != 0;
+			PyVtk_PreviewOptions options = { 0, 0, 0, 0 };
+			if (enabled)
+			{
+				options.stride = (size_t) replay.Number(2);
+				options.targetCells = (size_t) replay.Number(3);
+				options.seedRatio = (size_t) replay.Number(4);
+				options.settleMilliseconds = (unsigned int) replay.Number(5);
+			}
+			if (replay.valid)
+			{
+				start = PyVtk_Now();
+				succeeded = PyVtk_SetPreview(pIntrospector, pVtkSink, enabled ? &options : NULL);
+				replayed = PyVtk_Now() - start;
+			}
+			break;
+		}
+		case PYVTK_ENTRY_POLL_PREVIEWS:
+			start = PyVtk_Now();
+			PyVtk_PollPreviews(pIntrospector);
+			replayed = PyVtk_Now() - start;
+			succeeded = true;
+			break;
+		case PYVTK_ENTRY_FIND_CLASSES:
+		{
+			LPCSTR query = replay.String(0);
+			PyVtk_ClassQuery mode = (PyVtk_ClassQuery) replay.Number(1);
+			size_t limit = (size_t) replay.Number(2);
+			if (replay.valid)
+			{
+				LPCSTR *names;
+				start = PyVtk_Now();
+				succeeded = PyVtk_FindVtkClasses(pIntrospector, query, mode, limit, &names) >= 0;
+				replayed = PyVtk_Now() - start;
+			}
+			break;
+		}
+		case PYVTK_ENTRY_SET_PROPERTY_VALUE:
+		{
+			vtkObjectBase *pVtkObject = replay.Object(0);
+			LPCSTR propertyName = replay.String(1);
+			PyVtk_Result value = { (PyVtk_ResultKind) replay.Number(2), NULL, NULL, 0, (size_t) replay.Number(3), NULL, NULL, false, { NULL, 0, 0, 0 } };
+			std::vector<long long> integers;
+			std::vector<double> doubles;
+			if (value.kind == PYVTK_RESULT_OBJECT || value.kind == PYVTK_RESULT_ARRAY)
+			{
+				value.pObject = replay.Object(4);
+			}
+			else if (value.kind == PYVTK_RESULT_STRING)
+			{
+				value.str = replay.String(4);
+			}
+			else
+			{
+				/* Numbers were recorded as text, comma separated. */
+				LPCSTR numbers = replay.String(4);
+				char *end = (char *) numbers;
+				for (LPCSTR p = numbers; p != NULL && *p != '\0'; p = *end == ',' ? end + 1 : end)
+				{
+					if (value.kind == PYVTK_RESULT_INT)
+					{
+						integers.push_back(strtoll(p, &end, 10));
+					}
+					else
+					{
+						doubles.push_back(strtod(p, &end));
+					}
+					if (end == p)
+					{
+						replay.valid = false;
+						break;
+					}
+				}
+				value.pIntegers = integers.data();
+				value.pDoubles = doubles.data();
+				value.capacity = std::max(integers.size(), doubles.size());
+			}
+			if (replay.valid)
+			{
+				start = PyVtk_Now();
+				succeeded = PyVtk_SetVtkObjectPropertyValue(pIntrospector, pVtkObject, propertyName, &value) == PYVTK_OK;
+				replayed = PyVtk_Now() - start;
+			}
+			break;
+		}
+		case PYVTK_ENTRY_OBJECT_METHOD_INTO:
+		case PYVTK_ENTRY_PIPED_METHOD_INTO:
+		{
+			bool piped = entry == PYVTK_ENTRY_PIPED_METHOD_INTO;
+			vtkObjectBase *pVtkObject = replay.Object(0);
+			std::vector<LPCSTR> methods = piped ? replay.Strings(1) : std::vector<LPCSTR>({ replay.String(1) });
+			std::vector<LPCSTR> formats = piped ? replay.Strings(2) : std::vector<LPCSTR>({ replay.String(2) });
+			std::vector<vtkObjectBase *> references = replay.Handles(3);
+			std::vector<LPCSTR> argv = replay.Strings(4);
+			PyVtk_ResultKind kind = (PyVtk_ResultKind) replay.Number(5);
+			size_t capacity = (size_t) replay.Number(6);
+			if (replay.valid)
+			{
+				std::vector<long long> integers(capacity);
+				std::vector<double> doubles(capacity);
+				PyVtk_Result result = { kind, integers.data(), doubles.data(), capacity, 0, NULL, NULL, false, { NULL, 0, 0, 0 } };
+				start = PyVtk_Now();
+				succeeded = piped
+					? PyVtk_PipedObjectMethodInto(pIntrospector, pVtkObject, methods, formats, references, argv, &result)
+					: PyVtk_ObjectMethodInto(pIntrospector, pVtkObject, methods[0], formats[0], references, argv, &result);
+				replayed = PyVtk_Now() - start;
+
+				/* An object the replay would own is released rather than mapped. */
+				if (result.owned)
+				{
+					result.pObject->Delete();
+				}
+				else
+				{
+					replay.SetResult(result.pObject);
+				}
+			}
+			break;
+		}
+		case PYVTK_ENTRY_SAVE_SESSION:
+		{
+			LPCSTR sessionPath = replay.String(0);
+			bool includeOutputs = replay.Number(1) != 0;
+			if (replay.valid)
+			{
+				std::vector<vtkObjectBase *> objects;
+				start = PyVtk_Now();
+				succeeded = PyVtk_SaveSession(pIntrospector, sessionPath, includeOutputs, &objects);
+				replayed = PyVtk_Now() - start;
+			}
+			break;
+		}
+		case PYVTK_ENTRY_RESTORE_SESSION:
+		{
+			LPCSTR sessionPath = replay.String(0);
+			if (replay.valid)
+			{
+				std::vector<vtkObjectBase *> objects;
+				start = PyVtk_Now();
+				succeeded = PyVtk_RestoreSession(pIntrospector, sessionPath, &objects);
+				replayed = PyVtk_Now() - start;
+				replay.SetResults(1, objects);
+			}
+			break;
+		}
+		case PYVTK_ENTRY_EXPORT_COLUMNS:
+		{
+			vtkObjectBase *pVtkObject = replay.Object(0);
+			LPCSTR exportPath = replay.String(1);
+			if (replay.valid)
+			{
+				start = PyVtk_Now();
+				succeeded = PyVtk_ExportColumns(pIntrospector, pVtkObject, exportPath);
+				replayed = PyVtk_Now() - start;
+			}
+			break;
+		}
+		case PYVTK_ENTRY_SET_POOL_SIZE:
+		{
+			LPCSTR className = replay.String(0);
+			size_t size = (size_t) replay.Number(1);
+			if (replay.valid)
+			{
+				start = PyVtk_Now();
+				succeeded = PyVtk_SetPoolSize(pIntrospector, className, size);
+				replayed = PyVtk_Now() - start;
+			}
+			break;
+		}
+		case PYVTK_ENTRY_CLOSE_SESSION:
+			start = PyVtk_Now();
+			PyVtk_CloseSession(pIntrospector);
+			replayed = PyVtk_Now() - start;
+			succeeded = true;
+			break;
+		default:
+			/* Initialization and teardown belong to the replaying host. */
+			continue;
+		}
+
+		if (callback != NULL)
+		{
+			callback(pContext, index, entryNames[entry], duration, replayed, succeeded);
+		}
+		PyVtk_ResetScratch();
+	}
+
+	fclose(pFile);
+	return complete;
+}
+
+
+/*
+ * Session snapshots. A session file holds, after its magic and version:
+ * - the registered nodes, each as its class name and the calls that take a new
+ *   object of that class to its state, as (method, format, value) strings
+ * - the connections between them, as the consumer, its input port, the producer
+ *   and its output port, all as node indices
+ * - optionally, the outputs the nodes had computed, in VTK's binary legacy format
+ * Numbers are written as varints and strings as in recordings.
+ */
+static const char sessionMagic[8] = { 'P', 'Y', 'V', 'T', 'K', 'S', 'E', 'S' };
+static const unsigned int sessionVersion = 1;
+
+
+/*
+ * Saves the nodes registered by the Introspector to path. The order of the nodes
+ * in the file is returned in pObjects, which is also the order
+ * PyVtk_RestoreSession returns the restored objects in.
+ */
+bool PyVtk_SaveSession(
+	PyObject *pIntrospector,
+	LPCSTR path,
+	bool includeOutputs,
+	std::vector<vtkObjectBase *> *pObjects)
+{
+	std::vector<vtkObjectBase *> objects;
+	PyVtk_CallScope scope(PYVTK_ENTRY_SAVE_SESSION);
+	PyVtk_CallRecord record(PYVTK_ENTRY_SAVE_SESSION);
+	record.String(path).Number(includeOutputs ? 1 : 0).Handles(objects);
+
+	/* The state saved includes every write issued so far. */
+	PyVtk_FlushProperties(pIntrospector);
+
+	/* Only the nodes of this session; the others belong to other Introspectors. */
+	std::unordered_map<vtkObjectBase *, size_t> indices;
+	for (auto &node : nodes)
+	{
+		if (PyVtk_InSession(pIntrospector, node.first))
+		{
+			indices[node.first] = objects.size();
+			objects.push_back(node.first);
+		}
+	}
+
+	PyObject *pNodes = PyList_New(objects.size());
+	if (pNodes == NULL)
+	{
+		PyVtk_Error(PYVTK_E_PYTHON, NULL, "getVtkObjectStates", "Unable to create a list of size %zu", objects.size());
+		return false;
+	}
+	for (size_t i = 0; i < objects.size(); ++i)
+	{
+		PyObject *pNode = nodes[objects[i]];
+		Py_INCREF(pNode);
+		PyList_SET_ITEM(pNodes, i, pNode);
+	}
+
+	/* One call for the state of all of the nodes. */
+	PyObject *pStates = PyVtk_CallPython(pIntrospector, "getVtkObjectStates", "(O)", pNodes);
+	Py_DECREF(pNodes);
+	if (pStates == NULL || !PyList_Check(pStates) || (size_t) PyList_GET_SIZE(pStates) != objects.size())
+	{
+		Py_XDECREF(pStates);
+		PyVtk_Error(PYVTK_E_PYTHON, NULL, "getVtkObjectStates", "Cannot get the state of the VTK objects");
+		return false;
+	}
+
+	FILE *pFile = fopen(path, "wb");
+	if (pFile == NULL)
+	{
+		Py_DECREF(pStates);
+		PyVtk_PushError(PYVTK_E_ARGUMENT, NULL, "PyVtk_SaveSession", path);
+		return false;
+	}
+
+	fwrite(sessionMagic, 1, sizeof(sessionMagic), pFile);
+	PyVtk_PutVarint(pFile, sessionVersion);
+
+	/* Nodes, as ("className", [("method", "format", "value"), ...]). */
+	bool ok = true;
+	PyVtk_PutVarint(pFile, objects.size());
+	for (size_t i = 0; ok && i < objects.size(); ++i)
+	{
+		PyObject *pState = PyList_GET_ITEM(pStates, i);
+		PyObject *pCalls = PyTuple_Check(pState) && PyTuple_GET_SIZE(pState) == 2 ? PyTuple_GET_ITEM(pState, 1) : NULL;
+		LPCSTR className = pCalls != NULL ? PyString_AsString(PyTuple_GET_ITEM(pState, 0)) : NULL;
+		if (className == NULL || !PyList_Check(pCalls))
+		{
+			ok = false;
+			break;
+		}
+
+		PyVtk_PutString(pFile, className);
+		PyVtk_PutVarint(pFile, PyList_GET_SIZE(pCalls));
+		for (Py_ssize_t j = 0; ok && j < PyList_GET_SIZE(pCalls); ++j)
+		{
+			PyObject *pCall = PyList_GET_ITEM(pCalls, j);
+			for (Py_ssize_t k = 0; ok && k < 3; ++k)
+			{
+				LPCSTR str = PyTuple_Check(pCall) && PyTuple_GET_SIZE(pCall) == 3 ? PyString_AsString(PyTuple_GET_ITEM(pCall, k)) : NULL;
+				ok = str != NULL;
+				PyVtk_PutString(pFile, str);
+			}
+		}
+	}
+	Py_DECREF(pStates);
+	if (!ok)
+	{
+		fclose(pFile);
+		PyVtk_Error(PYVTK_E_FORMAT, NULL, "getVtkObjectStates", "Malformed state of a VTK object");
+		return false;
+	}
+
+	/* Connections between registered nodes. Inputs coming from elsewhere are not saved. */
+	std::vector<unsigned long long> connections;
+	for (size_t i = 0; i < objects.size(); ++i)
+	{
+		vtkAlgorithm *pAlgorithm = vtkAlgorithm::SafeDownCast(objects[i]);
+		for (int port = 0; pAlgorithm != NULL && port < pAlgorithm->GetNumberOfInputPorts(); ++port)
+		{
+			for (int j = 0; j < pAlgorithm->GetNumberOfInputConnections(port); ++j)
+			{
+				vtkAlgorithmOutput *pConnection = pAlgorithm->GetInputConnection(port, j);
+				auto iProducer = pConnection != NULL ? indices.find(pConnection->GetProducer()) : indices.end();
+				if (iProducer != indices.end())
+				{
+					connections.insert(connections.end(), { i, (unsigned long long) port, iProducer->second, (unsigned long long) pConnection->GetIndex() });
+				}
+			}
+		}
+	}
+	PyVtk_PutVarint(pFile, connections.size() / 4);
+	for (unsigned long long value : connections)
+	{
+		PyVtk_PutVarint(pFile, value);
+	}
+
+	/* Outputs that are current, that is, computed since their algorithm last changed. */
+	std::vector<std::pair<size_t, int>> outputs;
+	for (size_t i = 0; includeOutputs && i < objects.size(); ++i)
+	{
+		vtkAlgorithm *pAlgorithm = vtkAlgorithm::SafeDownCast(objects[i]);
+		for (int port = 0; pAlgorithm != NULL && port < pAlgorithm->GetNumberOfOutputPorts(); ++port)
+		{
+			vtkDataObject *pOutput = pAlgorithm->GetOutputDataObject(port);
+			if (pOutput != NULL && pOutput->GetUpdateTime() > pAlgorithm->GetMTime())
+			{
+				outputs.push_back(std::make_pair(i, port));
+			}
+		}
+	}
+	PyVtk_PutVarint(pFile, outputs.size());
+	for (auto &output : outputs)
+	{
+		vtkAlgorithm *pAlgorithm = vtkAlgorithm::SafeDownCast(objects[output.first]);
+		vtkSmartPointer<vtkGenericDataObjectWriter> pWriter = vtkSmartPointer<vtkGenericDataObjectWriter>::New();
+		pWriter->SetInputData(pAlgorithm->GetOutputDataObject(output.second));
+		pWriter->SetWriteToOutputString(1);
+		pWriter->SetFileTypeToBinary();
+		{
+			PyVtk_VtkScope vtk(pWriter);
+			pWriter->Write();
+		}
+
+		size_t length = pWriter->GetOutputString() != NULL ? pWriter->GetOutputStringLength() : 0;
+		PyVtk_PutVarint(pFile, output.first);
+		PyVtk_PutVarint(pFile, output.second);
+		PyVtk_PutVarint(pFile, length);
+		fwrite(pWriter->GetOutputString(), 1, length, pFile);
+	}
+
+	ok = !ferror(pFile);
+	if (fclose(pFile) != 0 || !ok)
+	{
+		PyVtk_PushError(PYVTK_E_ARGUMENT, NULL, "PyVtk_SaveSession", path);
+		return false;
+	}
+
+	if (pObjects != NULL)
+	{
+		*pObjects = objects;
+	}
+	return true;
+}
+
+
+/*
+ * Restores a session saved by PyVtk_SaveSession next to the nodes already
+ * registered. The nodes are created and set up in a single Python call. Saved
+ * outputs are put in place of the outputs of their algorithms, so those only
+ * execute again once something upstream of them changes; a stage whose next
+ * request differs from what was saved, such as another piece, executes as usual.
+ * Every node that could be created is registered and returned, even if some of
+ * its calls failed; each failure is reported with the index of its node, and
+ * makes the restore return false.
+ */
+bool PyVtk_RestoreSession(
+	PyObject *pIntrospector,
+	LPCSTR path,
+	std::vector<vtkObjectBase *> *pObjects)
+{
+	std::vector<vtkObjectBase *> objects;
+	PyVtk_CallScope scope(PYVTK_ENTRY_RESTORE_SESSION);
+	PyVtk_CallRecord record(PYVTK_ENTRY_RESTORE_SESSION);
+	record.String(path).Handles(objects);
+
+	FILE *pFile = fopen(path, "rb");
+	if (pFile == NULL)
+	{
+		PyVtk_PushError(PYVTK_E_ARGUMENT, NULL, "PyVtk_RestoreSession", path);
+		return false;
+	}
+
+	char magic[sizeof(sessionMagic)];
+	unsigned long long version = 0, count = 0;
+	bool ok = fread(magic, 1, sizeof(magic), pFile) == sizeof(magic) && memcmp(magic, sessionMagic, sizeof(magic)) == 0
+		&& PyVtk_GetVarint(pFile, &version) && version == sessionVersion && PyVtk_GetVarint(pFile, &count);
+
+	/* Nodes, read straight into the argument of the batched call. */
+	PyObject *pStates = ok ? PyList_New((Py_ssize_t) count) : NULL;
+	std::vector<std::string> classNames;
+	for (size_t i = 0; pStates != NULL && ok && i < count; ++i)
+	{
+		bool null;
+		std::string className;
+		unsigned long long callCount;
+		ok = PyVtk_GetString(pFile, &className, &null) && PyVtk_GetVarint(pFile, &callCount);
+
+		PyObject *pCalls = PyList_New(ok ? (Py_ssize_t) callCount : 0);
+		for (size_t j = 0; pCalls != NULL && ok && j < callCount; ++j)
+		{
+			std::string call[3];
+			ok = PyVtk_GetString(pFile, &call[0], &null) && PyVtk_GetString(pFile, &call[1], &null) && PyVtk_GetString(pFile, &call[2], &null);
+			PyObject *pCall = Py_BuildValue("(sss)", call[0].c_str(), call[1].c_str(), call[2].c_str());
+			if (pCall == NULL)
+			{
+				pCall = Py_None;
+				Py_INCREF(pCall);
+				ok = false;
+			}
+			PyList_SET_ITEM(pCalls, j, pCall);
+		}
+
+		PyObject *pState = pCalls != NULL ? Py_BuildValue("(sN)", className.c_str(), pCalls) : NULL;
+		if (pState == NULL)
+		{
+			pState = Py_None;
+			Py_INCREF(pState);
+			ok = false;
+		}
+		PyList_SET_ITEM(pStates, i, pState);
+		classNames.push_back(className);
+	}
+
+	if (pStates == NULL || !ok)
+	{
+		Py_XDECREF(pStates);
+		fclose(pFile);
+		PyVtk_Error(PYVTK_E_FORMAT, NULL, "PyVtk_RestoreSession", "Cannot read the session \"%s\"", path);
+		return false;
+	}
+
+	/* One call creating and setting up all of the nodes, returning them next to
+	   the (index, method, message) of the calls that failed. */
+	PyObject *pRestored = PyVtk_CallPython(pIntrospector, "restoreVtkObjects", "(O)", pStates);
+	Py_DECREF(pStates);
+	PyObject *pNodes = pRestored != NULL && PyTuple_Check(pRestored) && PyTuple_GET_SIZE(pRestored) == 2 ? PyTuple_GET_ITEM(pRestored, 0) : NULL;
+	PyObject *pErrors = pNodes != NULL ? PyTuple_GET_ITEM(pRestored, 1) : NULL;
+	if (pNodes == NULL || !PyList_Check(pNodes) || (size_t) PyList_GET_SIZE(pNodes) != count || !PyList_Check(pErrors))
+	{
+		Py_XDECREF(pRestored);
+		fclose(pFile);
+		PyVtk_Error(PYVTK_E_PYTHON, NULL, "restoreVtkObjects", "Cannot restore the VTK objects");
+		return false;
+	}
+
+	bool restored = true;
+	for (size_t i = 0; i < count; ++i)
+	{
+		PyObject *pNode = PyList_GET_ITEM(pNodes, i);
+		PyObject *pPyVtkInstance = pNode != Py_None ? PyObject_GetAttrString(pNode, "vtkInstance") : NULL;
+		vtkObjectBase *pVtkObject = pPyVtkInstance != NULL ? vtkPythonUtil::GetPointerFromObject(pPyVtkInstance, classNames[i].c_str()) : NULL;
+		Py_XDECREF(pPyVtkInstance);
+		if (pVtkObject == NULL)
+		{
+			/* A node Python could not create is among the errors below. */
+			if (pNode != Py_None)
+			{
+				PyVtk_Error(PYVTK_E_PYTHON, NULL, "vtkInstance", "Cannot get the VTK object of node %zu", i);
+			}
+			objects.push_back(NULL);
+			restored = false;
+			continue;
+		}
+
+		Py_INCREF(pNode);
+		PyVtk_RegisterNode(pIntrospector, pVtkObject, pNode);
+		PyVtk_ObserveExecution(pVtkObject);
+		objects.push_back(pVtkObject);
+	}
+
+	/* Failed calls, reported once their node is known. */
+	for (Py_ssize_t i = 0; i < PyList_GET_SIZE(pErrors); ++i)
+	{
+		Py_ssize_t index;
+		LPCSTR method, message;
+		if (!PyArg_ParseTuple(PyList_GET_ITEM(pErrors, i), "nss", &index, &method, &message))
+		{
+			PyVtk_Error(PYVTK_E_FORMAT, NULL, "restoreVtkObjects", "Malformed restore error");
+		}
+		else
+		{
+			PyVtk_Error(PYVTK_E_PYTHON, index >= 0 && (size_t) index < count ? objects[index] : NULL, method,
+				"Cannot restore node %zd: %s", index, message);
+		}
+		restored = false;
+	}
+	Py_DECREF(pRestored);
+
+	/* Connections, in their saved order, so multiple inputs of a port keep theirs. */
+	ok = PyVtk_GetVarint(pFile, &count);
+	for (size_t i = 0; ok && i < count; ++i)
+	{
+		unsigned long long connection[4];
+		for (int j = 0; ok && j < 4; ++j)
+		{
+			ok = PyVtk_GetVarint(pFile, &connection[j]);
+		}
+		vtkAlgorithm *pConsumer = ok && connection[0] < objects.size() ? vtkAlgorithm::SafeDownCast(objects[connection[0]]) : NULL;
+		vtkAlgorithm *pProducer = ok && connection[2] < objects.size() ? vtkAlgorithm::SafeDownCast(objects[connection[2]]) : NULL;
+		if (pConsumer == NULL || pProducer == NULL)
+		{
+			continue;
+		}
+
+		int port = (int) connection[1];
+		vtkAlgorithmOutput *pPort = pProducer->GetOutputPort((int) connection[3]);
+		if (pConsumer->GetNumberOfInputConnections(port) == 0)
+		{
+			pConsumer->SetInputConnection(port, pPort);
+		}
+		else
+		{
+			pConsumer->AddInputConnection(port, pPort);
+		}
+	}
+
+	/* Outputs last, as every change to the pipeline above makes them out of date. */
+	ok = ok && PyVtk_GetVarint(pFile, &count);
+	std::vector<char> buffer;
+	for (size_t i = 0; ok && i < count; ++i)
+	{
+		unsigned long long index, port, length;
+		ok = PyVtk_GetVarint(pFile, &index) && PyVtk_GetVarint(pFile, &port) && PyVtk_GetVarint(pFile, &length);
+		buffer.resize(ok ? (size_t) length : 0);
+		ok = ok && (buffer.empty() || fread(&buffer[0], 1, buffer.size(), pFile) == buffer.size());
+
+		vtkAlgorithm *pAlgorithm = ok && index < objects.size() ? vtkAlgorithm::SafeDownCast(objects[index]) : NULL;
+		if (pAlgorithm == NULL || buffer.empty())
+		{
+			continue;
+		}
+
+		PyVtk_VtkScope vtk(pAlgorithm);
+		vtkSmartPointer<vtkGenericDataObjectReader> pReader = vtkSmartPointer<vtkGenericDataObjectReader>::New();
+		pReader->ReadFromInputStringOn();
+		pReader->SetInputString(&buffer[0], (int) buffer.size());
+		pReader->Update();
+
+		pAlgorithm->UpdateDataObject();
+		vtkDataObject *pSaved = pReader->GetOutput();
+		vtkDataObject *pOutput = pAlgorithm->GetOutputDataObject((int) port);
+		if (pSaved == NULL || pOutput == NULL || pSaved->GetDataObjectType() != pOutput->GetDataObjectType())
+		{
+			continue;
+		}
+
+		/* Marked as the whole of the data, as an executive would after executing. */
+		pOutput->ShallowCopy(pSaved);
+		pOutput->GetInformation()->Set(vtkDataObject::DATA_PIECE_NUMBER(), 0);
+		pOutput->GetInformation()->Set(vtkDataObject::DATA_NUMBER_OF_PIECES(), 1);
+		pOutput->GetInformation()->Set(vtkDataObject::DATA_NUMBER_OF_GHOST_LEVELS(), 0);
+		pOutput->DataHasBeenGenerated();
+	}
+	fclose(pFile);
+
+	if (!ok)
+	{
+		PyVtk_Error(PYVTK_E_FORMAT, NULL, "PyVtk_RestoreSession", "Truncated session \"%s\"", path);
+	}
+	if (pObjects != NULL)
+	{
+		*pObjects = objects;
+	}
+	return ok && restored;
+}
+
+/*
+ * Columnar export. The columns are written from the memory of the VTK arrays in
+ * chunks, with the GIL released; only arrays not laid out as contiguous tuples
+ * go through a buffer, converted to doubles. Cells are written as VTK keeps them:
+ * offsets and connectivity from VTK 9 on, the count-prefixed legacy layout before.
+ */
+#if VTK_MAJOR_VERSION >= 9
+#define PYVTK_CELL_OFFSETS
+#endif
+
+static const char columnMagic[8] = { 'P', 'Y', 'V', 'T', 'K', 'C', 'O', 'L' };
+static const unsigned int columnVersion = 1;
+static const size_t columnChunk = 4 << 20;
+
+static unsigned long long PyVtk_AlignColumn(
+	unsigned long long offset)
+{
+	return (offset + PYVTK_COLUMN_ALIGNMENT - 1) / PYVTK_COLUMN_ALIGNMENT * PYVTK_COLUMN_ALIGNMENT;
+}
+
+
+static void PyVtk_AddColumn(
+	std::vector<PyVtk_ColumnBlock> &blocks,
+	std::vector<vtkDataArray *> &arrays,
+	LPCSTR name,
+	unsigned int kind,
+	vtkDataArray *pArray)
+{
+	if (pArray == NULL)
+	{
+		return;
+	}
+
+	PyVtk_ColumnBlock block;
+	memset(&block, 0, sizeof(block));
+	strncpy(block.name, name != NULL ? name : "", sizeof(block.name) - 1);
+	block.kind = kind;
+
+	bool contiguous = pArray->HasStandardMemoryLayout();
+	block.valueType = contiguous ? pArray->GetDataType() : VTK_DOUBLE;
+	block.valueSize = contiguous ? pArray->GetDataTypeSize() : sizeof(double);
+	block.components = pArray->GetNumberOfComponents();
+	block.tuples = pArray->GetNumberOfTuples();
+	block.bytes = block.tuples * block.components * block.valueSize;
+
+	blocks.push_back(block);
+	arrays.push_back(pArray);
+}
+
+
+static bool PyVtk_WriteColumn(
+	FILE *pFile,
+	const PyVtk_ColumnBlock &block,
+	vtkDataArray *pArray,
+	std::vector<double> &buffer)
+{
+	if (block.bytes == 0)
+	{
+		return true;
+	}
+
+	if (pArray->HasStandardMemoryLayout())
+	{
+		const char *pValues = (const char *) pArray->GetVoidPointer(0);
+		for (unsigned long long written = 0; written < block.bytes; written += columnChunk)
+		{
+			size_t size = (size_t) std::min<unsigned long long>(columnChunk, block.bytes - written);
+			if (fwrite(pValues + written, 1, size, pFile) != size)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/* Other layouts are interleaved a chunk of tuples at a time. */
+	size_t components = block.components;
+	size_t chunkTuples = std::max<size_t>(1, columnChunk / (components * sizeof(double)));
+	buffer.resize(chunkTuples * components);
+	for (unsigned long long first = 0; first < block.tuples; first += chunkTuples)
+	{
+		size_t count = (size_t) std::min<unsigned long long>(chunkTuples, block.tuples - first);
+		for (size_t i = 0; i < count; ++i)
+		{
+			pArray->GetTuple((vtkIdType) (first + i), &buffer[i * components]);
+		}
+		if (fwrite(buffer.data(), sizeof(double) * components, count, pFile) != count)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/*
+ * Writes the output of an algorithm, brought up to date first, or a data object
+ * to path. Polygonal data and structured grids are supported.
+ */
+bool PyVtk_ExportColumns(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	LPCSTR path)
+{
+	PyVtk_CallScope scope(PYVTK_ENTRY_EXPORT_COLUMNS, pVtkObject);
+	PyVtk_CallRecord record(PYVTK_ENTRY_EXPORT_COLUMNS);
+	record.Handle(pVtkObject).String(path);
+
+	/* The output exported reflects every write issued so far. */
+	PyVtk_FlushProperties(pIntrospector);
+
+	vtkDataObject *pData = vtkDataObject::SafeDownCast(pVtkObject);
+	vtkAlgorithm *pAlgorithm = vtkAlgorithm::SafeDownCast(pVtkObject);
+	if (pAlgorithm != NULL && pAlgorithm->GetNumberOfOutputPorts() > 0)
+	{
+		{
+			PyVtk_VtkScope vtk(pAlgorithm, true);
+			pAlgorithm->Update();
+		}
+		pData = pAlgorithm->GetOutputDataObject(0);
+	}
+
+	vtkPolyData *pPolyData = vtkPolyData::SafeDownCast(pData);
+	vtkStructuredGrid *pGrid = vtkStructuredGrid::SafeDownCast(pData);
+	if (pPolyData == NULL && pGrid == NULL)
+	{
+		PyVtk_Error(PYVTK_E_ARGUMENT, pVtkObject, "ExportColumns", "Only polygonal data and structured grids can be exported");
+		return false;
+	}
+
+	vtkDataSet *pDataSet = (vtkDataSet *) pData;
+	PyVtk_ColumnHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, columnMagic, sizeof(columnMagic));
+	header.version = columnVersion;
+	header.dataType = pPolyData != NULL ? VTK_POLY_DATA : VTK_STRUCTURED_GRID;
+	header.points = pDataSet->GetNumberOfPoints();
+	header.cells = pDataSet->GetNumberOfCells();
+
+	/* Listing the columns. */
+	std::vector<PyVtk_ColumnBlock> blocks;
+	std::vector<vtkDataArray *> arrays;
+	vtkPoints *pPoints = pPolyData != NULL ? pPolyData->GetPoints() : pGrid->GetPoints();
+	if (pPoints != NULL)
+	{
+		PyVtk_AddColumn(blocks, arrays, "points", PYVTK_COLUMN_POINTS, pPoints->GetData());
+	}
+
+	if (pPolyData != NULL)
+	{
+		const std::pair<LPCSTR, vtkCellArray *> cellArrays[] = {
+			std::make_pair("verts", pPolyData->GetVerts()),
+			std::make_pair("lines", pPolyData->GetLines()),
+			std::make_pair("polys", pPolyData->GetPolys()),
+			std::make_pair("strips", pPolyData->GetStrips())
+		};
+		for (auto &cellArray : cellArrays)
+		{
+			if (cellArray.second == NULL || cellArray.second->GetNumberOfCells() == 0)
+			{
+				continue;
+			}
+#ifdef PYVTK_CELL_OFFSETS
+			PyVtk_AddColumn(blocks, arrays, cellArray.first, PYVTK_COLUMN_OFFSETS, cellArray.second->GetOffsetsArray());
+			PyVtk_AddColumn(blocks, arrays, cellArray.first, PYVTK_COLUMN_CONNECTIVITY, cellArray.second->GetConnectivityArray());
+#else
+			PyVtk_AddColumn(blocks, arrays, cellArray.first, PYVTK_COLUMN_LEGACY_CELLS, cellArray.second->GetData());
+#endif
+		}
+	}
+	else
+	{
+		pGrid->GetDimensions(header.dimensions);
+	}
+
+	/* Arrays that are not numeric, such as string arrays, are left out. */
+	const std::pair<unsigned int, vtkDataSetAttributes *> attributes[] = {
+		std::make_pair((unsigned int) PYVTK_COLUMN_POINT_DATA, (vtkDataSetAttributes *) pDataSet->GetPointData()),
+		std::make_pair((unsigned int) PYVTK_COLUMN_CELL_DATA, (vtkDataSetAttributes *) pDataSet->GetCellData())
+	};
+	for (auto &attribute : attributes)
+	{
+		for (int i = 0; i < attribute.second->GetNumberOfArrays(); ++i)
+		{
+			vtkDataArray *pArray = attribute.second->GetArray(i);
+			PyVtk_AddColumn(blocks, arrays, pArray != NULL ? pArray->GetName() : NULL, attribute.first, pArray);
+		}
+	}
+
+	/* Laying the blocks out after the header and the table. */
+	header.blockCount = (unsigned int) blocks.size();
+	unsigned long long offset = sizeof(header) + blocks.size() * sizeof(PyVtk_ColumnBlock);
+	for (PyVtk_ColumnBlock &block : blocks)
+	{
+		block.offset = PyVtk_AlignColumn(offset);
+		offset = block.offset + block.bytes;
+	}
+
+	FILE *pFile = fopen(path, "wb");
+	if (pFile == NULL)
+	{
+		PyVtk_PushError(PYVTK_E_ARGUMENT, pVtkObject, "PyVtk_ExportColumns", path);
+		return false;
+	}
+
+	PyThreadState *pThreadState = PyVtk_ReleaseGil();
+	bool ok = fwrite(&header, sizeof(header), 1, pFile) == 1
+		&& (blocks.empty() || fwrite(blocks.data(), sizeof(PyVtk_ColumnBlock), blocks.size(), pFile) == blocks.size());
+
+	static const char padding[PYVTK_COLUMN_ALIGNMENT] = { 0 };
+	std::vector<double> buffer;
+	offset = sizeof(header) + blocks.size() * sizeof(PyVtk_ColumnBlock);
+	for (size_t i = 0; ok && i < blocks.size(); ++i)
+	{
+		size_t pad = (size_t) (blocks[i].offset - offset);
+		ok = fwrite(padding, 1, pad, pFile) == pad && PyVtk_WriteColumn(pFile, blocks[i], arrays[i], buffer);
+		offset = blocks[i].offset + blocks[i].bytes;
+	}
+	ok = fclose(pFile) == 0 && ok;
+	PyVtk_RestoreGil(pThreadState);
+
+	if (!ok)
+	{
+		PyVtk_Error(PYVTK_E_ARGUMENT, pVtkObject, "ExportColumns", "Cannot write \"%s\"", path);
+	}
+	return ok;
+}
+
+
+/*
+ * Splits a string on a separator. Both the tokens and the array pointing to them
+ * live in the scratch arena; the number of tokens is returned. As with getline,
+ * a trailing separator does not produce an empty last token.
+ */
+size_t split(
+	LPCSTR str,
+	char split,
+	LPCSTR **pTokens)
+{
+	size_t len = strlen(str);
+	char *copy = scratch.CopyString(str, len);
+
+	size_t count = len == 0 ? 0 : 1;
+	for (size_t i = 0; i < len; ++i)
+	{
+		if (copy[i] == split && i + 1 < len)
+		{
+			++count;
+		}
+	}
+
+	LPCSTR *tokens = (LPCSTR *) scratch.Allocate(count * sizeof(LPCSTR));
+	size_t token = 0;
+	if (count > 0)
+	{
+		tokens[token++] = copy;
+	}
+	for (size_t i = 0; i < len; ++i)
+	{
+		if (copy[i] == split)
+		{
+			copy[i] = '\0';
+			if (i + 1 < len)
+			{
+				tokens[token++] = copy + i + 1;
+			}
+		}
+	}
+
+	*pTokens = tokens;
+	return count;
+}
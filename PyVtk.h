@@ -0,0 +1,672 @@
+#ifndef PYVTK_H
+#define PYVTK_H
+
+#include <Python.h>
+
+#include <vtkObjectBase.h>
+#include <vtkAlgorithm.h>
+#include <vtkAlgorithmOutput.h>
+#include <vtkDataObject.h>
+
+#include <vector>
+#include <cstddef>
+
+#define NOMINMAX
+#include <windows.h>
+
+
+/*
+ * Usage of the per-thread scratch arena the results are returned from.
+ */
+struct PyVtk_ScratchStats
+{
+	size_t bytesUsed;
+	size_t bytesReserved;
+	size_t chunkAllocations;
+};
+
+/*
+ * Time spent in the phases of PyVtk_InitIntrospector, in nanoseconds: starting
+ * the interpreter, setting the module paths, importing the Introspector with
+ * the modules and VTK it imports, and instantiating it. frozenModules tells
+ * whether the embedding modules were imported from frozen bytecode.
+ */
+struct PyVtk_InitStats
+{
+	unsigned long long initialize;
+	unsigned long long paths;
+	unsigned long long imports;
+	unsigned long long instantiate;
+	bool frozenModules;
+};
+
+/*
+ * Failure codes of the embedding layer.
+ */
+enum PyVtk_ErrorCode
+{
+	PYVTK_OK = 0,
+	PYVTK_E_PYTHON,
+	PYVTK_E_NOT_REGISTERED,
+	PYVTK_E_ARGUMENT,
+	PYVTK_E_FORMAT,
+	PYVTK_E_VTK_ERROR,
+	PYVTK_E_VTK_WARNING
+};
+
+struct PyVtk_ErrorRecord
+{
+	int code;
+	vtkObjectBase *pObject;
+	char method[64];
+	char message[256];
+	long long timestamp;
+};
+
+/*
+ * Latency of one part of the calls to an entry point, in nanoseconds.
+ */
+struct PyVtk_Latency
+{
+	unsigned long long sum;
+	unsigned long long p50;
+	unsigned long long p90;
+	unsigned long long p99;
+	unsigned long long max;
+};
+
+/*
+ * Instrumentation of one entry point. The total time of its calls is split into
+ * marshalling, the Python layer and VTK execution, with the GIL wait apart.
+ * vtkCpu is the CPU time the process used while VTK executed, so vtkCpu over
+ * vtk.sum is the average number of cores busy, which counts concurrent calls too.
+ */
+struct PyVtk_EntryStats
+{
+	LPCSTR name;
+	unsigned long long calls;
+	unsigned long long gilWait;
+	unsigned long long pythonAllocations;
+	unsigned long long vtkCpu;
+	PyVtk_Latency total;
+	PyVtk_Latency marshal;
+	PyVtk_Latency python;
+	PyVtk_Latency vtk;
+};
+
+/*
+ * Options of PyVtk_InitIntrospectorWithOptions. With lazyImports, only the VTK
+ * modules of the classes created are imported, found through the class map
+ * written by vtkLoader.py; classModules is its path, "classModules.json" if NULL.
+ */
+struct PyVtk_InitOptions
+{
+	bool lazyImports;
+	LPCSTR classModules;
+};
+
+/*
+ * Queries of PyVtk_FindVtkClasses: classes whose name starts with or contains
+ * the query, ignoring case, or classes having a property of that name.
+ */
+enum PyVtk_ClassQuery
+{
+	PYVTK_CLASS_PREFIX,
+	PYVTK_CLASS_SUBSTRING,
+	PYVTK_CLASS_PROPERTY
+};
+
+/*
+ * Options of PyVtk_SetPreview. Structured sources are subsampled every stride
+ * points along each axis or, if stride is 0, at the stride bringing them down to
+ * about targetCells cells. Seeds keep one point out of seedRatio, by default as
+ * much as the field is reduced. Once the pipeline was left unmodified for
+ * settleMilliseconds, the full result is computed by PyVtk_PollPreviews or by
+ * a PyVtk_UpdatePipeline of the sink, on the caller's thread.
+ */
+struct PyVtk_PreviewOptions
+{
+	size_t stride;
+	size_t targetCells;
+	size_t seedRatio;
+	unsigned int settleMilliseconds;
+};
+
+/*
+ * Properties read by PyVtk_SnapshotProperties, one block holding a column per
+ * field. Entry i is property text + names[i] of the object at objects[i] in the
+ * list passed in. Its type is 'b', 'd' or 'f' for booleans, integers and floats,
+ * held in numbers; 's' for strings of lengths[i] characters at text + starts[i];
+ * 't' for tuples of lengths[i] numbers at components + starts[i]; 0 if the value
+ * could not be read. size is that of the whole block.
+ */
+struct PyVtk_Snapshot
+{
+	size_t count;
+	const unsigned int *objects;
+	const unsigned int *names;
+	const char *types;
+	const double *numbers;
+	const unsigned int *starts;
+	const unsigned int *lengths;
+	const char *text;
+	const double *components;
+	size_t size;
+};
+
+/*
+ * Change of a property taken with PyVtk_NextChange, typed as in PyVtk_Snapshot:
+ * 'b', 'd' and 'f' values are in number, 's' ones are length characters at text
+ * and 't' ones length numbers at components. The pointers stay valid until the
+ * next PyVtk_NextChange on the subscription.
+ */
+struct PyVtk_Change
+{
+	vtkObjectBase *pObject;
+	LPCSTR property;
+	char type;
+	double number;
+	LPCSTR text;
+	const double *components;
+	size_t length;
+};
+
+/*
+ * Kinds of value the typed method calls decode their result into.
+ */
+enum PyVtk_ResultKind
+{
+	PYVTK_RESULT_NONE,
+	PYVTK_RESULT_INT,
+	PYVTK_RESULT_DOUBLE,
+	PYVTK_RESULT_STRING,
+	PYVTK_RESULT_OBJECT,
+	PYVTK_RESULT_ARRAY
+};
+
+/*
+ * Values of a vtkDataArray, in place: tuples of components values of dataType,
+ * a VTK type constant, valid as long as the array is not modified or deleted.
+ */
+struct PyVtk_ArrayView
+{
+	const void *pData;
+	int dataType;
+	int components;
+	long long tuples;
+};
+
+/*
+ * Result of PyVtk_ObjectMethodInto and PyVtk_PipedObjectMethodInto, and value
+ * of PyVtk_SetVtkObjectPropertyValue. The caller sets kind and, for numbers,
+ * the storage of capacity values they are written to: pIntegers for
+ * PYVTK_RESULT_INT, pDoubles for PYVTK_RESULT_DOUBLE. arity is set to the size
+ * of a tuple, 0 for a single value, as in the "f3" and "f" formats. Strings are
+ * in the scratch arena. pObject is the VTK object returned, or the array viewed
+ * by array, as a VTK getter would return it; if nothing else held it, owned is
+ * set and the caller releases it with Delete.
+ */
+struct PyVtk_Result
+{
+	PyVtk_ResultKind kind;
+	long long *pIntegers;
+	double *pDoubles;
+	size_t capacity;
+	size_t arity;
+	LPCSTR str;
+	vtkObjectBase *pObject;
+	bool owned;
+	PyVtk_ArrayView array;
+};
+
+/*
+ * Layout of the files written by PyVtk_ExportColumns, meant to be mapped in
+ * memory as they are. The header is followed by a table of blockCount blocks,
+ * then by the blocks themselves, each starting at a multiple of
+ * PYVTK_COLUMN_ALIGNMENT bytes into the file. Every block holds tuples of
+ * components values of valueType, a VTK type constant, contiguously and in the
+ * byte order of the writer. The points, the offsets and connectivity of each
+ * kind of cell of polygonal data, named "verts", "lines", "polys" or "strips",
+ * and every point and cell array, under its own name, are separate blocks.
+ * Structured grids carry their dimensions instead of cells.
+ */
+#define PYVTK_COLUMN_ALIGNMENT 64
+
+enum PyVtk_ColumnKind
+{
+	PYVTK_COLUMN_POINTS,
+	PYVTK_COLUMN_OFFSETS,
+	PYVTK_COLUMN_CONNECTIVITY,
+	PYVTK_COLUMN_LEGACY_CELLS,
+	PYVTK_COLUMN_POINT_DATA,
+	PYVTK_COLUMN_CELL_DATA
+};
+
+struct PyVtk_ColumnHeader
+{
+	char magic[8];
+	unsigned int version;
+	int dataType;
+	unsigned long long points;
+	unsigned long long cells;
+	int dimensions[3];
+	unsigned int blockCount;
+};
+
+struct PyVtk_ColumnBlock
+{
+	char name[64];
+	unsigned int kind;
+	int valueType;
+	unsigned int components;
+	unsigned int valueSize;
+	unsigned long long tuples;
+	unsigned long long offset;
+	unsigned long long bytes;
+};
+
+/*
+ * Subscription to the changes of objects, made by PyVtk_Subscribe.
+ */
+struct PyVtk_Subscription;
+
+/*
+ * Call chain resolved once by PyVtk_PrepareChain.
+ */
+struct PyVtk_Chain;
+
+/*
+ * Receives each call of a replayed recording, with its recorded and replayed
+ * latency in nanoseconds.
+ */
+typedef void (*PyVtk_ReplayCallback)(
+	void *pContext,
+	size_t index,
+	LPCSTR entry,
+	unsigned long long recorded,
+	unsigned long long replayed,
+	bool succeeded);
+
+/*
+ * Receives each chunk of a progressive execution as it completes, with the
+ * number of chunks done so far out of the total. The chunk is only valid during
+ * the call; returning false abandons the remaining chunks.
+ */
+typedef bool (*PyVtk_ChunkCallback)(
+	void *pContext,
+	vtkDataObject *pChunk,
+	size_t done,
+	size_t total);
+
+
+/*
+ * Scratch arena.
+ */
+void PyVtk_ResetScratch();
+
+PyVtk_ScratchStats PyVtk_GetScratchStats();
+
+LPCSTR PyVtk_RetainResult(
+	LPCSTR result);
+
+void PyVtk_ReleaseResult(
+	LPCSTR result);
+
+
+/*
+ * Error channel.
+ */
+int PyVtk_GetLastError();
+
+bool PyVtk_PopError(
+	PyVtk_ErrorRecord *pRecord);
+
+size_t PyVtk_GetDroppedErrors();
+
+bool PyVtk_StartErrorLog(
+	LPCSTR path);
+
+void PyVtk_StopErrorLog();
+
+
+/*
+ * Instrumentation.
+ */
+size_t PyVtk_GetInstrumentation(
+	PyVtk_EntryStats *pStats,
+	size_t capacity);
+
+void PyVtk_ResetInstrumentation();
+
+void PyVtk_SetInstrumentation(
+	bool enabled);
+
+bool PyVtk_StartInstrumentationExport(
+	LPCSTR path,
+	unsigned int intervalMilliseconds,
+	bool json);
+
+void PyVtk_StopInstrumentationExport();
+
+bool PyVtk_StartTrace(
+	size_t capacity);
+
+void PyVtk_StopTrace();
+
+bool PyVtk_FlushTrace(
+	LPCSTR path);
+
+
+/*
+ * Call recording and replay.
+ */
+bool PyVtk_StartRecording(
+	LPCSTR path);
+
+void PyVtk_StopRecording();
+
+bool PyVtk_ReplayRecording(
+	PyObject *pIntrospector,
+	LPCSTR path,
+	bool originalTiming,
+	PyVtk_ReplayCallback callback,
+	void *pContext);
+
+
+/*
+ * Property write coalescing.
+ */
+bool PyVtk_FlushProperties(
+	PyObject *pIntrospector);
+
+void PyVtk_SetCoalescing(
+	PyObject *pIntrospector,
+	bool enabled,
+	unsigned int tickMilliseconds);
+
+
+/*
+ * Introspector and objects.
+ */
+PyObject *PyVtk_InitIntrospector();
+
+PyVtk_InitStats PyVtk_GetInitStats();
+
+PyObject *PyVtk_InitIntrospectorWithOptions(
+	const PyVtk_InitOptions *pOptions);
+
+vtkObjectBase *PyVtk_CreateVtkObject(
+	PyObject *pIntrospector,
+	const char *sVtkClassName);
+
+const char *PyVtk_GetVtkObjectProperty(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	LPCSTR propertyName,
+	LPCSTR expectedType);
+
+int PyVtk_SetVtkObjectProperty(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	LPCSTR propertyName,
+	LPCSTR format,
+	LPCSTR newValue);
+
+int PyVtk_SetVtkObjectPropertyValue(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	LPCSTR propertyName,
+	const PyVtk_Result *pValue);
+
+const char *PyVtk_GetVtkObjectDescriptor(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject);
+
+long PyVtk_FindVtkClasses(
+	PyObject *pIntrospector,
+	LPCSTR query,
+	PyVtk_ClassQuery mode,
+	size_t limit,
+	LPCSTR **pNames);
+
+PyVtk_Snapshot *PyVtk_SnapshotProperties(
+	PyObject *pIntrospector,
+	const std::vector<vtkObjectBase *> &objects,
+	const std::vector<LPCSTR> &properties);
+
+void PyVtk_ReleaseSnapshot(
+	PyVtk_Snapshot *pSnapshot);
+
+PyVtk_Subscription *PyVtk_Subscribe(
+	PyObject *pIntrospector,
+	const std::vector<vtkObjectBase *> &objects,
+	const std::vector<LPCSTR> &properties);
+
+bool PyVtk_PollChanges(
+	PyObject *pIntrospector,
+	PyVtk_Subscription *pSubscription);
+
+bool PyVtk_NextChange(
+	PyVtk_Subscription *pSubscription,
+	PyVtk_Change *pChange);
+
+void PyVtk_Unsubscribe(
+	PyVtk_Subscription *pSubscription);
+
+bool PyVtk_DeleteVtkObject(
+	PyObject *pIntrospector,
+	vtkObjectBase* pVtkObject);
+
+vtkAlgorithmOutput *PyVtk_GetOutputPort(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject);
+
+bool PyVtk_ConnectVtkObject(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	vtkAlgorithm *pVtkTarget);
+
+bool PyVtk_ConnectVtkObjectPorts(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	int outputPort,
+	vtkAlgorithm *pVtkTarget,
+	int inputPort,
+	bool add);
+
+bool PyVtk_SetPoolSize(
+	PyObject *pIntrospector,
+	LPCSTR sVtkClassName,
+	size_t size);
+
+void PyVtk_CloseSession(
+	PyObject *pIntrospector);
+
+void PyVtk_SetFastExit(
+	bool enabled);
+
+void PyVtk_FinalizeIntrospector(
+	PyObject *pIntrospector);
+
+
+/*
+ * Method calls.
+ */
+void PyVtk_SetFastPath(
+	bool enabled);
+
+PyObject *PyVtk_ArgvTuple(
+	LPCSTR format,
+	size_t argc,
+	vtkObjectBase *const *pReferences,
+	size_t refc,
+	LPCSTR const *argv,
+	size_t valc);
+
+PyObject *PyVtk_ObjectMethod(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	LPCSTR method,
+	LPCSTR format,
+	const std::vector<vtkObjectBase *> &pReferences,
+	const std::vector<LPCSTR> &argv);
+
+vtkObjectBase *PyVtk_ObjectMethodAsVtkObject(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	LPCSTR method,
+	LPCSTR vtkClassname,
+	LPCSTR format,
+	const std::vector<vtkObjectBase *> &pReferences,
+	const std::vector<LPCSTR> &argv);
+
+PyObject *PyVtk_PipedObjectMethod(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	const std::vector<LPCSTR> &methods,
+	const std::vector<LPCSTR> &formats,
+	const std::vector<vtkObjectBase *> &pReferences,
+	const std::vector<LPCSTR> &argv);
+
+LPCSTR PyVtk_PipedObjectMethodAsString(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	const std::vector<LPCSTR> &methods,
+	const std::vector<LPCSTR> &formats,
+	const std::vector<vtkObjectBase *> &pReferences,
+	const std::vector<LPCSTR> &argv);
+
+bool PyVtk_ObjectMethodInto(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	LPCSTR method,
+	LPCSTR format,
+	const std::vector<vtkObjectBase *> &pReferences,
+	const std::vector<LPCSTR> &argv,
+	PyVtk_Result *pResult);
+
+bool PyVtk_PipedObjectMethodInto(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	const std::vector<LPCSTR> &methods,
+	const std::vector<LPCSTR> &formats,
+	const std::vector<vtkObjectBase *> &pReferences,
+	const std::vector<LPCSTR> &argv,
+	PyVtk_Result *pResult);
+
+
+/*
+ * Prepared call chains.
+ */
+void PyVtk_ReleaseChain(
+	PyVtk_Chain *pChain);
+
+PyVtk_Chain *PyVtk_PrepareChain(
+	PyObject *pIntrospector,
+	const std::vector<LPCSTR> &methods,
+	const std::vector<LPCSTR> &formats);
+
+PyObject *PyVtk_ExecuteChain(
+	PyObject *pIntrospector,
+	PyVtk_Chain *pChain,
+	vtkObjectBase *pVtkObject,
+	const std::vector<vtkObjectBase *> &pReferences,
+	const std::vector<LPCSTR> &argv);
+
+
+/*
+ * Parameter sweeps.
+ */
+bool PyVtk_SweepVtkObjectProperty(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	LPCSTR propertyName,
+	LPCSTR format,
+	const std::vector<LPCSTR> &values,
+	vtkObjectBase *pVtkSink,
+	size_t threads,
+	std::vector<vtkDataObject *> *pResults);
+
+
+/*
+ * Pipeline scheduling.
+ */
+bool PyVtk_UpdatePipeline(
+	PyObject *pIntrospector,
+	const std::vector<vtkObjectBase *> &sinks,
+	size_t threads);
+
+
+/*
+ * Threading of VTK and thread budgets.
+ */
+bool PyVtk_ConfigureSmp(
+	LPCSTR backend,
+	size_t threads);
+
+LPCSTR PyVtk_GetSmpBackend();
+
+void PyVtk_SetThreadBudget(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkSink,
+	size_t threads);
+
+
+/*
+ * Progressive execution.
+ */
+bool PyVtk_ProgressiveUpdate(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkFilter,
+	size_t chunkSize,
+	size_t threads,
+	PyVtk_ChunkCallback callback,
+	void *pContext,
+	vtkDataObject **ppResult);
+
+
+/*
+ * Preview mode.
+ */
+bool PyVtk_SetPreview(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkSink,
+	const PyVtk_PreviewOptions *pOptions);
+
+bool PyVtk_IsPreview(
+	vtkObjectBase *pVtkSink);
+
+size_t PyVtk_PollPreviews(
+	PyObject *pIntrospector);
+
+
+/*
+ * Session snapshots.
+ */
+bool PyVtk_SaveSession(
+	PyObject *pIntrospector,
+	LPCSTR path,
+	bool includeOutputs,
+	std::vector<vtkObjectBase *> *pObjects);
+
+bool PyVtk_RestoreSession(
+	PyObject *pIntrospector,
+	LPCSTR path,
+	std::vector<vtkObjectBase *> *pObjects);
+
+
+/*
+ * Columnar export.
+ */
+bool PyVtk_ExportColumns(
+	PyObject *pIntrospector,
+	vtkObjectBase *pVtkObject,
+	LPCSTR path);
+
+
+size_t split(
+	LPCSTR str,
+	char split,
+	LPCSTR **pTokens);
+
+#endif /* PYVTK_H */
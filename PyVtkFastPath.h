@@ -0,0 +1,40 @@
+#ifndef PYVTK_FAST_PATH_H
+#define PYVTK_FAST_PATH_H
+
+#include <vtkPointSource.h>
+#include <vtkStreamTracer.h>
+#include <vtkStructuredGridReader.h>
+
+
+/*
+ * Properties and methods dispatched straight to VTK, without going through the
+ * Introspector. Each line expands to a typed accessor when PyVtk.cpp is built;
+ * anything not listed takes the Python path. Adding a class here needs its
+ * header above.
+ *
+ * SCALAR(class, property, format)  Set/Get of one int ('d') or double ('f')
+ * VECTOR(class, property, size)    Set/Get of a double array of the given size
+ * STRING(class, property)          Set/Get of a string
+ * METHOD(class, method)            method taking no argument, returning nothing
+ */
+#define PYVTK_FAST_PROPERTIES(SCALAR, VECTOR, STRING) \
+	SCALAR(vtkPointSource, Radius, 'f') \
+	SCALAR(vtkPointSource, NumberOfPoints, 'd') \
+	VECTOR(vtkPointSource, Center, 3) \
+	SCALAR(vtkStreamTracer, MaximumPropagation, 'f') \
+	SCALAR(vtkStreamTracer, InitialIntegrationStep, 'f') \
+	SCALAR(vtkStreamTracer, MaximumNumberOfSteps, 'd') \
+	VECTOR(vtkStreamTracer, StartPosition, 3) \
+	STRING(vtkStructuredGridReader, FileName)
+
+#define PYVTK_FAST_METHODS(METHOD) \
+	METHOD(vtkPointSource, SetDistributionToUniform) \
+	METHOD(vtkPointSource, SetDistributionToShell) \
+	METHOD(vtkPointSource, Update) \
+	METHOD(vtkStreamTracer, SetIntegrationDirectionToForward) \
+	METHOD(vtkStreamTracer, SetIntegrationDirectionToBackward) \
+	METHOD(vtkStreamTracer, SetIntegrationDirectionToBoth) \
+	METHOD(vtkStreamTracer, Update) \
+	METHOD(vtkStructuredGridReader, Update)
+
+#endif /* PYVTK_FAST_PATH_H */
@@ -4,14 +4,13 @@
 # Date: 08-06-2016
 #
 
-from vtk import *
 from PipelineObject import *
 from copy import deepcopy
 
 # Class that wraps a VTK class in the classTree and determines its
 # characteristics.
 class TreeObject():
-    def __init__(self, classType, eo):
+    def __init__(self, classType, eo, withSubclasses=True):
         self.classType = classType
         self.eo = eo
 
@@ -24,10 +23,17 @@ class TreeObject():
         self.onOffMethods = []
         self.setToMethods = []
         self.setValueMethods = []
+        self.tupleMethods = {}
 
         self.categories = []
 
-        self.buildSubtree()
+        # Released nodes kept for reuse, and an unused node holding the
+        # defaults they are reset to.
+        self.pool = []
+        self.poolSize = 0
+        self.defaultNode = None
+
+        self.buildSubtree(withSubclasses)
         self.parseMethods()
 
     def parseMethods(self):
@@ -134,7 +140,7 @@ class TreeObject():
         # For experiments: check if this is a vtkContourFilter,
         # used to add the 'SetValue' method manually.
         isContourFilter = False
-        if self.classType == vtkContourFilter:
+        if self.classType.__name__ == "vtkContourFilter":
             isContourFilter = True
 
 
@@ -162,6 +168,11 @@ class TreeObject():
                                                 "setReturnType": setTypes[0][0],
                                                 "setParameterTypes": setTypes[0][1]}
             
+            elif getTypes[0][1] == "void":
+                # Tuple attributes, such as a Center, are not offered for
+                # editing but are part of the state nodes copy and reset.
+                self.parseTupleMethod(setMethod, getMethod, dummyNode)
+
             # For experiments: 'manually' add SetValue method if this is a
             # vtkContourFilter.
             if isContourFilter and setMethod == "SetValue":
@@ -170,6 +181,20 @@ class TreeObject():
                 
         self.setValueMethods = setValueMethodsDict
 
+    def parseTupleMethod(self, setMethod, getMethod, dummyNode):
+        # Keep a Get/Set pair whose default is a tuple of numbers that the
+        # setter takes back as it is.
+        try:
+            value = getattr(dummyNode, getMethod)()
+            if (not isinstance(value, tuple) or len(value) == 0
+                or not all(isinstance(v, (int, float)) for v in value)):
+                return
+            getattr(dummyNode, setMethod)(value)
+        except (TypeError, ValueError, AttributeError):
+            return
+
+        self.tupleMethods[setMethod] = getMethod
+
     # For experiments: if this is a vtkContourFilter, add the 'SetValue'
     # method manually.
     def addSetValueContourFilter(self, setValueMethodsDict, dummyNode, setMethod, getMethod):
@@ -255,11 +280,12 @@ class TreeObject():
             return "Get" + methodName
 
 
-    def buildSubtree(self):
+    def buildSubtree(self, withSubclasses=True):
         # This will create TreeObjects for all subclasses (recursively)
         # and determine if this vtk class (type) is abstract and implemented.
         # The tree can be used for selecting a new node to add to the pipeline. 
-        subclasses = self.classType.__subclasses__()
+        # Without subclasses, the TreeObject stands for its class alone.
+        subclasses = self.classType.__subclasses__() if withSubclasses else []
         self.subclasses = []
 
         for subClassType in subclasses:
@@ -335,10 +361,6 @@ class TreeObject():
         
         dummyNode = self.classType()
 
-        # Only list single output objects (for linear pipeline)
-        if dummyNode.GetNumberOfOutputPorts() > 1:
-            return False
-
         # Only list no input objects for source objects
         if outputPort == None:
             if dummyNode.GetNumberOfInputPorts() != 0:
@@ -356,15 +378,17 @@ class TreeObject():
         # The object has the correct amount of input and output ports, check
         # if the output is accepted now:
 
-        # Reset error handler/observer
-        self.eo.ErrorOccurred()
+        with self.eo.watching():
+            # Reset error handler/observer
+            self.eo.ErrorOccurred()
 
-        # Test if self accepts outputPort as input
-        dummyNode.SetInputConnection(prevNode.vtkInstanceCall("GetOutputPort"))
-        dummyNode.UpdateInformation()
+            # Test if self accepts outputPort as input
+            dummyNode.SetInputConnection(prevNode.vtkInstanceCall("GetOutputPort"))
+            dummyNode.UpdateInformation()
 
+            accepted = not self.eo.ErrorOccurred()
 
-        if not self.eo.ErrorOccurred():
+        if accepted:
             # Cache the result
             if prevNodeTypeName != None:
                 self.acceptsCache[prevNodeTypeName] = True
@@ -388,6 +412,12 @@ class TreeObject():
 
         return hashTable
 
+    def getPropertyNames(self):
+        # Names of the properties the attributes of a node are set through.
+        names = list(self.setToMethods) + list(self.onOffMethods)
+        names += [setMethod[3:] for setMethod in self.setValueMethods]
+        return sorted(set(names))
+
     def createNode(self):
         # Create a pipelineObject with which wraps a vtkInstance of the class
         # that this TreeObject represents, and return it.
@@ -396,19 +426,53 @@ class TreeObject():
         if self.isAbstract:
             raise Exception("Cannot instantiate abstract class.")
 
+        # Pooled nodes have already been reset to the defaults.
+        if len(self.pool) != 0:
+            return self.pool.pop()
+
+        return self.newNode()
+
+    def newNode(self):
         # Instantiate vtkInstance
         vtkInstance = self.classType()
 
-        # Copy attribute methods and current (default) values
-        methods = [deepcopy(self.setToMethods), deepcopy(self.onOffMethods),
-                    deepcopy(self.setValueMethods)]
+        # Share attribute methods and current (default) values; the node
+        # copies them once it changes them.
+        methods = [self.setToMethods, self.onOffMethods, self.setValueMethods]
 
         # Wrap in pipelineObject
-        pipelineObject = PipelineObject(vtkInstance, methods)
+        pipelineObject = PipelineObject(vtkInstance, methods, shared=True,
+            tupleMethods=self.tupleMethods)
 
         # print "Created node:", pipelineObject, pipelineObject.vtkInstance
         return pipelineObject
 
+    def getDefaultNode(self):
+        # An unused node, to read the default attribute values from.
+        if self.defaultNode == None:
+            self.defaultNode = self.newNode()
+
+        return self.defaultNode
+
+    def setPoolSize(self, size):
+        # Keep up to 'size' released nodes for reuse, and fill the pool with
+        # new ones right away.
+        self.poolSize = size
+        del self.pool[size:]
+
+        while len(self.pool) < size:
+            self.pool.append(self.newNode())
+
+    def releaseNode(self, node):
+        # Take back a node that is no longer used if the pool has room.
+        if len(self.pool) >= self.poolSize:
+            return False
+
+        node.reset(self.getDefaultNode(),
+            [self.setToMethods, self.onOffMethods, self.setValueMethods])
+        self.pool.append(node)
+        return True
+
     def setCategories(self, categories, mapping):
         # Determine the categories that this class belongs to and store it.
 
@@ -0,0 +1,1890 @@
+#include "PyVtk.h"
+
+#include <vtkSphereSource.h>
+#include <vtkElevationFilter.h>
+#include <vtkRTAnalyticSource.h>
+#include <vtkContourFilter.h>
+#include <vtkPointSource.h>
+#include <vtkStructuredGridReader.h>
+#include <vtkStreamTracer.h>
+#include <vtkDataSet.h>
+#include <vtkXMLPolyDataWriter.h>
+
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <cctype>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <utility>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <new>
+
+#include <psapi.h>
+
+
+typedef std::chrono::high_resolution_clock::time_point time_var;
+
+#define DURATION(a) std::chrono::duration_cast<std::chrono::nanoseconds>(a).count()
+#define TIME_NOW() std::chrono::high_resolution_clock::now()
+
+
+/*
+ * Samples of one operation of a case. Operations are kept in the order they are
+ * first recorded, so the rows of a report line up from one run to the next.
+ */
+struct BenchmarkSeries
+{
+	std::string caseName;
+	std::string operation;
+	std::string unit;
+	std::vector<double> samples;
+};
+
+struct BenchmarkSummary
+{
+	double min;
+	double median;
+	double p95;
+	double p99;
+	double mean;
+};
+
+class Benchmark
+{
+public:
+	Benchmark()
+		: recording(true)
+	{
+	}
+
+	/* Selects the case the following samples are recorded under. */
+	void SetCase(LPCSTR caseName)
+	{
+		currentCase = caseName;
+	}
+
+	/* Samples are only kept while recording, which is off during warmup. */
+	void SetRecording(bool enabled)
+	{
+		recording = enabled;
+	}
+
+	void Record(LPCSTR operation, LPCSTR unit, double value)
+	{
+		if (!recording)
+		{
+			return;
+		}
+
+		std::string key = currentCase + "/" + operation;
+		auto iSeries = index.find(key);
+		if (iSeries == index.end())
+		{
+			BenchmarkSeries newSeries;
+			newSeries.caseName = currentCase;
+			newSeries.operation = operation;
+			newSeries.unit = unit;
+			iSeries = index.insert(std::make_pair(key, series.size())).first;
+			series.push_back(newSeries);
+		}
+		series[iSeries->second].samples.push_back(value);
+	}
+
+	const std::vector<BenchmarkSeries> &Series() const
+	{
+		return series;
+	}
+
+	const BenchmarkSeries *Find(const std::string &caseName, const std::string &operation) const
+	{
+		auto iSeries = index.find(caseName + "/" + operation);
+		return iSeries != index.end() ? &series[iSeries->second] : NULL;
+	}
+
+	/*
+	 * Percentiles use the nearest-rank method, so they are always one of the
+	 * recorded samples.
+	 */
+	static BenchmarkSummary Summarize(const BenchmarkSeries &data)
+	{
+		BenchmarkSummary summary = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+		std::vector<double> sorted(data.samples);
+		if (sorted.empty())
+		{
+			return summary;
+		}
+		std::sort(sorted.begin(), sorted.end());
+
+		double sum = 0.0;
+		for (double sample : sorted)
+		{
+			sum += sample;
+		}
+
+		summary.min = sorted.front();
+		summary.median = sorted.size() % 2 == 1
+			? sorted[sorted.size() / 2]
+			: (sorted[sorted.size() / 2 - 1] + sorted[sorted.size() / 2]) / 2.0;
+		summary.p95 = Percentile(sorted, 0.95);
+		summary.p99 = Percentile(sorted, 0.99);
+		summary.mean = sum / sorted.size();
+		return summary;
+	}
+
+private:
+	static double Percentile(const std::vector<double> &sorted, double p)
+	{
+		size_t rank = (size_t) std::ceil(p * sorted.size());
+		return sorted[rank > 0 ? rank - 1 : 0];
+	}
+
+	bool recording;
+	std::string currentCase;
+	std::vector<BenchmarkSeries> series;
+	std::unordered_map<std::string, size_t> index;
+};
+
+static Benchmark benchmark;
+
+
+template<typename R, typename F, typename... A>
+R timed_execution(LPCSTR name, F function, A&& ...argv)
+{
+	time_var start = TIME_NOW();
+	R r = function(std::forward<A>(argv)...);
+	benchmark.Record(name, "ns", (double) DURATION(TIME_NOW() - start));
+	return r;
+}
+
+template<typename F, typename... A>
+void timed_execution_v(LPCSTR name, F function, A&& ...argv)
+{
+	time_var start = TIME_NOW();
+	function(std::forward<A>(argv)...);
+	benchmark.Record(name, "ns", (double) DURATION(TIME_NOW() - start));
+}
+
+/*
+ * Times a call returning a new reference and releases it, so that repetitions do
+ * not pile up the results nobody looks at.
+ */
+template<typename F, typename... A>
+void timed_execution_o(LPCSTR name, F function, A&& ...argv)
+{
+	time_var start = TIME_NOW();
+	PyObject *pResult = function(std::forward<A>(argv)...);
+	benchmark.Record(name, "ns", (double) DURATION(TIME_NOW() - start));
+	Py_XDECREF(pResult);
+}
+
+
+/*
+ * Working set of the process.
+ */
+static size_t resident_bytes()
+{
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return 0;
+	}
+	return counters.WorkingSetSize;
+}
+
+
+/*
+ * Counting every C++ heap allocation of the process. Together with the chunk
+ * allocations of the scratch arena, this covers all the mallocs the embedding
+ * layer can issue on the get/set path.
+ */
+static std::atomic<size_t> heap_allocations(0);
+
+void *operator new(size_t size)
+{
+	++heap_allocations;
+	void *p = malloc(size);
+	if (p == NULL)
+	{
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+
+/*
+ * Cases. Each one is run once per repetition and has to leave the interpreter
+ * as it found it, as the interpreter is shared by all of them.
+ */
+void test_introspection(
+	PyObject *pIntrospector,
+	PyObject *pVtkModule)
+{
+	/* Measuring the Python path; test_fastpath covers the direct accessors. */
+	PyVtk_SetFastPath(false);
+
+	vtkObjectBase
+		*pReader = timed_execution<vtkObjectBase *>("reader_inst", PyVtk_CreateVtkObject, pIntrospector, "vtkStructuredGridReader"),
+		*pSeeds = timed_execution<vtkObjectBase *>("seeds_inst", PyVtk_CreateVtkObject, pIntrospector, "vtkPointSource"),
+		*pStreamer = timed_execution<vtkObjectBase *>("streamer_inst", PyVtk_CreateVtkObject, pIntrospector, "vtkStreamTracer"),
+		*pOutline = timed_execution<vtkObjectBase *>("outline_inst", PyVtk_CreateVtkObject, pIntrospector, "vtkStructuredGridOutlineFilter");
+
+	timed_execution_v("reader_setfile", PyVtk_SetVtkObjectProperty, pIntrospector, pReader, "FileName", "s", "density.vtk");
+
+	timed_execution_o("reader_update", PyVtk_ObjectMethod, // pReader->Update()
+		pIntrospector,
+		pReader,
+		"Update",
+		"",
+		std::vector<vtkObjectBase *>(),
+		std::vector<LPCSTR>());
+
+	timed_execution_o("reader_getoutput", PyVtk_ObjectMethod, // pReader->GetOutput()
+		pIntrospector,
+		pReader,
+		"GetOutput",
+		"",
+		std::vector<vtkObjectBase *>(),
+		std::vector<LPCSTR>());
+
+	LPCSTR center = timed_execution<LPCSTR>("reader_getoutput_getcenter", PyVtk_PipedObjectMethodAsString, // pReader->GetOutput()->GetCenter()
+		pIntrospector,
+		pReader,
+		std::vector<LPCSTR>({ "GetOutput", "GetCenter" }),
+		std::vector<LPCSTR>({ "", "" }),
+		std::vector<vtkObjectBase *>(),
+		std::vector<LPCSTR>());
+
+	double centerValues[3];
+	PyVtk_Result centerResult = { PYVTK_RESULT_DOUBLE, NULL, centerValues, 3, 0, NULL, NULL, false, { NULL, 0, 0, 0 } };
+	timed_execution<bool>("reader_getoutput_getcenter_typed", PyVtk_PipedObjectMethodInto, // same chain, into doubles
+		pIntrospector,
+		pReader,
+		std::vector<LPCSTR>({ "GetOutput", "GetCenter" }),
+		std::vector<LPCSTR>({ "", "" }),
+		std::vector<vtkObjectBase *>(),
+		std::vector<LPCSTR>(),
+		&centerResult);
+
+	PyVtk_Chain *pCenterChain = PyVtk_PrepareChain(pIntrospector,
+		std::vector<LPCSTR>({ "GetOutput", "GetCenter" }),
+		std::vector<LPCSTR>({ "", "" }));
+	timed_execution_o("reader_getoutput_getcenter_prepared", PyVtk_ExecuteChain, // same chain, prepared
+		pIntrospector,
+		pCenterChain,
+		pReader,
+		std::vector<vtkObjectBase *>(),
+		std::vector<LPCSTR>());
+	PyVtk_ReleaseChain(pCenterChain);
+
+	timed_execution_v("seeds_setradius", PyVtk_SetVtkObjectProperty, pIntrospector, pSeeds, "Radius", "f", "3.0");
+	timed_execution_v("seeds_setcenter", PyVtk_SetVtkObjectProperty, pIntrospector, pSeeds, "Center", "f3", center);
+	timed_execution_v("seeds_setcenter_typed", PyVtk_SetVtkObjectPropertyValue, pIntrospector, pSeeds, "Center", &centerResult);
+	timed_execution_v("seeds_setnumberofpoints", PyVtk_SetVtkObjectProperty, pIntrospector, pSeeds, "NumberOfPoints", "d", "100");
+
+	vtkAlgorithmOutput *pSeedsPort = timed_execution<vtkAlgorithmOutput *>("seeds_getoutputport", PyVtk_GetOutputPort, pIntrospector, pSeeds);
+
+	timed_execution_v("streamer_setinputconn_reader", PyVtk_ConnectVtkObject, pIntrospector, pReader, (vtkAlgorithm *)pStreamer);
+	timed_execution_o("streamer_setsourceconn_seeds", PyVtk_ObjectMethod, // pStreamer->SetSourceConnection(pSeeds->GetOutputPort(0))
+		pIntrospector,
+		pStreamer,
+		"SetSourceConnection",
+		"o",
+		std::vector<vtkObjectBase *>({ pSeedsPort }),
+		std::vector<LPCSTR>());
+
+	timed_execution_v("streamer_setmaxpropagation", PyVtk_SetVtkObjectProperty, pIntrospector, pStreamer, "MaximumPropagation", "d", "100");
+	timed_execution_v("streamer_setinitialintegstep", PyVtk_SetVtkObjectProperty, pIntrospector, pStreamer, "InitialIntegrationStep", "f", "0.1");
+	timed_execution_o("streamer_setintegdirboth", PyVtk_ObjectMethod, // pStreamer->SetIntegrationDirectionToBoth()
+		pIntrospector,
+		pStreamer,
+		"SetIntegrationDirectionToBoth",
+		"",
+		std::vector<vtkObjectBase *>(),
+		std::vector<LPCSTR>());
+
+	timed_execution_v("outline_setinputconn", PyVtk_ConnectVtkObject, pIntrospector, pReader, (vtkAlgorithm *)pOutline);
+
+	timed_execution_v("outline_delete", PyVtk_DeleteVtkObject, pIntrospector, pOutline);
+	timed_execution_v("streamer_delete", PyVtk_DeleteVtkObject, pIntrospector, pStreamer);
+	timed_execution_v("seeds_delete", PyVtk_DeleteVtkObject, pIntrospector, pSeeds);
+	timed_execution_v("reader_delete", PyVtk_DeleteVtkObject, pIntrospector, pReader);
+
+	PyVtk_SetFastPath(true);
+}
+
+
+/*
+ * Churn of short-lived filters, created, set and deleted again, with and
+ * without a pool for their class.
+ */
+void test_pool(
+	PyObject *pIntrospector,
+	PyObject *pVtkModule)
+{
+	const int iterations = 200;
+
+	for (size_t poolSize : { (size_t) 0, (size_t) 16 })
+	{
+		PyVtk_SetPoolSize(pIntrospector, "vtkElevationFilter", poolSize);
+		LPCSTR operation = poolSize == 0 ? "churn_unpooled" : "churn_pooled";
+
+		time_var start = TIME_NOW();
+		for (int i = 0; i < iterations; ++i)
+		{
+			vtkObjectBase *pElevation = PyVtk_CreateVtkObject(pIntrospector, "vtkElevationFilter");
+			PyVtk_SetVtkObjectProperty(pIntrospector, pElevation, "LowPoint", "f3", "0,0,-1");
+			PyVtk_DeleteVtkObject(pIntrospector, pElevation);
+		}
+		benchmark.Record(operation, "ns", (double) DURATION(TIME_NOW() - start) / iterations);
+	}
+
+	PyVtk_SetPoolSize(pIntrospector, "vtkElevationFilter", 0);
+}
+
+
+/*
+ * Closing a session of many objects at once, against deleting them one by one.
+ */
+void test_teardown(
+	PyObject *pIntrospector,
+	PyObject *pVtkModule)
+{
+	const int objects = 2000;
+	std::vector<vtkObjectBase *> created;
+
+	for (int i = 0; i < objects; ++i)
+	{
+		created.push_back(PyVtk_CreateVtkObject(pIntrospector, "vtkElevationFilter"));
+	}
+	time_var start = TIME_NOW();
+	for (vtkObjectBase *pVtkObject : created)
+	{
+		PyVtk_DeleteVtkObject(pIntrospector, pVtkObject);
+	}
+	benchmark.Record("delete_each", "ns", (double) DURATION(TIME_NOW() - start));
+
+	for (int i = 0; i < objects; ++i)
+	{
+		PyVtk_CreateVtkObject(pIntrospector, "vtkElevationFilter");
+	}
+	timed_execution_v("close_session", PyVtk_CloseSession, pIntrospector);
+}
+
+
+/*
+ * Refresh of every listed property of a 50 node pipeline, one property at a time
+ * and as a single snapshot.
+ */
+void test_snapshot(
+	PyObject *pIntrospector,
+	PyObject *pVtkModule)
+{
+	const int objects = 50;
+	const int rounds = 20;
+	LPCSTR classNames[] = { "vtkPointSource", "vtkElevationFilter", "vtkStreamTracer" };
+
+	std::vector<vtkObjectBase *> created;
+	for (int i = 0; i < objects; ++i)
+	{
+		created.push_back(PyVtk_CreateVtkObject(pIntrospector, classNames[i % 3]));
+	}
+
+	PyVtk_Snapshot *pSnapshot = PyVtk_SnapshotProperties(pIntrospector, created, std::vector<LPCSTR>());
+	if (pSnapshot == NULL)
+	{
+		return;
+	}
+	benchmark.Record("snapshot_properties", "count", (double) pSnapshot->count);
+	benchmark.Record("snapshot_bytes", "bytes", (double) pSnapshot->size);
+
+	time_var start = TIME_NOW();
+	for (int round = 0; round < rounds; ++round)
+	{
+		for (size_t i = 0; i < pSnapshot->count; ++i)
+		{
+			char type[2] = { pSnapshot->types[i], '\0' };
+			PyVtk_GetVtkObjectProperty(pIntrospector, created[pSnapshot->objects[i]], pSnapshot->text + pSnapshot->names[i], type);
+		}
+		PyVtk_ResetScratch();
+	}
+	benchmark.Record("refresh_each", "ns", (double) DURATION(TIME_NOW() - start) / rounds);
+
+	start = TIME_NOW();
+	for (int round = 0; round < rounds; ++round)
+	{
+		PyVtk_ReleaseSnapshot(PyVtk_SnapshotProperties(pIntrospector, created, std::vector<LPCSTR>()));
+	}
+	benchmark.Record("refresh_snapshot", "ns", (double) DURATION(TIME_NOW() - start) / rounds);
+
+	PyVtk_ReleaseSnapshot(pSnapshot);
+	for (vtkObjectBase *pVtkObject : created)
+	{
+		PyVtk_DeleteVtkObject(pIntrospector, pVtkObject);
+	}
+}
+
+
+/*
+ * Watching a 50 node pipeline for changes, by re-reading every property and
+ * through a subscription, while idle and after one property changed.
+ */
+void test_changes(
+	PyObject *pIntrospector,
+	PyObject *pVtkModule)
+{
+	const int objects = 50;
+	const int rounds = 20;
+
+	std::vector<vtkObjectBase *> created;
+	for (int i = 0; i < objects; ++i)
+	{
+		created.push_back(PyVtk_CreateVtkObject(pIntrospector, "vtkPointSource"));
+	}
+
+	PyVtk_Subscription *pSubscription = PyVtk_Subscribe(pIntrospector, created, std::vector<LPCSTR>());
+	PyVtk_Snapshot *pSnapshot = PyVtk_SnapshotProperties(pIntrospector, created, std::vector<LPCSTR>());
+	if (pSubscription == NULL || pSnapshot == NULL)
+	{
+		PyVtk_Unsubscribe(pSubscription);
+		PyVtk_ReleaseSnapshot(pSnapshot);
+		return;
+	}
+
+	time_var start = TIME_NOW();
+	for (int round = 0; round < rounds; ++round)
+	{
+		for (size_t i = 0; i < pSnapshot->count; ++i)
+		{
+			char type[2] = { pSnapshot->types[i], '\0' };
+			PyVtk_GetVtkObjectProperty(pIntrospector, created[pSnapshot->objects[i]], pSnapshot->text + pSnapshot->names[i], type);
+		}
+		PyVtk_ResetScratch();
+	}
+	benchmark.Record("watch_reread", "ns", (double) DURATION(TIME_NOW() - start) / rounds);
+
+	timed_execution_v("watch_poll_idle", PyVtk_PollChanges, pIntrospector, pSubscription);
+
+	PyVtk_Change change;
+	size_t changes = 0;
+	start = TIME_NOW();
+	for (int round = 0; round < rounds; ++round)
+	{
+		PyVtk_SetVtkObjectProperty(pIntrospector, created[round % objects], "Radius", "f", round % 2 != 0 ? "2.0" : "3.0");
+		PyVtk_PollChanges(pIntrospector, pSubscription);
+		while (PyVtk_NextChange(pSubscription, &change))
+		{
+			++changes;
+		}
+	}
+	benchmark.Record("watch_poll_one_change", "ns", (double) DURATION(TIME_NOW() - start) / rounds);
+	benchmark.Record("watch_changes", "count", (double) changes);
+
+	PyVtk_ReleaseSnapshot(pSnapshot);
+	PyVtk_Unsubscribe(pSubscription);
+	for (vtkObjectBase *pVtkObject : created)
+	{
+		PyVtk_DeleteVtkObject(pIntrospector, pVtkObject);
+	}
+}
+
+
+/*
+ * Per-call latency of properties and methods with a direct accessor, through
+ * the accessor and through the Python path.
+ */
+void test_fastpath(
+	PyObject *pIntrospector,
+	PyObject *pVtkModule)
+{
+	const int iterations = 1000;
+
+	vtkObjectBase *pSeeds = PyVtk_CreateVtkObject(pIntrospector, "vtkPointSource");
+	vtkObjectBase *pStreamer = PyVtk_CreateVtkObject(pIntrospector, "vtkStreamTracer");
+
+	for (bool fast : { true, false })
+	{
+		PyVtk_SetFastPath(fast);
+		std::string suffix = fast ? "_native" : "_python";
+
+		time_var start = TIME_NOW();
+		for (int i = 0; i < iterations; ++i)
+		{
+			PyVtk_SetVtkObjectProperty(pIntrospector, pSeeds, "Radius", "f", "3.0");
+		}
+		benchmark.Record(("seeds_setradius" + suffix).c_str(), "ns", (double) DURATION(TIME_NOW() - start) / iterations);
+
+		start = TIME_NOW();
+		for (int i = 0; i < iterations; ++i)
+		{
+			PyVtk_SetVtkObjectProperty(pIntrospector, pSeeds, "Center", "f3", "(1.0, 2.0, 3.0)");
+		}
+		benchmark.Record(("seeds_setcenter" + suffix).c_str(), "ns", (double) DURATION(TIME_NOW() - start) / iterations);
+
+		start = TIME_NOW();
+		for (int i = 0; i < iterations; ++i)
+		{
+			PyVtk_GetVtkObjectProperty(pIntrospector, pSeeds, "Center", "f3");
+			PyVtk_ResetScratch();
+		}
+		benchmark.Record(("seeds_getcenter" + suffix).c_str(), "ns", (double) DURATION(TIME_NOW() - start) / iterations);
+
+		start = TIME_NOW();
+		for (int i = 0; i < iterations; ++i)
+		{
+			Py_XDECREF(PyVtk_ObjectMethod(pIntrospector, pStreamer, "SetIntegrationDirectionToBoth", "",
+				std::vector<vtkObjectBase *>(), std::vector<LPCSTR>()));
+		}
+		benchmark.Record(("streamer_setintegdirboth" + suffix).c_str(), "ns", (double) DURATION(TIME_NOW() - start) / iterations);
+	}
+	PyVtk_SetFastPath(true);
+
+	PyVtk_DeleteVtkObject(pIntrospector, pStreamer);
+	PyVtk_DeleteVtkObject(pIntrospector, pSeeds);
+}
+
+
+/*
+ * Cost of the per-call counters: the same Python path calls with the allocation
+ * hook and the clocks enabled and disabled.
+ */
+void test_instrumentation(
+	PyObject *pIntrospector,
+	PyObject *pVtkModule)
+{
+	const int iterations = 1000;
+
+	vtkObjectBase *pSeeds = PyVtk_CreateVtkObject(pIntrospector, "vtkPointSource");
+	PyVtk_SetFastPath(false);
+
+	double elapsed[2];
+	for (bool instrumented : { true, false })
+	{
+		PyVtk_SetInstrumentation(instrumented);
+		std::string suffix = instrumented ? "_instrumented" : "_bare";
+
+		time_var start = TIME_NOW();
+		for (int i = 0; i < iterations; ++i)
+		{
+			PyVtk_SetVtkObjectProperty(pIntrospector, pSeeds, "Radius", "f", "3.0");
+			PyVtk_GetVtkObjectProperty(pIntrospector, pSeeds, "Radius", "f");
+			PyVtk_ResetScratch();
+		}
+		elapsed[instrumented ? 0 : 1] = (double) DURATION(TIME_NOW() - start) / iterations;
+		benchmark.Record(("seeds_getset" + suffix).c_str(), "ns", elapsed[instrumented ? 0 : 1]);
+	}
+	PyVtk_SetInstrumentation(true);
+	PyVtk_SetFastPath(true);
+
+	benchmark.Record("instrumentation_overhead", "ratio", elapsed[1] > 0 ? elapsed[0] / elapsed[1] : 0.0);
+
+	PyVtk_DeleteVtkObject(pIntrospector, pSeeds);
+}
+
+
+PyObject *inst_vtkobj(
+	PyObject *pVtkModule,
+	LPCSTR classname)
+{
+	/* Instantiates the class straight from the vtk module. Errors are left to the
+	   caller, which checks the result. */
+	PyObject *pVtkClass = PyObject_GetAttrString(pVtkModule, classname);
+	if (pVtkClass == NULL)
+	{
+		return NULL;
+	}
+
+	PyObject *pInstance = PyObject_CallObject(pVtkClass, NULL);
+	Py_DECREF(pVtkClass);
+	return pInstance;
+}
+
+
+void test_scratch(
+	PyObject *pIntrospector,
+	PyObject *pVtkModule)
+{
+	const int warmup = 100;
+	const int iterations = 1000;
+
+	/* The steady state of interest is the one of the Python path. */
+	PyVtk_SetFastPath(false);
+
+	vtkObjectBase *pSeeds = PyVtk_CreateVtkObject(pIntrospector, "vtkPointSource");
+
+	/* Letting the arena grow to the working set of the loop. */
+	for (int i = 0; i < warmup; ++i)
+	{
+		PyVtk_SetVtkObjectProperty(pIntrospector, pSeeds, "Radius", "f", "3.0");
+		PyVtk_GetVtkObjectProperty(pIntrospector, pSeeds, "Radius", "f");
+		PyVtk_ResetScratch();
+	}
+
+	size_t heapBefore = heap_allocations;
+	size_t chunksBefore = PyVtk_GetScratchStats().chunkAllocations;
+
+	time_var start = TIME_NOW();
+	for (int i = 0; i < iterations; ++i)
+	{
+		PyVtk_SetVtkObjectProperty(pIntrospector, pSeeds, "Radius", "f", "3.0");
+		PyVtk_GetVtkObjectProperty(pIntrospector, pSeeds, "Radius", "f");
+		PyVtk_ResetScratch();
+	}
+	double elapsed = (double) DURATION(TIME_NOW() - start);
+
+	benchmark.Record("steady_getset", "ns", elapsed / iterations);
+	benchmark.Record("steady_heap_allocations", "count", (double) (heap_allocations - heapBefore));
+	benchmark.Record("steady_scratch_chunk_allocations", "count", (double) (PyVtk_GetScratchStats().chunkAllocations - chunksBefore));
+
+	PyVtk_DeleteVtkObject(pIntrospector, pSeeds);
+	PyVtk_SetFastPath(true);
+}
+
+
+/*
+ * Streamlines over density.vtk from a sphere of seed points. The streamer reads
+ * the vector field from the reader and its seeds from pSeeds.
+ */
+static void create_streamlines(
+	PyObject *pIntrospector,
+	int points,
+	vtkObjectBase **ppReader,
+	vtkObjectBase **ppSeeds,
+	vtkObjectBase **ppStreamer)
+{
+	char count[32];
+	snprintf(count, sizeof(count), "%d", points);
+
+	vtkObjectBase
+		*pReader = PyVtk_CreateVtkObject(pIntrospector, "vtkStructuredGridReader"),
+		*pSeeds = PyVtk_CreateVtkObject(pIntrospector, "vtkPointSource"),
+		*pStreamer = PyVtk_CreateVtkObject(pIntrospector, "vtkStreamTracer");
+
+	PyVtk_SetVtkObjectProperty(pIntrospector, pReader, "FileName", "s", "density.vtk");
+	PyVtk_SetVtkObjectProperty(pIntrospector, pSeeds, "NumberOfPoints", "d", count);
+	PyVtk_ConnectVtkObject(pIntrospector, pReader, (vtkAlgorithm *)pStreamer);
+	Py_XDECREF(PyVtk_ObjectMethod( // pStreamer->SetSourceConnection(pSeeds->GetOutputPort(0))
+		pIntrospector,
+		pStreamer,
+		"SetSourceConnection",
+		"o",
+		std::vector<vtkObjectBase *>({ PyVtk_GetOutputPort(pIntrospector, pSeeds) }),
+		std::vector<LPCSTR>()));
+	PyVtk_SetVtkObjectProperty(pIntrospector, pStreamer, "InitialIntegrationStep", "f", "0.1");
+
+	*ppReader = pReader;
+	*ppSeeds = pSeeds;
+	*ppStreamer = pStreamer;
+}
+
+static void delete_streamlines(
+	PyObject *pIntrospector,
+	vtkObjectBase *pReader,
+	vtkObjectBase *pSeeds,
+	vtkObjectBase *pStreamer)
+{
+	PyVtk_DeleteVtkObject(pIntrospector, pStreamer);
+	PyVtk_DeleteVtkObject(pIntrospector, pSeeds);
+	PyVtk_DeleteVtkObject(pIntrospector, pReader);
+}
+
+
+/*
+ * One wavelet source feeding a row of contour filters, the sinks of which are
+ * returned in pContours.
+ */
+static vtkObjectBase *create_fanout(
+	PyObject *pIntrospector,
+	int branches,
+	std::vector<vtkObjectBase *> *pContours)
+{
+	vtkObjectBase *pSource = PyVtk_CreateVtkObject(pIntrospector, "vtkRTAnalyticSource");
+	PyVtk_SetVtkObjectProperty(pIntrospector, pSource, "WholeExtent", "d6", "-48,48,-48,48,-48,48");
+
+	for (int i = 0; i < branches; ++i)
+	{
+		char value[32];
+		snprintf(value, sizeof(value), "%d", 80 + 20 * i);
+
+		vtkObjectBase *pContour = PyVtk_CreateVtkObject(pIntrospector, "vtkContourFilter");
+		PyVtk_SetVtkObjectProperty(pIntrospector, pContour, "Value", "f", value);
+		PyVtk_ConnectVtkObjectPorts(pIntrospector, pSource, 0, (vtkAlgorithm *)pContour, 0, false);
+		pContours->push_back(pContour);
+	}
+
+	return pSource;
+}
+
+static void delete_fanout(
+	PyObject *pIntrospector,
+	vtkObjectBase *pSource,
+	const std::vector<vtkObjectBase *> &contours)
+{
+	for (vtkObjectBase *pContour : contours)
+	{
+		PyVtk_DeleteVtkObject(pIntrospector, pContour);
+	}
+	PyVtk_DeleteVtkObject(pIntrospector, pSource);
+}
+
+
+void test_sweep(
+	PyObject *pIntrospector,
+	PyObject *pVtkModule)
+{
+	const int points = 200;
+
+	vtkObjectBase *pReader, *pSeeds, *pStreamer;
+	create_streamlines(pIntrospector, 100, &pReader, &pSeeds, &pStreamer);
+	PyVtk_SetVtkObjectProperty(pIntrospector, pStreamer, "MaximumPropagation", "d", "100");
+
+	/* Seeds centred on the data, through a tuple property the clones have to carry. */
+	double center[3];
+	PyVtk_Result centerResult = { PYVTK_RESULT_DOUBLE, NULL, center, 3, 0, NULL, NULL, false, { NULL, 0, 0, 0 } };
+	Py_XDECREF(PyVtk_ObjectMethod(pIntrospector, pReader, "Update", "", std::vector<vtkObjectBase *>(), std::vector<LPCSTR>()));
+	PyVtk_PipedObjectMethodInto(pIntrospector, pReader,
+		std::vector<LPCSTR>({ "GetOutput", "GetCenter" }),
+		std::vector<LPCSTR>({ "", "" }),
+		std::vector<vtkObjectBase *>(),
+		std::vector<LPCSTR>(),
+		&centerResult);
+	PyVtk_SetVtkObjectPropertyValue(pIntrospector, pSeeds, "Center", &centerResult);
+
+	/* Seed radii, kept alive past the scratch resets of the sweep. */
+	std::vector<LPCSTR> radii;
+	for (int i = 0; i < points; ++i)
+	{
+		char radius[32];
+		snprintf(radius, sizeof(radius), "%f", 0.5 + 5.0 * i / points);
+		radii.push_back(PyVtk_RetainResult(radius));
+	}
+
+	/* Scaling from one thread up to the number of cores. */
+	size_t cores = std::max<unsigned>(1, std::thread::hardware_concurrency());
+	for (size_t threads = 1; threads <= cores; threads *= 2)
+	{
+		std::vector<vtkDataObject *> results;
+
+		char name[32];
+		snprintf(name, sizeof(name), "sweep_threads_%zu", threads);
+		timed_execution_v(name, PyVtk_SweepVtkObjectProperty,
+			pIntrospector, pSeeds, "Radius", "f", radii, pStreamer, threads, &results);
+
+		for (vtkDataObject *pResult : results)
+		{
+			if (pResult != NULL)
+			{
+				pResult->Delete();
+			}
+		}
+
+		/* Also covering the exact core count when it is not a power of two. */
+		if (threads < cores && threads * 2 > cores)
+		{
+			threads = cores / 2;
+		}
+	}
+
+	/* Checking the sweep against setting the radius and updating serially. The
+	   seed points are random, so the seed clouds themselves are compared: both
+	   are centred on Center within a small part of the radius. */
+	std::vector<vtkDataObject *> clouds;
+	PyVtk_SweepVtkObjectProperty(pIntrospector, pSeeds, "Radius", "f", radii, pSeeds, 0, &clouds);
+
+	size_t mismatches = 0;
+	for (size_t i = 0; i < radii.size(); ++i)
+	{
+		PyVtk_SetVtkObjectProperty(pIntrospector, pSeeds, "Radius", "f", radii[i]);
+		Py_XDECREF(PyVtk_ObjectMethod(pIntrospector, pSeeds, "Update", "", std::vector<vtkObjectBase *>(), std::vector<LPCSTR>()));
+
+		vtkDataSet *pSerial = vtkDataSet::SafeDownCast(((vtkAlgorithm *) pSeeds)->GetOutputDataObject(0));
+		vtkDataSet *pSwept = i < clouds.size() ? vtkDataSet::SafeDownCast(clouds[i]) : NULL;
+		if (pSerial == NULL || pSwept == NULL)
+		{
+			++mismatches;
+			continue;
+		}
+
+		double *serialCenter = pSerial->GetCenter();
+		double *sweptCenter = pSwept->GetCenter();
+		double distance = sqrt(
+			(serialCenter[0] - sweptCenter[0]) * (serialCenter[0] - sweptCenter[0]) +
+			(serialCenter[1] - sweptCenter[1]) * (serialCenter[1] - sweptCenter[1]) +
+			(serialCenter[2] - sweptCenter[2]) * (serialCenter[2] - sweptCenter[2]));
+		if (distance > 0.5 * atof(radii[i]))
+		{
+			++mismatches;
+		}
+	}
+	benchmark.Record("sweep_serial_mismatches", "count", (double) mismatches);
+
+	for (vtkDataObject *pCloud : clouds)
+	{
+		if (pCloud != NULL)
+		{
+			pCloud->Delete();
+		}
+	}
+
+	for (LPCSTR radius : radii)
+	{
+		PyVtk_ReleaseResult(radius);
+	}
+
+	delete_streamlines(pIntrospector, pReader, pSeeds, pStreamer);
+}
+
+/*
+ * Fan-out pipeline brought up to date by the scheduler on one thread and on all
+ * cores. Changing the source between rounds makes the whole graph dirty again.
+ */
+void test_fanout(
+	PyObject *pIntrospector,
+	PyObject *pVtkModule)
+{
+	const int branches = 8;
+	const int rounds = 5;
+
+	std::vector<vtkObjectBase *> contours;
+	vtkObjectBase *pSource = create_fanout(pIntrospector, branches, &contours);
+
+	size_t cores = std::max<unsigned>(1, std::thread::hardware_concurrency());
+	size_t threadCounts[] = { 1, cores };
+	bool flip = false;
+	for (size_t threads : threadCounts)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "fanout_threads_%zu", threads);
+		for (int round = 0; round < rounds; ++round)
+		{
+			flip = !flip;
+			PyVtk_SetVtkObjectProperty(pIntrospector, pSource, "Maximum", "f", flip ? "256" : "255");
+			timed_execution_v(name, PyVtk_UpdatePipeline, pIntrospector, contours, threads);
+		}
+
+		/* Nothing is dirty: only the graph walk is left. */
+		snprintf(name, sizeof(name), "fanout_clean_threads_%zu", threads);
+		timed_execution_v(name, PyVtk_UpdatePipeline, pIntrospector, contours, threads);
+	}
+
+	delete_fanout(pIntrospector, pSource, contours);
+}
+
+
+/*
+ * Sessions updating their own fan-out pipeline at the same time, each from its
+ * own thread and within a thread budget, for session counts and budgets in
+ * powers of two up to the number of cores. Each session is a separate
+ * Introspector. Reports the time per round and how many cores the executions
+ * kept busy on average.
+ */
+struct SessionPipeline
+{
+	PyObject *pIntrospector;
+	vtkObjectBase *pSource;
+	std::vector<vtkObjectBase *> contours;
+	bool flip;
+};
+
+/*
+ * Introspectors of the sessions beyond the benchmark's own. Created once, on
+ * the first run of test_sessions, and released with release_sessions.
+ */
+static std::vector<PyObject *> extraSessions;
+
+static void release_sessions()
+{
+	for (PyObject *pSession : extraSessions)
+	{
+		Py_DECREF(pSession);
+	}
+	extraSessions.clear();
+}
+
+void test_sessions(
+	PyObject *pIntrospector,
+	PyObject *pVtkModule)
+{
+	const int branches = 4;
+	const int rounds = 3;
+
+	size_t cores = std::max<unsigned>(1, std::thread::hardware_concurrency());
+	std::vector<size_t> counts;
+	for (size_t count = 1; count <= cores; count *= 2)
+	{
+		counts.push_back(count);
+	}
+
+	while (extraSessions.size() + 1 < counts.back())
+	{
+		extraSessions.push_back(PyVtk_InitIntrospector());
+	}
+
+	std::vector<SessionPipeline> sessions(counts.back());
+	for (size_t i = 0; i < sessions.size(); ++i)
+	{
+		SessionPipeline &session = sessions[i];
+		session.pIntrospector = i == 0 ? pIntrospector : extraSessions[i - 1];
+		session.pSource = create_fanout(session.pIntrospector, branches, &session.contours);
+		session.flip = false;
+	}
+
+	PyVtk_EntryStats before[64], after[64];
+	for (size_t sessionCount : counts)
+	{
+		for (size_t budget : counts)
+		{
+			for (size_t i = 0; i < sessionCount; ++i)
+			{
+				PyVtk_SetThreadBudget(sessions[i].pIntrospector, NULL, budget);
+			}
+
+			size_t entries = PyVtk_GetInstrumentation(before, 64);
+			time_var start = TIME_NOW();
+
+			/* The sessions take the GIL for their calls, which release it while VTK runs. */
+			PyThreadState *pThreadState = PyEval_SaveThread();
+			std::vector<std::thread> threads;
+			for (size_t i = 0; i < sessionCount; ++i)
+			{
+				threads.emplace_back([rounds](SessionPipeline *pSession)
+				{
+					for (int round = 0; round < rounds; ++round)
+					{
+						PyGILState_STATE gil = PyGILState_Ensure();
+						pSession->flip = !pSession->flip;
+						PyVtk_SetVtkObjectProperty(pSession->pIntrospector, pSession->pSource, "Maximum", "f", pSession->flip ? "256" : "255");
+						PyVtk_UpdatePipeline(pSession->pIntrospector, pSession->contours, 0);
+						PyGILState_Release(gil);
+					}
+				}, &sessions[i]);
+			}
+			for (auto &thread : threads)
+			{
+				thread.join();
+			}
+			PyEval_RestoreThread(pThreadState);
+
+			char name[48];
+			snprintf(name, sizeof(name), "sessions_%zu_budget_%zu", sessionCount, budget);
+			benchmark.Record(name, "ns", (double) DURATION(TIME_NOW() - start) / rounds);
+
+			PyVtk_GetInstrumentation(after, entries);
+			for (size_t e = 0; e < entries; ++e)
+			{
+				unsigned long long vtk = after[e].vtk.sum - before[e].vtk.sum;
+				if (strcmp(after[e].name, "PyVtk_UpdatePipeline/node") == 0 && vtk > 0)
+				{
+					snprintf(name, sizeof(name), "sessions_%zu_budget_%zu_cores_busy", sessionCount, budget);
+					benchmark.Record(name, "ratio", (double) (after[e].vtkCpu - before[e].vtkCpu) / vtk);
+				}
+			}
+		}
+	}
+
+	for (size_t i = 0; i < sessions.size(); ++i)
+	{
+		PyVtk_SetThreadBudget(sessions[i].pIntrospector, NULL, 0);
+		delete_fanout(sessions[i].pIntrospector, sessions[i].pSource, sessions[i].contours);
+	}
+}
+
+
+/*
+ * Streamlines from 1000 seeds computed in one Update, and progressively in
+ * chunks on all cores. Reports when the first chunk arrives next to the time
+ * of the whole computation.
+ */
+struct ProgressiveTiming
+{
+	time_var start;
+	unsigned long long firstChunk;
+};
+
+static bool on_chunk(
+	void *pContext,
+	vtkDataObject *pChunk,
+	size_t done,
+	size_t total)
+{
+	ProgressiveTiming *pTiming = (ProgressiveTiming *) pContext;
+	if (done == 1)
+	{
+		pTiming->firstChunk = DURATION(TIME_NOW() - pTiming->start);
+	}
+	return true;
+}
+
+void test_progressive(
+	PyObject *pIntrospector,
+	PyObject *pVtkModule)
+{
+	const int rounds = 3;
+
+	vtkObjectBase *pReader, *pSeeds, *pStreamer;
+	create_streamlines(pIntrospector, 1000, &pReader, &pSeeds, &pStreamer);
+	PyVtk_SetVtkObjectProperty(pIntrospector, pSeeds, "Radius", "f", "3.0");
+	PyVtk_SetVtkObjectProperty(pIntrospector, pStreamer, "MaximumPropagation", "d", "100");
+	Py_XDECREF(PyVtk_ObjectMethod( // pStreamer->SetIntegrationDirectionToBoth()
+		pIntrospector,
+		pStreamer,
+		"SetIntegrationDirectionToBoth",
+		"",
+		std::vector<vtkObjectBase *>(),
+		std::vector<LPCSTR>()));
+
+	/* The inputs are read once, outside of the measurements. */
+	PyVtk_UpdatePipeline(pIntrospector, std::vector<vtkObjectBase *>({ pReader, pSeeds }), 1);
+
+	for (int round = 0; round < rounds; ++round)
+	{
+		Py_XDECREF(PyVtk_ObjectMethod(pIntrospector, pStreamer, "Modified", "", std::vector<vtkObjectBase *>(), std::vector<LPCSTR>()));
+		timed_execution_o("progressive_full_update", PyVtk_ObjectMethod, // pStreamer->Update()
+			pIntrospector,
+			pStreamer,
+			"Update",
+			"",
+			std::vector<vtkObjectBase *>(),
+			std::vector<LPCSTR>());
+
+		ProgressiveTiming timing;
+		timing.firstChunk = 0;
+		timing.start = TIME_NOW();
+
+		vtkDataObject *pResult = NULL;
+		PyVtk_ProgressiveUpdate(pIntrospector, pStreamer, 0, 0, on_chunk, &timing, &pResult);
+		benchmark.Record("progressive_total", "ns", (double) DURATION(TIME_NOW() - timing.start));
+		benchmark.Record("progressive_first_chunk", "ns", (double) timing.firstChunk);
+
+		if (pResult != NULL)
+		{
+			pResult->Delete();
+		}
+	}
+
+	delete_streamlines(pIntrospector, pReader, pSeeds, pStreamer);
+}
+
+
+/*
+ * Streamlines over density.vtk tweaked in preview mode, at a stride of 4, next to
+ * the same tweak at full resolution. Also reports how long the full result takes
+ * to arrive once the tweaks stop.
+ */
+void test_preview(
+	PyObject *pIntrospector,
+	PyObject *pVtkModule)
+{
+	const int tweaks = 5;
+
+	vtkObjectBase *pReader, *pSeeds, *pStreamer;
+	create_streamlines(pIntrospector, 400, &pReader, &pSeeds, &pStreamer);
+	PyVtk_SetVtkObjectProperty(pIntrospector, pSeeds, "Radius", "f", "3.0");
+
+	PyVtk_PreviewOptions options = { 4, 0, 0, 50 };
+	for (bool preview : { false, true })
+	{
+		PyVtk_SetPreview(pIntrospector, pStreamer, preview ? &options : NULL);
+		LPCSTR name = preview ? "preview_tweak" : "full_tweak";
+		for (int tweak = 0; tweak < tweaks; ++tweak)
+		{
+			char propagation[32];
+			snprintf(propagation, sizeof(propagation), "%d", 50 + 10 * tweak);
+			PyVtk_SetVtkObjectProperty(pIntrospector, pStreamer, "MaximumPropagation", "f", propagation);
+			timed_execution_v(name, PyVtk_UpdatePipeline, pIntrospector, std::vector<vtkObjectBase *>({ pStreamer }), 1);
+		}
+	}
+
+	/* The full result is computed by the first poll after the settle time. */
+	time_var start = TIME_NOW();
+	while (PyVtk_PollPreviews(pIntrospector) == 0 && PyVtk_IsPreview(pStreamer))
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	benchmark.Record("preview_settle_to_full", "ns", (double) DURATION(TIME_NOW() - start));
+
+	PyVtk_SetPreview(pIntrospector, pStreamer, NULL);
+	delete_streamlines(pIntrospector, pReader, pSeeds, pStreamer);
+}
+
+
+/*
+ * Streamlines written in the columnar format and with VTK's XML writer, both
+ * uncompressed and in binary, from the same up to date output.
+ */
+void test_export(
+	PyObject *pIntrospector,
+	PyObject *pVtkModule)
+{
+	vtkObjectBase *pReader, *pSeeds, *pStreamer;
+	create_streamlines(pIntrospector, 1000, &pReader, &pSeeds, &pStreamer);
+	PyVtk_SetVtkObjectProperty(pIntrospector, pSeeds, "Radius", "f", "3.0");
+	PyVtk_SetVtkObjectProperty(pIntrospector, pStreamer, "MaximumPropagation", "d", "100");
+	PyVtk_UpdatePipeline(pIntrospector, std::vector<vtkObjectBase *>({ pStreamer }), 0);
+
+	timed_execution_v("export_columns", PyVtk_ExportColumns, pIntrospector, pStreamer, "benchmark_export.pvc");
+
+	vtkXMLPolyDataWriter *pWriter = vtkXMLPolyDataWriter::New();
+	pWriter->SetInputData(((vtkAlgorithm *)pStreamer)->GetOutputDataObject(0));
+	pWriter->SetFileName("benchmark_export.vtp");
+	pWriter->SetCompressorTypeToNone();
+	pWriter->SetDataModeToAppended();
+	pWriter->EncodeAppendedDataOff();
+
+	time_var start = TIME_NOW();
+	pWriter->Write();
+	benchmark.Record("export_xml_appended", "ns", (double) DURATION(TIME_NOW() - start));
+
+	pWriter->SetDataModeToBinary();
+	start = TIME_NOW();
+	pWriter->Write();
+	benchmark.Record("export_xml_binary", "ns", (double) DURATION(TIME_NOW() - start));
+	pWriter->Delete();
+
+	remove("benchmark_export.pvc");
+	remove("benchmark_export.vtp");
+
+	delete_streamlines(pIntrospector, pReader, pSeeds, pStreamer);
+}
+
+
+/*
+ * Class lookups through the index, as when completing a class name being typed
+ * one character at a time.
+ */
+void test_classes(
+	PyObject *pIntrospector,
+	PyObject *pVtkModule)
+{
+	LPCSTR *names;
+	LPCSTR typed = "vtkStreamTracer";
+	char prefix[32];
+	for (size_t length = 1; length <= strlen(typed); ++length)
+	{
+		snprintf(prefix, sizeof(prefix), "%.*s", (int) length, typed);
+		timed_execution<long>("classes_prefix_typing", PyVtk_FindVtkClasses, pIntrospector, prefix, PYVTK_CLASS_PREFIX, (size_t) 20, &names);
+	}
+
+	timed_execution<long>("classes_substring", PyVtk_FindVtkClasses, pIntrospector, "Stream", PYVTK_CLASS_SUBSTRING, (size_t) 0, &names);
+	timed_execution<long>("classes_property", PyVtk_FindVtkClasses, pIntrospector, "Radius", PYVTK_CLASS_PROPERTY, (size_t) 0, &names);
+	PyVtk_ResetScratch();
+}
+
+
+/*
+ * Pipeline corpus. Every pipeline is described once as a list of steps and is
+ * run through the introspection layer, through direct calls on the vtk Python
+ * module and, as the classes are known here, through direct C++ calls. Values
+ * may refer to the size the pipeline is run at as {n}, so the same description
+ * is swept over inputs of growing size.
+ */
+enum CorpusStepKind
+{
+	CORPUS_CREATE,
+	CORPUS_SET,
+	CORPUS_CALL,
+	CORPUS_CONNECT,
+	CORPUS_UPDATE
+};
+
+struct CorpusStep
+{
+	CorpusStepKind kind;
+	LPCSTR label;
+	int object;
+	int source; // upstream object of a connection
+	int port; // input port of a connection
+	LPCSTR name; // class, property or method
+	LPCSTR format;
+	LPCSTR value; // comma separated for tuples and multiple arguments
+	vtkObjectBase *(*nativeNew)();
+	void (*nativeCall)(vtkObjectBase *pObject, LPCSTR value);
+};
+
+struct CorpusPipeline
+{
+	LPCSTR name;
+	std::vector<int> sizes;
+	std::vector<CorpusStep> steps;
+};
+
+#define CORPUS_NEW(label, object, CLASS) \
+	{ CORPUS_CREATE, label, object, -1, 0, #CLASS, "", "", []() -> vtkObjectBase * { return CLASS::New(); }, NULL }
+#define CORPUS_SET(label, object, CLASS, PROPERTY, format, value, PARSE) \
+	{ CORPUS_SET, label, object, -1, 0, #PROPERTY, format, value, NULL, \
+		[](vtkObjectBase *pObject, LPCSTR v) { static_cast<CLASS *>(pObject)->Set##PROPERTY(PARSE(v)); } }
+#define CORPUS_CONNECT(label, object, source, port) \
+	{ CORPUS_CONNECT, label, object, source, port, "SetInputConnection", "", "", NULL, NULL }
+#define CORPUS_UPDATE(label, object) \
+	{ CORPUS_UPDATE, label, object, -1, 0, "Update", "", "", NULL, NULL }
+
+static const std::vector<CorpusPipeline> corpus = {
+	{ "sphere_elevation", { 8, 32, 128, 512 }, {
+		CORPUS_NEW("sphere_inst", 0, vtkSphereSource),
+		CORPUS_SET("sphere_settheta", 0, vtkSphereSource, ThetaResolution, "d", "{n}", atoi),
+		CORPUS_SET("sphere_setphi", 0, vtkSphereSource, PhiResolution, "d", "{n}", atoi),
+		CORPUS_NEW("elevation_inst", 1, vtkElevationFilter),
+		CORPUS_CONNECT("elevation_setinputconn", 1, 0, 0),
+		CORPUS_UPDATE("elevation_update", 1) } },
+	{ "wavelet_contour", { 8, 16, 32, 64 }, {
+		CORPUS_NEW("wavelet_inst", 0, vtkRTAnalyticSource),
+		{ CORPUS_SET, "wavelet_setextent", 0, -1, 0, "WholeExtent", "d6", "-{n},{n},-{n},{n},-{n},{n}", NULL,
+			[](vtkObjectBase *pObject, LPCSTR v) { int n = atoi(v + 1); static_cast<vtkRTAnalyticSource *>(pObject)->SetWholeExtent(-n, n, -n, n, -n, n); } },
+		CORPUS_NEW("contour_inst", 1, vtkContourFilter),
+		{ CORPUS_CALL, "contour_setvalue", 1, -1, 0, "SetValue", "df", "0,150", NULL,
+			[](vtkObjectBase *pObject, LPCSTR v) { static_cast<vtkContourFilter *>(pObject)->SetValue(0, 150.0); } },
+		CORPUS_CONNECT("contour_setinputconn", 1, 0, 0),
+		CORPUS_UPDATE("contour_update", 1) } },
+	{ "points_elevation", { 1000, 10000, 100000, 1000000 }, {
+		CORPUS_NEW("points_inst", 0, vtkPointSource),
+		CORPUS_SET("points_setnumberofpoints", 0, vtkPointSource, NumberOfPoints, "d", "{n}", atoi),
+		CORPUS_NEW("elevation_inst", 1, vtkElevationFilter),
+		CORPUS_CONNECT("elevation_setinputconn", 1, 0, 0),
+		CORPUS_UPDATE("elevation_update", 1) } },
+	{ "reader_streamlines", { 10, 100, 1000 }, {
+		CORPUS_NEW("reader_inst", 0, vtkStructuredGridReader),
+		CORPUS_SET("reader_setfile", 0, vtkStructuredGridReader, FileName, "s", "density.vtk", (LPCSTR)),
+		CORPUS_NEW("seeds_inst", 1, vtkPointSource),
+		CORPUS_SET("seeds_setradius", 1, vtkPointSource, Radius, "f", "3.0", atof),
+		CORPUS_SET("seeds_setnumberofpoints", 1, vtkPointSource, NumberOfPoints, "d", "{n}", atoi),
+		CORPUS_NEW("streamer_inst", 2, vtkStreamTracer),
+		CORPUS_CONNECT("streamer_setinputconn_reader", 2, 0, 0),
+		CORPUS_CONNECT("streamer_setsourceconn_seeds", 2, 1, 1),
+		CORPUS_SET("streamer_setmaxpropagation", 2, vtkStreamTracer, MaximumPropagation, "f", "100", atof),
+		CORPUS_UPDATE("streamer_update", 2) } }
+};
+
+
+static std::string corpus_value(
+	LPCSTR value,
+	int size)
+{
+	std::string expanded(value);
+	std::string number = std::to_string(size);
+	for (size_t pos = expanded.find("{n}"); pos != std::string::npos; pos = expanded.find("{n}", pos))
+	{
+		expanded.replace(pos, 3, number);
+	}
+	return expanded;
+}
+
+static size_t corpus_argc(
+	LPCSTR format)
+{
+	size_t argc = 0;
+	for (LPCSTR c = format; *c != '\0'; ++c)
+	{
+		argc += isalpha((unsigned char) *c) ? 1 : 0;
+	}
+	return argc;
+}
+
+static void corpus_record(
+	const CorpusPipeline &pipeline,
+	int size,
+	LPCSTR label,
+	LPCSTR path,
+	time_var start)
+{
+	double elapsed = (double) DURATION(TIME_NOW() - start);
+	std::string operation = std::string(pipeline.name) + "@" + std::to_string(size) + "/" + label + "/" + path;
+	benchmark.Record(operation.c_str(), "ns", elapsed);
+}
+
+
+static void corpus_introspection(
+	PyObject *pIntrospector,
+	const CorpusPipeline &pipeline,
+	int size)
+{
+	std::vector<vtkObjectBase *> objects(pipeline.steps.size(), NULL);
+
+	/* The introspection path is the Python one the overheads are taken against. */
+	PyVtk_SetFastPath(false);
+
+	for (const CorpusStep &step : pipeline.steps)
+	{
+		std::string value = corpus_value(step.value, size);
+		LPCSTR *pTokens = NULL;
+		size_t tokens = step.kind == CORPUS_CALL ? split(value.c_str(), ',', &pTokens) : 0;
+
+		time_var start = TIME_NOW();
+		switch (step.kind)
+		{
+		case CORPUS_CREATE:
+			objects[step.object] = PyVtk_CreateVtkObject(pIntrospector, step.name);
+			break;
+		case CORPUS_SET:
+			PyVtk_SetVtkObjectProperty(pIntrospector, objects[step.object], step.name, step.format, value.c_str());
+			break;
+		case CORPUS_CALL:
+			Py_XDECREF(PyVtk_ObjectMethod(pIntrospector, objects[step.object], step.name, step.format,
+				std::vector<vtkObjectBase *>(), std::vector<LPCSTR>(pTokens, pTokens + tokens)));
+			break;
+		case CORPUS_CONNECT:
+			if (step.port == 0)
+			{
+				PyVtk_ConnectVtkObject(pIntrospector, objects[step.source], (vtkAlgorithm *) objects[step.object]);
+			}
+			else
+			{
+				char port[16];
+				snprintf(port, sizeof(port), "%d", step.port);
+				Py_XDECREF(PyVtk_ObjectMethod(pIntrospector, objects[step.object], step.name, "do",
+					std::vector<vtkObjectBase *>({ PyVtk_GetOutputPort(pIntrospector, objects[step.source]) }),
+					std::vector<LPCSTR>({ port })));
+			}
+			break;
+		case CORPUS_UPDATE:
+			Py_XDECREF(PyVtk_ObjectMethod(pIntrospector, objects[step.object], step.name, "",
+				std::vector<vtkObjectBase *>(), std::vector<LPCSTR>()));
+			break;
+		}
+		corpus_record(pipeline, size, step.label, "introspection", start);
+	}
+
+	time_var start = TIME_NOW();
+	for (auto iObject = objects.rbegin(); iObject != objects.rend(); ++iObject)
+	{
+		if (*iObject != NULL)
+		{
+			PyVtk_DeleteVtkObject(pIntrospector, *iObject);
+		}
+	}
+	corpus_record(pipeline, size, "teardown", "introspection", start);
+
+	PyVtk_SetFastPath(true);
+}
+
+
+static void corpus_python(
+	PyObject *pVtkModule,
+	const CorpusPipeline &pipeline,
+	int size)
+{
+	std::vector<PyObject *> objects(pipeline.steps.size(), NULL);
+
+	for (const CorpusStep &step : pipeline.steps)
+	{
+		/* Arguments are built beforehand, as a Python caller would already hold them. */
+		PyObject *pArgs = NULL;
+		std::string method(step.kind == CORPUS_SET ? "Set" : "");
+		method += step.name;
+		if (step.kind == CORPUS_SET || step.kind == CORPUS_CALL)
+		{
+			std::string value = corpus_value(step.value, size);
+			LPCSTR *pTokens = NULL;
+			size_t tokens = split(value.c_str(), ',', &pTokens);
+			pArgs = PyVtk_ArgvTuple(step.format, corpus_argc(step.format), NULL, 0, pTokens, tokens);
+		}
+
+		time_var start = TIME_NOW();
+		PyObject *pResult = NULL;
+		switch (step.kind)
+		{
+		case CORPUS_CREATE:
+			objects[step.object] = inst_vtkobj(pVtkModule, step.name);
+			break;
+		case CORPUS_SET:
+		case CORPUS_CALL:
+			if (objects[step.object] != NULL && pArgs != NULL)
+			{
+				PyObject *pMethod = PyObject_GetAttrString(objects[step.object], method.c_str());
+				if (pMethod != NULL)
+				{
+					pResult = PyObject_Call(pMethod, pArgs, NULL);
+					Py_DECREF(pMethod);
+				}
+			}
+			break;
+		case CORPUS_CONNECT:
+			if (objects[step.object] != NULL && objects[step.source] != NULL)
+			{
+				PyObject *pPort = PyObject_CallMethod(objects[step.source], "GetOutputPort", "");
+				if (pPort != NULL)
+				{
+					pResult = PyObject_CallMethod(objects[step.object], step.name, "iO", step.port, pPort);
+					Py_DECREF(pPort);
+				}
+			}
+			break;
+		case CORPUS_UPDATE:
+			if (objects[step.object] != NULL)
+			{
+				pResult = PyObject_CallMethod(objects[step.object], step.name, "");
+			}
+			break;
+		}
+		corpus_record(pipeline, size, step.label, "python", start);
+
+		Py_XDECREF(pResult);
+		Py_XDECREF(pArgs);
+		if (PyErr_Occurred())
+		{
+			PyErr_Clear();
+		}
+	}
+
+	time_var start = TIME_NOW();
+	for (auto iObject = objects.rbegin(); iObject != objects.rend(); ++iObject)
+	{
+		Py_XDECREF(*iObject);
+	}
+	corpus_record(pipeline, size, "teardown", "python", start);
+}
+
+
+static void corpus_native(
+	const CorpusPipeline &pipeline,
+	int size)
+{
+	std::vector<vtkObjectBase *> objects(pipeline.steps.size(), NULL);
+
+	for (const CorpusStep &step : pipeline.steps)
+	{
+		std::string value = corpus_value(step.value, size);
+
+		time_var start = TIME_NOW();
+		switch (step.kind)
+		{
+		case CORPUS_CREATE:
+			objects[step.object] = step.nativeNew();
+			break;
+		case CORPUS_SET:
+		case CORPUS_CALL:
+			step.nativeCall(objects[step.object], value.c_str());
+			break;
+		case CORPUS_CONNECT:
+			static_cast<vtkAlgorithm *>(objects[step.object])->SetInputConnection(step.port,
+				static_cast<vtkAlgorithm *>(objects[step.source])->GetOutputPort());
+			break;
+		case CORPUS_UPDATE:
+			static_cast<vtkAlgorithm *>(objects[step.object])->Update();
+			break;
+		}
+		corpus_record(pipeline, size, step.label, "native", start);
+	}
+
+	time_var start = TIME_NOW();
+	for (auto iObject = objects.rbegin(); iObject != objects.rend(); ++iObject)
+	{
+		if (*iObject != NULL)
+		{
+			(*iObject)->Delete();
+		}
+	}
+	corpus_record(pipeline, size, "teardown", "native", start);
+}
+
+
+void test_corpus(
+	PyObject *pIntrospector,
+	PyObject *pVtkModule)
+{
+	for (const CorpusPipeline &pipeline : corpus)
+	{
+		for (int size : pipeline.sizes)
+		{
+			corpus_introspection(pIntrospector, pipeline, size);
+			if (pVtkModule != NULL)
+			{
+				corpus_python(pVtkModule, pipeline, size);
+			}
+			corpus_native(pipeline, size);
+			PyVtk_ResetScratch();
+		}
+	}
+}
+
+/*
+ * Overhead of each path against the ones below it, as the ratio of the medians
+ * of the same step. Recorded as the corpus_overhead case once the repetitions
+ * are done.
+ */
+static void corpus_overhead()
+{
+	static LPCSTR const paths[][2] = {
+		{ "introspection", "python" },
+		{ "introspection", "native" },
+		{ "python", "native" }
+	};
+
+	benchmark.SetCase("corpus_overhead");
+	std::vector<BenchmarkSeries> series(benchmark.Series());
+	for (const BenchmarkSeries &data : series)
+	{
+		LPCSTR suffix = "/introspection";
+		size_t prefix = data.operation.size() - strlen(suffix);
+		if (data.caseName != "corpus" || data.operation.size() <= strlen(suffix)
+			|| data.operation.compare(prefix, std::string::npos, suffix) != 0)
+		{
+			continue;
+		}
+
+		std::string step = data.operation.substr(0, prefix);
+		for (const auto &pair : paths)
+		{
+			const BenchmarkSeries *pSlow = benchmark.Find("corpus", step + "/" + pair[0]);
+			const BenchmarkSeries *pFast = benchmark.Find("corpus", step + "/" + pair[1]);
+			if (pSlow == NULL || pFast == NULL)
+			{
+				continue;
+			}
+
+			double fast = Benchmark::Summarize(*pFast).median;
+			if (fast > 0.0)
+			{
+				std::string operation = step + "/" + pair[0] + "_vs_" + pair[1];
+				benchmark.Record(operation.c_str(), "ratio", Benchmark::Summarize(*pSlow).median / fast);
+			}
+		}
+	}
+}
+
+
+struct BenchmarkCase
+{
+	LPCSTR name;
+	void (*run)(PyObject *pIntrospector, PyObject *pVtkModule);
+};
+
+static const BenchmarkCase cases[] = {
+	{ "introspection", test_introspection },
+	{ "scratch", test_scratch },
+	{ "sweep", test_sweep },
+	{ "fanout", test_fanout },
+	{ "sessions", test_sessions },
+	{ "progressive", test_progressive },
+	{ "preview", test_preview },
+	{ "export", test_export },
+	{ "classes", test_classes },
+	{ "pool", test_pool },
+	{ "fastpath", test_fastpath },
+	{ "instrumentation", test_instrumentation },
+	{ "snapshot", test_snapshot },
+	{ "changes", test_changes },
+	{ "teardown", test_teardown },
+	{ "corpus", test_corpus }
+};
+
+
+/*
+ * Reports. Both formats carry the same fields per operation; the CSV one is also
+ * the format baselines are read from.
+ */
+static void write_csv(
+	std::ostream &out)
+{
+	out << "case,operation,unit,samples,min,median,p95,p99,mean\n";
+	for (const BenchmarkSeries &data : benchmark.Series())
+	{
+		BenchmarkSummary summary = Benchmark::Summarize(data);
+		out << data.caseName << ',' << data.operation << ',' << data.unit << ','
+			<< data.samples.size() << ',' << summary.min << ',' << summary.median << ','
+			<< summary.p95 << ',' << summary.p99 << ',' << summary.mean << '\n';
+	}
+}
+
+static void write_json(
+	std::ostream &out,
+	int warmup,
+	int repetitions)
+{
+	out << "{\n\t\"schema\": 1,\n\t\"warmup\": " << warmup << ",\n\t\"repetitions\": " << repetitions << ",\n\t\"results\": [";
+	bool first = true;
+	for (const BenchmarkSeries &data : benchmark.Series())
+	{
+		BenchmarkSummary summary = Benchmark::Summarize(data);
+		out << (first ? "\n" : ",\n")
+			<< "\t\t{ \"case\": \"" << data.caseName << "\", \"operation\": \"" << data.operation
+			<< "\", \"unit\": \"" << data.unit << "\", \"samples\": " << data.samples.size()
+			<< ", \"min\": " << summary.min << ", \"median\": " << summary.median
+			<< ", \"p95\": " << summary.p95 << ", \"p99\": " << summary.p99
+			<< ", \"mean\": " << summary.mean << " }";
+		first = false;
+	}
+	out << "\n\t]\n}\n";
+}
+
+/*
+ * Compares the medians against a report written earlier with --format csv. An
+ * operation regresses when its median grew by more than the threshold; the ones
+ * missing on either side are skipped.
+ */
+static int compare_baseline(
+	LPCSTR path,
+	double threshold)
+{
+	std::ifstream in(path);
+	if (!in.good())
+	{
+		fprintf(stderr, "Cannot read baseline \"%s\"\n", path);
+		return -1;
+	}
+
+	std::unordered_map<std::string, double> baseline;
+	std::string line;
+	std::getline(in, line); // header
+	while (std::getline(in, line))
+	{
+		std::vector<std::string> fields;
+		std::stringstream row(line);
+		std::string field;
+		while (std::getline(row, field, ','))
+		{
+			fields.push_back(field);
+		}
+		if (fields.size() == 9)
+		{
+			baseline[fields[0] + "/" + fields[1]] = atof(fields[5].c_str());
+		}
+	}
+
+	int regressions = 0;
+	for (const BenchmarkSeries &data : benchmark.Series())
+	{
+		auto iBaseline = baseline.find(data.caseName + "/" + data.operation);
+		if (iBaseline == baseline.end())
+		{
+			continue;
+		}
+
+		double median = Benchmark::Summarize(data).median;
+		double reference = iBaseline->second;
+		bool regressed = median > reference * (1.0 + threshold);
+		fprintf(stderr, "%-10s %-40s %14.1f %14.1f %+7.1f%%%s\n",
+			data.caseName.c_str(), data.operation.c_str(), reference, median,
+			reference > 0.0 ? 100.0 * (median - reference) / reference : 0.0,
+			regressed ? "  REGRESSION" : "");
+		if (regressed)
+		{
+			++regressions;
+		}
+	}
+
+	return regressions;
+}
+
+
+static void usage(
+	LPCSTR program)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  --case NAME         run only this case, may be repeated (default: all)\n"
+		"  --list              list the cases and exit\n"
+		"  --warmup N          unrecorded repetitions per case (default: 3)\n"
+		"  --repetitions N     recorded repetitions per case (default: 20)\n"
+		"  --format csv|json   report format (default: csv)\n"
+		"  --output PATH       write the report to PATH instead of stdout\n"
+		"  --baseline PATH     compare medians against a CSV report\n"
+		"  --threshold F       relative slowdown counted as a regression (default: 0.10)\n"
+		"  --trace PATH        write a Chrome trace of the last events of the cases to PATH\n"
+		"  --lazy              import only the VTK modules of the classes created\n"
+		"  --class-modules P   class map used by --lazy (default: classModules.json)\n",
+		program);
+}
+
+
+int main(int argc, char *argv[])
+{
+	std::vector<LPCSTR> selected;
+	int warmup = 3;
+	int repetitions = 20;
+	LPCSTR format = "csv";
+	LPCSTR output = NULL;
+	LPCSTR baselinePath = NULL;
+	double threshold = 0.10;
+	LPCSTR tracePath = NULL;
+	PyVtk_InitOptions options = { false, NULL };
+
+	for (int i = 1; i < argc; ++i)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--case") == 0 && hasValue)
+		{
+			selected.push_back(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--warmup") == 0 && hasValue)
+		{
+			warmup = std::max(0, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--repetitions") == 0 && hasValue)
+		{
+			repetitions = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--format") == 0 && hasValue)
+		{
+			format = argv[++i];
+		}
+		else if (strcmp(argv[i], "--output") == 0 && hasValue)
+		{
+			output = argv[++i];
+		}
+		else if (strcmp(argv[i], "--baseline") == 0 && hasValue)
+		{
+			baselinePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--threshold") == 0 && hasValue)
+		{
+			threshold = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--trace") == 0 && hasValue)
+		{
+			tracePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--lazy") == 0)
+		{
+			options.lazyImports = true;
+		}
+		else if (strcmp(argv[i], "--class-modules") == 0 && hasValue)
+		{
+			options.classModules = argv[++i];
+		}
+		else if (strcmp(argv[i], "--list") == 0)
+		{
+			for (const BenchmarkCase &benchmarkCase : cases)
+			{
+				printf("%s\n", benchmarkCase.name);
+			}
+			return 0;
+		}
+		else
+		{
+			usage(argv[0]);
+			return 2;
+		}
+	}
+
+	if (strcmp(format, "csv") != 0 && strcmp(format, "json") != 0)
+	{
+		usage(argv[0]);
+		return 2;
+	}
+
+	for (LPCSTR name : selected)
+	{
+		bool known = false;
+		for (const BenchmarkCase &benchmarkCase : cases)
+		{
+			known = known || strcmp(benchmarkCase.name, name) == 0;
+		}
+		if (!known)
+		{
+			fprintf(stderr, "Unknown case \"%s\"\n", name);
+			return 2;
+		}
+	}
+
+	/* One interpreter for the whole process; it cannot be reliably restarted once
+	   the VTK modules have been loaded, so its setup and teardown are sampled once.
+	   Lazy imports are sampled by another run, under a case of their own. */
+	LPCSTR processCase = options.lazyImports ? "process_lazy" : "process";
+	benchmark.SetCase(processCase);
+	size_t residentBefore = resident_bytes();
+	PyObject *pIntrospector = timed_execution<PyObject *>("interpreter_init", PyVtk_InitIntrospectorWithOptions, &options);
+	if (pIntrospector == NULL)
+	{
+		fprintf(stderr, "Initialization failed\n");
+		return 2;
+	}
+	benchmark.Record("interpreter_init_rss", "bytes", (double) (resident_bytes() - residentBefore));
+
+	/* Share of the imports in the initialization, to compare builds with and without
+	   frozen modules, which is reported next to it. */
+	PyVtk_InitStats initStats = PyVtk_GetInitStats();
+	unsigned long long initTotal = initStats.initialize + initStats.paths + initStats.imports + initStats.instantiate;
+	benchmark.Record("interpreter_init_imports", "ns", (double) initStats.imports);
+	benchmark.Record("interpreter_init_import_share", "ratio", initTotal > 0 ? (double) initStats.imports / initTotal : 0.0);
+	benchmark.Record("interpreter_init_frozen", "flag", initStats.frozenModules ? 1.0 : 0.0);
+	PyObject *pVtkModule = timed_execution<PyObject *>("vtk_import", PyImport_ImportModule, "vtk");
+	if (pVtkModule == NULL)
+	{
+		PyErr_Clear();
+	}
+
+	if (tracePath != NULL)
+	{
+		PyVtk_StartTrace(1 << 20);
+	}
+
+	for (const BenchmarkCase &benchmarkCase : cases)
+	{
+		bool run = selected.empty();
+		for (LPCSTR name : selected)
+		{
+			run = run || strcmp(benchmarkCase.name, name) == 0;
+		}
+		if (!run)
+		{
+			continue;
+		}
+
+		benchmark.SetCase(benchmarkCase.name);
+		for (int i = 0; i < warmup + repetitions; ++i)
+		{
+			benchmark.SetRecording(i >= warmup);
+			benchmarkCase.run(pIntrospector, pVtkModule);
+			PyVtk_ResetScratch();
+		}
+	}
+
+	if (tracePath != NULL)
+	{
+		PyVtk_StopTrace();
+		PyVtk_FlushTrace(tracePath);
+	}
+
+	benchmark.SetRecording(true);
+	corpus_overhead();
+	release_sessions();
+
+	benchmark.SetCase(processCase);
+	Py_XDECREF(pVtkModule);
+	timed_execution_v("interpreter_fin", PyVtk_FinalizeIntrospector, pIntrospector);
+
+	std::ofstream file;
+	if (output != NULL)
+	{
+		file.open(output, std::ofstream::out | std::ofstream::trunc);
+		if (!file.good())
+		{
+			fprintf(stderr, "Cannot write \"%s\"\n", output);
+			return 2;
+		}
+	}
+	std::ostream &out = output != NULL ? file : std::cout;
+	if (strcmp(format, "json") == 0)
+	{
+		write_json(out, warmup, repetitions);
+	}
+	else
+	{
+		write_csv(out);
+	}
+	out.flush();
+
+	if (baselinePath != NULL)
+	{
+		int regressions = compare_baseline(baselinePath, threshold);
+		if (regressions != 0)
+		{
+			return regressions < 0 ? 2 : 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,54 @@
+#
+# Compiles the embedding modules to bytecode and writes them into a C++ header
+# as a table of frozen modules, for builds with PYVTK_FROZEN_MODULES:
+#
+#     python freeze.py PyVtkFrozen.h Introspector.py ClassTree.py ...
+#
+# Bytecode is only valid for the version of Python that produced it, so this
+# has to run with the interpreter the embedding links against; the header
+# records that version and PyVtk.cpp refuses to build against another one.
+#
+
+import marshal
+import os
+import sys
+
+
+def writeModule(header, name, code):
+    data = marshal.dumps(code)
+    header.write("static const unsigned char pyvtkFrozen_%s[] = {\n" % name)
+    for i in range(0, len(data), 16):
+        header.write("\t" + ", ".join(str(byte) for byte in data[i:i + 16]) + ",\n")
+    header.write("};\n\n")
+
+
+def freeze(headerFilename, sourceFilenames):
+    names = []
+    with open(headerFilename, "w") as header:
+        header.write("/* Generated by freeze.py from the embedding modules, do not edit. */\n\n")
+        header.write("#define PYVTK_FROZEN_PYTHON 0x%02x%02x\n\n" % sys.version_info[:2])
+
+        for sourceFilename in sourceFilenames:
+            name = os.path.splitext(os.path.basename(sourceFilename))[0]
+            with open(sourceFilename, "r") as fp:
+                # Tracebacks name the module file as if it had been imported.
+                code = compile(fp.read(), name + ".py", "exec")
+
+            writeModule(header, name, code)
+            names.append(name)
+
+        header.write("static const struct _frozen pyvtkFrozenModules[] = {\n")
+        for name in names:
+            header.write("\t{ \"%s\", pyvtkFrozen_%s, (int) sizeof(pyvtkFrozen_%s) },\n"
+                % (name, name, name))
+        header.write("};\n")
+
+    return len(names)
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 3:
+        print("Usage: python freeze.py HEADER MODULE.py ...")
+        sys.exit(2)
+
+    print("Froze %d modules" % freeze(sys.argv[1], sys.argv[2:]))
@@ -0,0 +1,175 @@
+#include "PyVtk.h"
+
+#include <map>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+
+
+/*
+ * Latencies of the replayed calls to one entry point.
+ */
+struct ReplayEntry
+{
+	std::vector<unsigned long long> recorded;
+	std::vector<unsigned long long> replayed;
+	size_t failures;
+};
+
+struct ReplayReport
+{
+	std::map<std::string, ReplayEntry> entries;
+	FILE *pCalls;
+};
+
+
+static void on_call(
+	void *pContext,
+	size_t index,
+	LPCSTR entry,
+	unsigned long long recorded,
+	unsigned long long replayed,
+	bool succeeded)
+{
+	ReplayReport *pReport = (ReplayReport *) pContext;
+	ReplayEntry &replayEntry = pReport->entries[entry];
+	replayEntry.recorded.push_back(recorded);
+	replayEntry.replayed.push_back(replayed);
+	if (!succeeded)
+	{
+		++replayEntry.failures;
+	}
+
+	if (pReport->pCalls != NULL)
+	{
+		fprintf(pReport->pCalls, "%zu,%s,%llu,%llu,%d\n", index, entry, recorded, replayed, succeeded ? 1 : 0);
+	}
+}
+
+
+static double median(
+	std::vector<unsigned long long> samples)
+{
+	if (samples.empty())
+	{
+		return 0.0;
+	}
+
+	std::sort(samples.begin(), samples.end());
+	size_t half = samples.size() / 2;
+	return samples.size() % 2 != 0 ? (double) samples[half] : (samples[half - 1] + samples[half]) / 2.0;
+}
+
+
+static unsigned long long total(
+	const std::vector<unsigned long long> &samples)
+{
+	unsigned long long sum = 0;
+	for (unsigned long long sample : samples)
+	{
+		sum += sample;
+	}
+	return sum;
+}
+
+
+static void usage(
+	LPCSTR program)
+{
+	fprintf(stderr,
+		"Usage: %s RECORDING [options]\n"
+		"  --original-timing   keep the recorded spacing between the calls\n"
+		"  --calls PATH        write the latency of every call to PATH as CSV\n",
+		program);
+}
+
+
+int main(int argc, char *argv[])
+{
+	LPCSTR recording = NULL;
+	LPCSTR callsPath = NULL;
+	bool originalTiming = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--original-timing") == 0)
+		{
+			originalTiming = true;
+		}
+		else if (strcmp(argv[i], "--calls") == 0 && hasValue)
+		{
+			callsPath = argv[++i];
+		}
+		else if (recording == NULL && argv[i][0] != '-')
+		{
+			recording = argv[i];
+		}
+		else
+		{
+			usage(argv[0]);
+			return 2;
+		}
+	}
+
+	if (recording == NULL)
+	{
+		usage(argv[0]);
+		return 2;
+	}
+
+	ReplayReport report;
+	report.pCalls = NULL;
+	if (callsPath != NULL)
+	{
+		report.pCalls = fopen(callsPath, "w");
+		if (report.pCalls == NULL)
+		{
+			fprintf(stderr, "Cannot write \"%s\"\n", callsPath);
+			return 2;
+		}
+		fprintf(report.pCalls, "index,entry,recorded_ns,replayed_ns,succeeded\n");
+	}
+
+	PyObject *pIntrospector = PyVtk_InitIntrospector();
+	if (pIntrospector == NULL)
+	{
+		fprintf(stderr, "Initialization failed\n");
+		return 2;
+	}
+
+	bool complete = PyVtk_ReplayRecording(pIntrospector, recording, originalTiming, on_call, &report);
+	if (!complete)
+	{
+		PyVtk_ErrorRecord error;
+		while (PyVtk_PopError(&error))
+		{
+			fprintf(stderr, "%s: %s\n", error.method, error.message);
+		}
+	}
+
+	PyVtk_FinalizeIntrospector(pIntrospector);
+	if (report.pCalls != NULL)
+	{
+		fclose(report.pCalls);
+	}
+
+	size_t failures = 0;
+	printf("%-36s %8s %14s %14s %14s %14s %8s\n", "entry", "calls", "recorded_p50", "replayed_p50", "recorded_sum", "replayed_sum", "failed");
+	for (const auto &entry : report.entries)
+	{
+		const ReplayEntry &replayEntry = entry.second;
+		printf("%-36s %8zu %14.0f %14.0f %14llu %14llu %8zu\n", entry.first.c_str(), replayEntry.recorded.size(),
+			median(replayEntry.recorded), median(replayEntry.replayed),
+			total(replayEntry.recorded), total(replayEntry.replayed), replayEntry.failures);
+		failures += replayEntry.failures;
+	}
+
+	if (!complete)
+	{
+		return 2;
+	}
+	return failures != 0 ? 1 : 0;
+}
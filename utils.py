@@ -8,7 +8,6 @@
 #
 
 import re, math
-from vtk import *
 
 def getSetMethods(methodList):
     # Get all setTo and setValue methods out of the
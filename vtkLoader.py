@@ -0,0 +1,87 @@
+#
+# Loading of the VTK classes used by the Introspector.
+#
+# By default all of VTK is imported on first use, as 'from vtk import *' did.
+# In lazy mode only the vtkmodules submodules holding the classes asked for are
+# imported, found through a map from class name to module precomputed by
+# running this file:
+#
+#     python vtkLoader.py [classModules.json]
+#
+
+import importlib
+import json
+import pkgutil
+import sys
+
+lazy = False
+classModules = {}
+
+
+def configure(lazyImports, classModulesFilename="classModules.json"):
+    # Chooses the import mode. Falls back to importing all of VTK if the map
+    # cannot be read.
+    global lazy, classModules
+
+    lazy = False
+    if not lazyImports:
+        return
+
+    try:
+        with open(classModulesFilename, "r") as fp:
+            classModules = json.load(fp)
+        lazy = True
+    except (IOError, ValueError):
+        print("Can not read class map", classModulesFilename,
+            "importing all of VTK.")
+
+
+def getClass(className):
+    # Returns the VTK class with the given name, or None if there is none.
+    if lazy and className in classModules:
+        module = importlib.import_module(classModules[className])
+    else:
+        module = importlib.import_module("vtk")
+
+    return getattr(module, className, None)
+
+
+def __getattr__(name):
+    # Allows 'from vtkLoader import vtkSomeClass'.
+    if name.startswith("vtk"):
+        classType = getClass(name)
+        if classType != None:
+            return classType
+
+    raise AttributeError("module 'vtkLoader' has no attribute '%s'" % name)
+
+
+def buildClassModules(filename="classModules.json"):
+    # Writes the map from every VTK class to the vtkmodules submodule
+    # defining it. Modules that fail to import, such as those needing a
+    # display, are left out; their classes are then imported with all of VTK.
+    import vtkmodules
+
+    mapping = {}
+    for moduleInfo in pkgutil.iter_modules(vtkmodules.__path__):
+        if not moduleInfo.name.startswith("vtk"):
+            continue
+
+        moduleName = "vtkmodules." + moduleInfo.name
+        try:
+            module = importlib.import_module(moduleName)
+        except ImportError:
+            continue
+
+        for name in dir(module):
+            if name.startswith("vtk") and name not in mapping:
+                mapping[name] = moduleName
+
+    with open(filename, "w") as fp:
+        json.dump(mapping, fp, indent=0, sort_keys=True)
+
+    return len(mapping)
+
+
+if __name__ == "__main__":
+    print("Mapped %d classes" % buildClassModules(*sys.argv[1:]))